@@ -55,6 +55,16 @@ typedef struct secp256k1_context_struct secp256k1_context;
  */
 typedef struct secp256k1_scratch_space_struct secp256k1_scratch_space;
 
+/** Opaque data structure that holds the blinding state for signing.
+ *
+ *  A signing session refers to the precomputed signing table of the context
+ *  it was created from, but has its own randomization, so that every thread
+ *  can hold a session and re-randomize it without locking or cloning the
+ *  context. Like a scratch space, a session cannot be shared between threads
+ *  without additional synchronization logic.
+ */
+typedef struct secp256k1_signing_session_struct secp256k1_signing_session;
+
 /** Opaque data structure that holds a parsed and valid public key.
  *
  *  The exact representation of data inside is implementation defined and not
@@ -161,12 +171,16 @@ typedef int (*secp256k1_nonce_function)(
 /** The higher bits contain the actual data. Do not use directly. */
 #define SECP256K1_FLAGS_BIT_CONTEXT_VERIFY (1 << 8)
 #define SECP256K1_FLAGS_BIT_CONTEXT_SIGN (1 << 9)
+#define SECP256K1_FLAGS_BIT_CONTEXT_LAZY (1 << 10)
 #define SECP256K1_FLAGS_BIT_COMPRESSION (1 << 8)
 
 /** Flags to pass to secp256k1_context_create. */
 #define SECP256K1_CONTEXT_VERIFY (SECP256K1_FLAGS_TYPE_CONTEXT | SECP256K1_FLAGS_BIT_CONTEXT_VERIFY)
 #define SECP256K1_CONTEXT_SIGN (SECP256K1_FLAGS_TYPE_CONTEXT | SECP256K1_FLAGS_BIT_CONTEXT_SIGN)
 #define SECP256K1_CONTEXT_NONE (SECP256K1_FLAGS_TYPE_CONTEXT)
+/** Combine with SECP256K1_CONTEXT_SIGN and/or SECP256K1_CONTEXT_VERIFY to
+ *  build the corresponding tables on first use instead of on creation. */
+#define SECP256K1_CONTEXT_LAZY (SECP256K1_FLAGS_TYPE_CONTEXT | SECP256K1_FLAGS_BIT_CONTEXT_LAZY)
 
 /** Flag to pass to secp256k1_ec_pubkey_serialize and secp256k1_ec_privkey_export. */
 #define SECP256K1_EC_COMPRESSED (SECP256K1_FLAGS_TYPE_COMPRESSION | SECP256K1_FLAGS_BIT_COMPRESSION)
@@ -191,6 +205,13 @@ SECP256K1_API extern const secp256k1_context *secp256k1_context_no_precomp;
  *  Returns: a newly created context object.
  *  In:      flags: which parts of the context to initialize.
  *
+ *  With SECP256K1_CONTEXT_LAZY, the signing and verification tables are only
+ *  built when a function first needs them, so that callers pay only for the
+ *  parts they use. This is thread-safe: if several threads need the same
+ *  tables at once, one of them builds them while the others wait.
+ *  secp256k1_context_randomize builds the signing tables. Compilers without
+ *  atomic operations build all tables on creation.
+ *
  *  See also secp256k1_context_randomize.
  */
 SECP256K1_API secp256k1_context* secp256k1_context_create(
@@ -215,6 +236,63 @@ SECP256K1_API void secp256k1_context_destroy(
     secp256k1_context* ctx
 );
 
+/** Compute the size of the serialized precomputed tables of a context.
+ *
+ *  Returns: the number of bytes secp256k1_context_tables_serialize writes for
+ *           this context.
+ *  Args:    ctx: an existing context object (cannot be NULL)
+ */
+SECP256K1_API size_t secp256k1_context_tables_size(
+    const secp256k1_context* ctx
+) SECP256K1_ARG_NONNULL(1);
+
+/** Serialize the precomputed tables of a context.
+ *
+ *  Returns: 1 if the tables were written, 0 if outputlen is too small.
+ *  Args:    ctx:       an existing context object (cannot be NULL)
+ *  Out:     output:    pointer to an array to receive the tables (cannot be NULL)
+ *  In:      outputlen: length of output, at least secp256k1_context_tables_size(ctx)
+ *
+ *  The output consists of a versioned header, which records how the library
+ *  was configured and a checksum, followed by the signing and verification
+ *  tables the context holds. It is meant to be written to a file once and
+ *  passed to secp256k1_context_create_from_tables later, and is only
+ *  accepted by a library built with the same configuration on a platform
+ *  with the same byte order.
+ */
+SECP256K1_API int secp256k1_context_tables_serialize(
+    const secp256k1_context* ctx,
+    unsigned char *output,
+    size_t outputlen
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Create a secp256k1 context object that uses serialized precomputed tables.
+ *
+ *  Returns: a newly created context object, or NULL if the tables are invalid,
+ *           were serialized by a differently configured library or do not
+ *           contain the parts requested by flags.
+ *  In:      flags:     which parts of the context to initialize.
+ *           tables:    pointer to tables written by
+ *                      secp256k1_context_tables_serialize, aligned to 16 bytes
+ *                      (cannot be NULL)
+ *           tableslen: length of tables
+ *
+ *  The tables are not copied: the context and all of its clones read them in
+ *  place, so they must stay valid and unmodified until the last of these
+ *  contexts is destroyed. This allows many processes to map the same file
+ *  read-only (e.g. with mmap and PROT_READ) and share a single copy of the
+ *  tables, without computing them at startup. The header checksum detects
+ *  truncated or corrupted files, but not deliberate modifications, so the
+ *  file must be as trusted as the library itself.
+ *
+ *  See also secp256k1_context_randomize.
+ */
+SECP256K1_API secp256k1_context* secp256k1_context_create_from_tables(
+    unsigned int flags,
+    const unsigned char *tables,
+    size_t tableslen
+) SECP256K1_ARG_NONNULL(2) SECP256K1_WARN_UNUSED_RESULT;
+
 /** Set a callback function to be called when an illegal argument is passed to
  *  an API call. It will only trigger for violations that are mentioned
  *  explicitly in the header.
@@ -508,6 +586,41 @@ SECP256K1_API int secp256k1_ecdsa_sign(
     const void *ndata
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Create a batch of ECDSA signatures.
+ *
+ *  Returns: 1: all signatures created
+ *           0: for at least one signature the nonce generation function failed or the
+ *              private key was invalid, or the scratch space is too small to hold a
+ *              single signature
+ *  Args:    ctx:        pointer to a context object, initialized for signing (cannot be NULL)
+ *           scratch:    scratch space for the intermediate values (cannot be NULL)
+ *  Out:     signatures: pointer to an array of n signatures; signatures[i] is set to the
+ *                       signature of msgs32[i] with seckeys[i], or cleared if it could not
+ *                       be created (cannot be NULL if n > 0)
+ *  In:      msgs32:     array of n pointers to 32-byte message hashes (cannot be NULL if n > 0)
+ *           seckeys:    array of n pointers to 32-byte secret keys (cannot be NULL if n > 0)
+ *           n:          number of signatures
+ *           noncefp:    pointer to a nonce generation function. If NULL, secp256k1_nonce_function_default is used
+ *           ndata:      pointer to arbitrary data used by the nonce generation function for
+ *                       every signature (can be NULL)
+ *
+ * Every signature is identical to the one secp256k1_ecdsa_sign would create
+ * for the same input. The nonce inversions and the conversions of the nonce
+ * points to affine coordinates are each done with a single constant-time
+ * inversion for all signatures that fit in the scratch space. Secret values
+ * are cleared from the scratch space before returning.
+ */
+SECP256K1_API int secp256k1_ecdsa_sign_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_ecdsa_signature *signatures,
+    const unsigned char * const *msgs32,
+    const unsigned char * const *seckeys,
+    size_t n,
+    secp256k1_nonce_function noncefp,
+    const void *ndata
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 /** Verify an ECDSA secret key.
  *
  *  Returns: 1: secret key is valid
@@ -534,6 +647,31 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create(
     const unsigned char *seckey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
+/** Compute the public keys for a batch of secret keys.
+ *
+ *  Returns: 1: all secret keys were valid
+ *           0: at least one secret key was invalid, or the scratch space is too
+ *              small to hold a single key
+ *  Args:    ctx:     pointer to a context object, initialized for signing (cannot be NULL)
+ *           scratch: scratch space for the intermediate values (cannot be NULL)
+ *  Out:     pubkeys: pointer to an array of n public keys; pubkeys[i] is set to the
+ *                    public key of seckeys[i], or cleared if that key is invalid
+ *                    (cannot be NULL if n > 0)
+ *  In:      seckeys: array of n pointers to 32-byte secret keys (cannot be NULL if n > 0)
+ *           n:       number of keys
+ *
+ * Every public key is the one secp256k1_ec_pubkey_create would compute. The
+ * conversion of the results to affine coordinates is done with a single
+ * constant-time inversion for all keys that fit in the scratch space.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *pubkeys,
+    const unsigned char * const *seckeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 /** Negates a private key in place.
  *
  *  Returns: 1 always
@@ -643,6 +781,87 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_context_randomize(
     const unsigned char *seed32
 ) SECP256K1_ARG_NONNULL(1);
 
+/** Create a signing session.
+ *
+ *  Returns: a newly created signing session, or NULL if ctx was not
+ *           initialized for signing.
+ *  Args:    ctx:    an existing context object, initialized for signing
+ *                   (cannot be NULL)
+ *  In:      seed32: pointer to a 32-byte random seed, combined into the
+ *                   randomization copied from ctx (can be NULL)
+ *
+ *  The session shares the signing table of ctx, which stays valid even if
+ *  ctx is destroyed first, unless the table was passed to
+ *  secp256k1_context_create_from_tables. Creating a session does not modify
+ *  ctx, so sessions can be created concurrently from a shared context.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_signing_session* secp256k1_signing_session_create(
+    const secp256k1_context* ctx,
+    const unsigned char *seed32
+) SECP256K1_ARG_NONNULL(1);
+
+/** Destroy a signing session.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:   session: session to destroy
+ */
+SECP256K1_API void secp256k1_signing_session_destroy(
+    secp256k1_signing_session* session
+);
+
+/** Updates the randomization of a signing session, as
+ *  secp256k1_context_randomize does for a context.
+ *
+ *  Returns: 1: randomization successfully updated
+ *  Args:    session: pointer to a signing session (cannot be NULL)
+ *  In:      seed32:  pointer to a 32-byte random seed (NULL resets to initial state)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_signing_session_randomize(
+    secp256k1_signing_session* session,
+    const unsigned char *seed32
+) SECP256K1_ARG_NONNULL(1);
+
+/** Create an ECDSA signature using the randomization of a signing session.
+ *
+ *  Returns: 1: signature created
+ *           0: the nonce generation function failed, or the private key was invalid.
+ *  Args:    ctx:     pointer to a context object (cannot be NULL)
+ *           session: pointer to a signing session (cannot be NULL)
+ *  Out:     sig:     pointer to an array where the signature will be placed (cannot be NULL)
+ *  In:      msg32:   the 32-byte message hash being signed (cannot be NULL)
+ *           seckey:  pointer to a 32-byte secret key (cannot be NULL)
+ *           noncefp: pointer to a nonce generation function. If NULL, secp256k1_nonce_function_default is used
+ *           ndata:   pointer to arbitrary data used by the nonce generation function (can be NULL)
+ *
+ *  The signature is the same as the one created by secp256k1_ecdsa_sign.
+ */
+SECP256K1_API int secp256k1_ecdsa_sign_with_session(
+    const secp256k1_context* ctx,
+    secp256k1_signing_session *session,
+    secp256k1_ecdsa_signature *sig,
+    const unsigned char *msg32,
+    const unsigned char *seckey,
+    secp256k1_nonce_function noncefp,
+    const void *ndata
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5);
+
+/** Compute the public key for a secret key using the randomization of a
+ *  signing session.
+ *
+ *  Returns: 1: secret was valid, public key stores
+ *           0: secret was invalid, try again
+ *  Args:    ctx:     pointer to a context object (cannot be NULL)
+ *           session: pointer to a signing session (cannot be NULL)
+ *  Out:     pubkey:  pointer to the created public key (cannot be NULL)
+ *  In:      seckey:  pointer to a 32-byte private key (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ec_pubkey_create_with_session(
+    const secp256k1_context* ctx,
+    secp256k1_signing_session *session,
+    secp256k1_pubkey *pubkey,
+    const unsigned char *seckey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
 /** Add a number of public keys together.
  *  Returns: 1: the sum of the public keys is valid.
  *           0: the sum of the public keys is not valid.
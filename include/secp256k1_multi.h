@@ -0,0 +1,318 @@
+#ifndef SECP256K1_MULTI_H
+#define SECP256K1_MULTI_H
+
+#include "secp256k1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Compute a linear combination of public keys: g_scalar*G + sum(scalars[i]*pubkeys[i]).
+ *
+ *  Returns: 1: the result was computed and is a valid public key
+ *           0: a scalar overflowed, a public key was invalid, the result is
+ *              the point at infinity, or the scratch space is too small to
+ *              hold even a single point
+ *  Args:    ctx:       pointer to a context object, initialized for verification (cannot be NULL)
+ *           scratch:   scratch space to use for the multiplication (can be NULL,
+ *                      in which case a slower algorithm without precomputation
+ *                      is used)
+ *  Out:     result:    pointer to a public key object for the result (cannot be NULL)
+ *  In:      g_scalar32: pointer to a 32-byte scalar to multiply the generator with
+ *                      (can be NULL, in which case G is not added)
+ *           pubkeys:   array of n pointers to public keys (cannot be NULL if n > 0)
+ *           scalars32: array of n pointers to 32-byte scalars (cannot be NULL if n > 0)
+ *           n:         number of public keys
+ *
+ *  The algorithm (Strauss or Pippenger) is chosen based on n and the size of
+ *  the scratch space. The scratch space must not be in use by anything else
+ *  for the duration of the call; when it returns, all memory the function
+ *  took from it has been released again. The function never uses more than
+ *  the maximum size the scratch space was created with. If the points do not
+ *  all fit, they are processed in several batches, which is slower than a
+ *  single batch. See secp256k1_ecmult_multi_scratch_size for how large a
+ *  scratch space should be to avoid that.
+ *
+ *  This is a variable time function; do not use it with secret scalars.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    const secp256k1_pubkey * const *pubkeys,
+    const unsigned char * const *scalars32,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3);
+
+/** Compute the scratch space size needed by secp256k1_ecmult_multi.
+ *
+ *  Returns: the maximum size to pass to secp256k1_scratch_space_create so
+ *           that secp256k1_ecmult_multi can process n public keys in a
+ *           single batch with the fastest algorithm available for n.
+ *  In:      n: the number of public keys
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_scratch_size(
+    size_t n
+);
+
+/** A pointer to a function that runs a number of tasks, typically on a pool of
+ *  threads.
+ *
+ *  Returns: 1 if task(task_data, i) was called for every 0 <= i < n_tasks and
+ *           all of these calls have returned. 0 will cause the
+ *           multiplication to fail.
+ *  In:      task:      the function to run (will not be NULL). Calls with
+ *                      different i may run concurrently.
+ *           task_data: pointer to pass to task.
+ *           n_tasks:   the number of tasks.
+ *           data:      Arbitrary data pointer that is passed through.
+ */
+typedef int (*secp256k1_parallel_function)(
+    void (*task)(void *task_data, size_t i),
+    void *task_data,
+    size_t n_tasks,
+    void *data
+);
+
+/** Compute a linear combination of public keys like secp256k1_ecmult_multi,
+ *  using several threads for large inputs.
+ *
+ *  Returns: same as secp256k1_ecmult_multi, and 0 if parallel returned 0.
+ *  Args:    ctx, scratch, result, g_scalar32, pubkeys, scalars32, n:
+ *                       same as for secp256k1_ecmult_multi
+ *  In:      parallel:   function used to run the tasks (cannot be NULL)
+ *           parallel_data: arbitrary data pointer passed to parallel
+ *           n_threads:  the number of tasks to split the work into, normally
+ *                       the number of threads available to parallel. 0 and
+ *                       1 make this function equivalent to
+ *                       secp256k1_ecmult_multi.
+ *
+ *  If the public keys fit into a single batch, the work of the Pippenger
+ *  algorithm, which is used for large n, is split between the tasks. Every
+ *  task needs its own set of buckets, so for the same n the scratch space has
+ *  to be larger than for secp256k1_ecmult_multi; see
+ *  secp256k1_ecmult_multi_parallel_scratch_size. If several batches are
+ *  needed, the scratch space is split evenly between the tasks instead and
+ *  each task processes its own batches. The library itself never creates
+ *  threads.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi_parallel(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    const secp256k1_pubkey * const *pubkeys,
+    const unsigned char * const *scalars32,
+    size_t n,
+    secp256k1_parallel_function parallel,
+    void *parallel_data,
+    size_t n_threads
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(8);
+
+/** Compute the scratch space size needed by secp256k1_ecmult_multi_parallel.
+ *
+ *  Returns: the maximum size to pass to secp256k1_scratch_space_create so
+ *           that secp256k1_ecmult_multi_parallel can process n public keys
+ *           with n_threads tasks in a single batch.
+ *  In:      n:         the number of public keys
+ *           n_threads: the number of tasks
+ */
+SECP256K1_API size_t secp256k1_ecmult_multi_parallel_scratch_size(
+    size_t n,
+    size_t n_threads
+);
+
+/** A pointer to a function that returns the terms of a linear combination.
+ *
+ *  Returns: 1 if the term was returned. 0 will cause the computation to fail.
+ *  Out:     scalar32: pointer to a 32-byte array for the scalar of term idx
+ *           pubkey:   pointer to a public key object for the point of term idx
+ *  In:      idx:      the index of the term
+ *           data:     arbitrary data pointer that is passed through
+ */
+typedef int (*secp256k1_ecmult_multi_term_function)(
+    unsigned char *scalar32,
+    secp256k1_pubkey *pubkey,
+    size_t idx,
+    void *data
+);
+
+/** Compute a linear combination of public keys like secp256k1_ecmult_multi,
+ *  fetching the terms from a function in chunks instead of an array.
+ *
+ *  Returns: same as secp256k1_ecmult_multi, and 0 if terms or parallel
+ *           returned 0 or the scratch space is too small.
+ *  Args:    ctx, scratch, result, g_scalar32: same as for secp256k1_ecmult_multi,
+ *                       except that scratch cannot be NULL.
+ *  In:      terms:      function that returns the scalars and public keys (cannot be NULL)
+ *           terms_data: arbitrary data pointer passed to terms
+ *           n:          number of terms
+ *           parallel:   function used to run tasks as for
+ *                       secp256k1_ecmult_multi_parallel (can be NULL)
+ *           parallel_data: arbitrary data pointer passed to parallel
+ *           n_threads:  the number of tasks to split the work into
+ *
+ *  The memory used never exceeds the scratch space, however large n is, and
+ *  the terms are never processed in separate batches: up to half of the
+ *  scratch space holds the buckets of Pippenger's algorithm for all windows
+ *  at once (a few MiB suffice for the largest windows), the rest holds the
+ *  terms while they are being added to them. terms is called once for every
+ *  index, in increasing order and never concurrently. If parallel is not
+ *  NULL and n_threads > 1 however, it may be called from any of the tasks,
+ *  because the next chunk of terms is fetched while the previous one is being
+ *  processed.
+ *
+ *  This is a variable time function; do not use it with secret scalars.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecmult_multi_stream(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    secp256k1_pubkey *result,
+    const unsigned char *g_scalar32,
+    secp256k1_ecmult_multi_term_function terms,
+    void *terms_data,
+    size_t n,
+    secp256k1_parallel_function parallel,
+    void *parallel_data,
+    size_t n_threads
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(5);
+
+/** Opaque data structure that holds precomputed multiples of a public key.
+ *
+ *  It allows multiplying that public key with many different scalars about as
+ *  fast as the generator is multiplied in signature verification. A table
+ *  uses as much memory as the generator tables of a verification context
+ *  (about 1 MiB) and is only worth building for keys that are multiplied
+ *  many times.
+ */
+typedef struct secp256k1_fixed_base_table_struct secp256k1_fixed_base_table;
+
+/** Precompute the multiples of a public key.
+ *
+ *  Returns: a newly created table, or NULL if the public key is invalid.
+ *  Args:    ctx:    an existing context object (cannot be NULL)
+ *  In:      pubkey: pointer to the public key (cannot be NULL)
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_fixed_base_table* secp256k1_fixed_base_table_create(
+    const secp256k1_context* ctx,
+    const secp256k1_pubkey *pubkey
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Destroy a table created by secp256k1_fixed_base_table_create.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:   table: table to destroy (can be NULL, in which case nothing happens)
+ */
+SECP256K1_API void secp256k1_fixed_base_table_destroy(
+    secp256k1_fixed_base_table *table
+);
+
+/** Compute scalar*P + g_scalar*G, where P is the public key a table was created for.
+ *
+ *  Returns: 1: the result was computed and is a valid public key
+ *           0: a scalar overflowed or the result is the point at infinity
+ *  Args:    ctx:        pointer to a context object (cannot be NULL). If
+ *                       g_scalar32 is not NULL it must be initialized for
+ *                       verification.
+ *  Out:     result:     pointer to a public key object for the result (cannot be NULL)
+ *  In:      table:      table created for P (cannot be NULL)
+ *           scalar32:   pointer to a 32-byte scalar to multiply P with (cannot be NULL)
+ *           g_scalar32: pointer to a 32-byte scalar to multiply the generator with
+ *                       (can be NULL, in which case G is not added)
+ *
+ *  This is a variable time function; do not use it with secret scalars.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_fixed_base_mul(
+    const secp256k1_context* ctx,
+    secp256k1_pubkey *result,
+    const secp256k1_fixed_base_table *table,
+    const unsigned char *scalar32,
+    const unsigned char *g_scalar32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Opaque data structure that accumulates equations of the form
+ *  b*G + sum(a_i*P_i) = 0 so that all of them can be checked at once.
+ *
+ *  Every equation is multiplied by a random weight and the weighted terms of
+ *  all equations are merged into as few multi-multiplications as the scratch
+ *  space allows. The weight of an equation is derived from a hash of the
+ *  optional auxiliary randomness and all terms added up to and including that
+ *  equation, so that whoever chooses the equations cannot predict it.
+ */
+typedef struct secp256k1_batch_struct secp256k1_batch;
+
+/** Create a batch of equations in a scratch space.
+ *
+ *  Returns: a newly created batch, or NULL if the scratch space is too small.
+ *  Args:    ctx:        pointer to a context object, initialized for verification (cannot be NULL)
+ *           scratch:    scratch space that holds the batch and is used for the
+ *                       multi-multiplications (cannot be NULL)
+ *  In:      aux_rand32: 32 bytes of fresh randomness to derive the weights
+ *                       from (can be NULL)
+ *
+ *  The batch and the terms added to it live in the scratch space, which must
+ *  not be used for anything else until secp256k1_batch_destroy is called. Up
+ *  to half of the scratch space holds the terms; whenever it is full, the
+ *  terms added so far are summed up with a multi-multiplication in the other
+ *  half, so a larger scratch space results in fewer, larger and therefore
+ *  faster multi-multiplications.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT secp256k1_batch* secp256k1_batch_create(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *aux_rand32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Destroy a batch and release its memory in the scratch space.
+ *
+ *  The pointer may not be used afterwards.
+ *  Args:   batch: batch to destroy (can be NULL, in which case nothing happens)
+ */
+SECP256K1_API void secp256k1_batch_destroy(
+    secp256k1_batch *batch
+);
+
+/** Add the equation g_scalar*G + sum(scalars[i]*pubkeys[i]) = 0 to a batch.
+ *
+ *  Returns: 1: the equation was added
+ *           0: a scalar overflowed or a public key was invalid. The batch as a
+ *              whole will then fail to verify.
+ *  Args:    ctx:        pointer to a context object, initialized for verification (cannot be NULL)
+ *           batch:      batch to add the equation to (cannot be NULL)
+ *  In:      g_scalar32: pointer to the 32-byte scalar of the generator (can be NULL,
+ *                       in which case the equation has no G term)
+ *           pubkeys:    array of n pointers to public keys (cannot be NULL if n > 0)
+ *           scalars32:  array of n pointers to 32-byte scalars (cannot be NULL if n > 0)
+ *           n:          number of public keys
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_batch_add(
+    const secp256k1_context* ctx,
+    secp256k1_batch *batch,
+    const unsigned char *g_scalar32,
+    const secp256k1_pubkey * const *pubkeys,
+    const unsigned char * const *scalars32,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Check all equations added to a batch.
+ *
+ *  Returns: 1: all equations hold (up to a negligible probability of error)
+ *           0: at least one equation does not hold or could not be added
+ *  Args:    ctx:   pointer to a context object, initialized for verification (cannot be NULL)
+ *           batch: the batch to check (cannot be NULL)
+ *
+ *  Afterwards the batch is empty again and can be reused for new equations.
+ *  A batch without equations verifies. This is a variable time function; do
+ *  not use it with secret scalars.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_batch_verify(
+    const secp256k1_context* ctx,
+    secp256k1_batch *batch
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECP256K1_MULTI_H */
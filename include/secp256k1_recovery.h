@@ -103,6 +103,71 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_recover(
     const unsigned char *msg32
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/** Verify a batch of recoverable ECDSA signatures against known public keys.
+ *
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect or unparseable, or the
+ *              scratch space is too small to hold a single signature
+ *  Args:    ctx:     pointer to a context object, initialized for verification (cannot be NULL)
+ *           scratch: scratch space used for the multi-multiplication (cannot be NULL)
+ *  Out:     results: pointer to an array of n integers; results[i] is set to 1 if
+ *                    signature i is correct and to 0 otherwise. If NULL, the
+ *                    function returns as soon as the batch is known to be invalid.
+ *  In:      sigs:    array of n pointers to signatures (cannot be NULL if n > 0)
+ *           msgs32:  array of n pointers to 32-byte message hashes (cannot be NULL if n > 0)
+ *           pubkeys: array of n pointers to public keys (cannot be NULL if n > 0)
+ *           n:       number of signatures to verify
+ *
+ * A signature is accepted iff secp256k1_ecdsa_verify would accept its
+ * converted form and its recovery id identifies the nonce point R, which is
+ * always the case for signatures created by secp256k1_ecdsa_sign_recoverable.
+ * The recovery id is what makes batching possible: it fixes R, so that all
+ * equations s*R = m*G + r*P can be combined with random weights into a single
+ * multi-multiplication. If that check fails and results is not NULL, the set
+ * is bisected to find the incorrect signatures.
+ *
+ * As with secp256k1_ecdsa_verify, only signatures in lower-S form are accepted.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_verify_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    int *results,
+    const secp256k1_ecdsa_recoverable_signature * const *sigs,
+    const unsigned char * const *msgs32,
+    const secp256k1_pubkey * const *pubkeys,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
+/** Recover the ECDSA public keys from a batch of signatures.
+ *
+ *  Returns: 1: all public keys were recovered
+ *           0: at least one public key could not be recovered, or the scratch
+ *              space is too small to hold a single signature
+ *  Args:    ctx:     pointer to a context object, initialized for verification (cannot be NULL)
+ *           scratch: scratch space for the intermediate values (cannot be NULL)
+ *  Out:     results: pointer to an array of n integers; results[i] is set to 1 if
+ *                    public key i was recovered and to 0 otherwise (can be NULL)
+ *           pubkeys: pointer to an array of n public keys; pubkeys[i] is set to the
+ *                    key recovered from signature i, or cleared if recovery failed
+ *                    (cannot be NULL if n > 0)
+ *  In:      sigs:    array of n pointers to signatures (cannot be NULL if n > 0)
+ *           msgs32:  array of n pointers to 32-byte message hashes (cannot be NULL if n > 0)
+ *           n:       number of signatures
+ *
+ * Every key is the one secp256k1_ecdsa_recover would return for the same
+ * input, but the inversion of r and the conversion of the result to affine
+ * coordinates are shared across all signatures that fit in the scratch space.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_ecdsa_recover_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    int *results,
+    secp256k1_pubkey *pubkeys,
+    const secp256k1_ecdsa_recoverable_signature * const *sigs,
+    const unsigned char * const *msgs32,
+    size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 #ifdef __cplusplus
 }
 #endif
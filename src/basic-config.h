@@ -13,20 +13,18 @@
 #undef USE_ENDOMORPHISM
 #undef USE_FIELD_10X26
 #undef USE_FIELD_5X52
-#undef USE_FIELD_INV_BUILTIN
-#undef USE_FIELD_INV_NUM
 #undef USE_NUM_GMP
 #undef USE_NUM_NONE
 #undef USE_SCALAR_4X64
 #undef USE_SCALAR_8X32
-#undef USE_SCALAR_INV_BUILTIN
-#undef USE_SCALAR_INV_NUM
 
 #define USE_NUM_NONE 1
-#define USE_FIELD_INV_BUILTIN 1
-#define USE_SCALAR_INV_BUILTIN 1
 #define USE_FIELD_10X26 1
 #define USE_SCALAR_8X32 1
+#ifdef USE_ECMULT_GEN_GLV
+/* The signing table for the GLV split has its own layout, see ecmult_gen.h. */
+#define USE_ENDOMORPHISM 1
+#endif
 
 #endif /* USE_BASIC_CONFIG */
 
@@ -19,6 +19,55 @@
 
 #define POINTS 32768
 #define ITERS 10000
+#define MAX_THREADS 64
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+typedef struct {
+    secp256k1_ecmult_parallel_task *task;
+    void *task_data;
+    size_t idx;
+} bench_thread_data;
+
+static void *bench_thread(void *arg) {
+    bench_thread_data *thread_data = (bench_thread_data *)arg;
+    thread_data->task(thread_data->task_data, thread_data->idx);
+    return NULL;
+}
+
+/* Runs the first task on the calling thread and starts a new thread for each
+ * of the others. Creating the threads on every call is good enough for the
+ * large multiplications benchmarked here. */
+static int bench_parallel(secp256k1_ecmult_parallel_task *task, void *task_data, size_t n_tasks, void *data) {
+    pthread_t threads[MAX_THREADS];
+    bench_thread_data thread_data[MAX_THREADS];
+    size_t i;
+    int ret = 1;
+
+    (void)data;
+    if (n_tasks > MAX_THREADS) {
+        return 0;
+    }
+    for (i = 1; i < n_tasks; i++) {
+        thread_data[i].task = task;
+        thread_data[i].task_data = task_data;
+        thread_data[i].idx = i;
+        if (pthread_create(&threads[i], NULL, bench_thread, &thread_data[i]) != 0) {
+            n_tasks = i;
+            ret = 0;
+            break;
+        }
+    }
+    if (ret) {
+        task(task_data, 0);
+    }
+    for (i = 1; i < n_tasks; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return ret;
+}
+#endif
 
 typedef struct {
     /* Setup once in advance */
@@ -29,6 +78,10 @@ typedef struct {
     secp256k1_scalar* seckeys;
     secp256k1_gej* expected_output;
     secp256k1_ecmult_multi_func ecmult_multi;
+    /* Used instead of ecmult_multi if par.n_threads is nonzero */
+    secp256k1_ecmult_parallel par;
+    /* Use ecmult_multi_stream (with par if par.n_threads is nonzero) if set */
+    int stream;
 
     /* Changes per test */
     size_t count;
@@ -55,6 +108,15 @@ static int bench_callback(secp256k1_scalar* sc, secp256k1_ge* ge, size_t idx, vo
     return 1;
 }
 
+/* The bucket window bench_pippenger_window uses */
+static int tune_bucket_window;
+
+/* Wrapper for secp256k1_ecmult_multi_func interface running pippenger with
+ * tune_bucket_window */
+static int bench_pippenger_window(const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    return secp256k1_ecmult_pippenger_batch_window(actx, scratch, r, inp_g_sc, cb, cbdata, n, 0, tune_bucket_window, NULL);
+}
+
 static void bench_ecmult(void* arg) {
     bench_data* data = (bench_data*)arg;
 
@@ -64,7 +126,13 @@ static void bench_ecmult(void* arg) {
     size_t iter;
 
     for (iter = 0; iter < iters; ++iter) {
-        data->ecmult_multi(&data->ctx->ecmult_ctx, data->scratch, &data->output[iter], data->includes_g ? &data->scalars[data->offset1] : NULL, bench_callback, arg, count - includes_g);
+        if (data->stream) {
+            secp256k1_ecmult_multi_stream_var(&data->ctx->ecmult_ctx, data->scratch, &data->output[iter], data->includes_g ? &data->scalars[data->offset1] : NULL, bench_callback, arg, count - includes_g, data->par.n_threads > 0 ? &data->par : NULL);
+        } else if (data->par.n_threads > 0) {
+            secp256k1_ecmult_multi_parallel_var(&data->ctx->ecmult_ctx, data->scratch, &data->output[iter], data->includes_g ? &data->scalars[data->offset1] : NULL, bench_callback, arg, count - includes_g, &data->par);
+        } else {
+            data->ecmult_multi(&data->ctx->ecmult_ctx, data->scratch, &data->output[iter], data->includes_g ? &data->scalars[data->offset1] : NULL, bench_callback, arg, count - includes_g);
+        }
         data->offset1 = (data->offset1 + count) % POINTS;
         data->offset2 = (data->offset2 + count - 1) % POINTS;
     }
@@ -104,8 +172,8 @@ static void generate_scalar(uint32_t num, secp256k1_scalar* scalar) {
     CHECK(!overflow);
 }
 
-static void run_test(bench_data* data, size_t count, int includes_g) {
-    char str[32];
+/* Computes the expected results of benchmarking count points. */
+static void bench_prepare(bench_data* data, size_t count, int includes_g) {
     static const secp256k1_scalar zero = SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0);
     size_t iters = 1 + ITERS / count;
     size_t iter;
@@ -127,15 +195,153 @@ static void run_test(bench_data* data, size_t count, int includes_g) {
         secp256k1_scalar_negate(&total, &total);
         secp256k1_ecmult(&data->ctx->ecmult_ctx, &data->expected_output[iter], NULL, &zero, &total);
     }
+}
+
+static void run_test(bench_data* data, size_t count, int includes_g) {
+    char str[64];
+
+    bench_prepare(data, count, includes_g);
 
     /* Run the benchmark. */
-    sprintf(str, includes_g ? "ecmult_%ig" : "ecmult_%i", (int)count);
+    if (data->stream && data->par.n_threads > 0) {
+        sprintf(str, includes_g ? "ecmult_%ig_stream_%ithreads" : "ecmult_%i_stream_%ithreads", (int)count, (int)data->par.n_threads);
+    } else if (data->stream) {
+        sprintf(str, includes_g ? "ecmult_%ig_stream" : "ecmult_%i_stream", (int)count);
+    } else if (data->par.n_threads > 0) {
+        sprintf(str, includes_g ? "ecmult_%ig_%ithreads" : "ecmult_%i_%ithreads", (int)count, (int)data->par.n_threads);
+    } else {
+        sprintf(str, includes_g ? "ecmult_%ig" : "ecmult_%i", (int)count);
+    }
     run_benchmark(str, bench_ecmult, bench_ecmult_setup, bench_ecmult_teardown, data, 10, count * (1 + ITERS / count));
 }
 
+/* Returns the minimum time per point of a few runs of bench_ecmult with
+ * count points including G. */
+static double tune_time(bench_data* data, size_t count) {
+    double min = HUGE_VAL;
+    int i;
+
+    bench_prepare(data, count, 1);
+    for (i = 0; i < 3; i++) {
+        double begin, total;
+        bench_ecmult_setup(data);
+        begin = gettimedouble();
+        bench_ecmult(data);
+        total = gettimedouble() - begin;
+        bench_ecmult_teardown(data);
+        if (total < min) {
+            min = total;
+        }
+    }
+    return min / (count * (1 + ITERS / count));
+}
+
+/* Measures the fastest bucket window for a growing number of points and at
+ * which number of points pippenger gets faster than strauss, and prints them
+ * as a file for configure's --with-ecmult-tuning. */
+static void run_tune(bench_data* data) {
+    size_t counts[64];
+    int best_windows[64];
+    size_t limits[PIPPENGER_MAX_BUCKET_WINDOW - 1];
+    size_t n_counts = 0;
+    size_t threshold = 0;
+    size_t pippenger_wins = 0;
+    size_t count;
+    size_t k;
+    int bucket_window = 1;
+    int max_window;
+    int w;
+
+    /* Counts include G, so they start at one point */
+    for (count = 2; count <= POINTS; count += count / 4 > 1 ? count / 4 : 1) {
+        counts[n_counts++] = count;
+    }
+    for (k = 0; k < n_counts; k++) {
+        double best = HUGE_VAL;
+        int best_window = bucket_window;
+
+        /* The best window never shrinks with more points, so only try the
+         * previous one and larger ones as long as they are faster. */
+        data->ecmult_multi = bench_pippenger_window;
+        for (w = bucket_window; w <= PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+            double t;
+            tune_bucket_window = w;
+            t = tune_time(data, counts[k]);
+            if (t < best) {
+                best = t;
+                best_window = w;
+            } else {
+                break;
+            }
+        }
+        bucket_window = best_window;
+        best_windows[k] = best_window;
+        fprintf(stderr, "%i points: bucket window %i", (int)counts[k] - 1, best_window);
+
+        /* Compare with strauss until pippenger has won a few times in a row */
+        if (pippenger_wins < 4) {
+            double t;
+            data->ecmult_multi = secp256k1_ecmult_strauss_batch_single;
+            t = tune_time(data, counts[k]);
+            if (t <= best) {
+                pippenger_wins = 0;
+                threshold = 0;
+            } else {
+                if (threshold == 0) {
+                    threshold = counts[k] - 1;
+                }
+                pippenger_wins++;
+            }
+            fprintf(stderr, ", %s is faster", t <= best ? "strauss" : "pippenger");
+        }
+        fprintf(stderr, "\n");
+    }
+    if (threshold == 0) {
+        threshold = counts[n_counts - 1];
+    }
+
+    /* The limit of a window lies between the largest number of points for
+     * which it (or a smaller one) was the best and the next number tested.
+     * Beyond the largest number of points tested the limits are extrapolated
+     * by doubling the number of points per window. */
+    max_window = best_windows[n_counts - 1];
+    for (w = 1; w < PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+        if (w >= max_window) {
+            size_t prev = w > 1 ? limits[w - 2] : 1;
+            limits[w - 1] = w == max_window && counts[n_counts - 1] - 1 > 2 * prev ? counts[n_counts - 1] - 1 : 2 * prev;
+            continue;
+        }
+        limits[w - 1] = w > 1 ? limits[w - 2] : 1;
+        for (k = 0; k + 1 < n_counts; k++) {
+            if (best_windows[k] <= w && best_windows[k + 1] > w) {
+                limits[w - 1] = (counts[k] + counts[k + 1]) / 2 - 1;
+            }
+        }
+    }
+
+    printf("/* Generated by \"bench_ecmult tune\" */\n\n");
+#ifdef USE_ENDOMORPHISM
+    printf("#ifndef USE_ENDOMORPHISM\n");
+    printf("#error \"This file was generated for a build with the endomorphism.\"\n");
+#else
+    printf("#ifdef USE_ENDOMORPHISM\n");
+    printf("#error \"This file was generated for a build without the endomorphism.\"\n");
+#endif
+    printf("#endif\n\n");
+    printf("#define ECMULT_PIPPENGER_THRESHOLD %lu\n", (unsigned long)threshold);
+    printf("#define PIPPENGER_WINDOW_LIMITS");
+    for (w = 1; w < PIPPENGER_MAX_BUCKET_WINDOW; w++) {
+        printf("%s %lu", w > 1 ? "," : "", (unsigned long)limits[w - 1]);
+    }
+    printf("\n");
+}
+
 int main(int argc, char **argv) {
     bench_data data;
     int i, p;
+    int threads = 0;
+    int tune = 0;
+    int stream = 0;
     secp256k1_gej* pubkeys_gej;
     size_t scratch_size;
 
@@ -143,6 +349,8 @@ int main(int argc, char **argv) {
     scratch_size = secp256k1_strauss_scratch_size(POINTS) + STRAUSS_SCRATCH_OBJECTS*16;
     data.scratch = secp256k1_scratch_space_create(data.ctx, scratch_size);
     data.ecmult_multi = secp256k1_ecmult_multi_var;
+    data.par.n_threads = 0;
+    data.stream = 0;
 
     if (argc > 1) {
         if(have_flag(argc, argv, "pippenger_wnaf")) {
@@ -156,9 +364,33 @@ int main(int argc, char **argv) {
             data.ecmult_multi = secp256k1_ecmult_multi_var;
             secp256k1_scratch_space_destroy(data.scratch);
             data.scratch = NULL;
+#ifdef HAVE_PTHREAD
+        } else if(have_flag(argc, argv, "threads")) {
+            printf("Using the combined algorithm with 1 to 8 threads:\n");
+            data.par.fn = bench_parallel;
+            data.par.data = NULL;
+            threads = 1;
+#endif
+        } else if(have_flag(argc, argv, "stream")) {
+            printf("Using a scratch space for %i points, in batches and streaming:\n", POINTS / 16);
+            secp256k1_scratch_space_destroy(data.scratch);
+            data.scratch = secp256k1_scratch_space_create(data.ctx, secp256k1_pippenger_scratch_size_max_points(POINTS / 16, 1));
+#ifdef HAVE_PTHREAD
+            data.par.fn = bench_parallel;
+            data.par.data = NULL;
+#endif
+            stream = 1;
+        } else if(have_flag(argc, argv, "tune")) {
+            fprintf(stderr, "Measuring the fastest pippenger bucket windows:\n");
+            tune = 1;
         } else {
             fprintf(stderr, "%s: unrecognized argument '%s'.\n", argv[0], argv[1]);
-            fprintf(stderr, "Use 'pippenger_wnaf', 'strauss_wnaf', 'simple' or no argument to benchmark a combined algorithm.\n");
+#ifdef HAVE_PTHREAD
+            fprintf(stderr, "Use 'pippenger_wnaf', 'strauss_wnaf', 'simple', 'stream', 'threads' or no argument to benchmark a combined algorithm.\n");
+#else
+            fprintf(stderr, "Use 'pippenger_wnaf', 'strauss_wnaf', 'simple', 'stream' or no argument to benchmark a combined algorithm.\n");
+#endif
+            fprintf(stderr, "Use 'tune' to print the thresholds for configure's --with-ecmult-tuning.\n");
             return 1;
         }
     }
@@ -184,13 +416,45 @@ int main(int argc, char **argv) {
     secp256k1_ge_set_all_gej_var(data.pubkeys, pubkeys_gej, POINTS);
     free(pubkeys_gej);
 
-    for (i = 1; i <= 8; ++i) {
-        run_test(&data, i, 1);
-    }
+    if (tune) {
+        run_tune(&data);
+    } else if (stream) {
+        for (p = 0; p <= 4; p += 2) {
+            data.stream = 0;
+            run_test(&data, (POINTS / 16) << p, 1);
+            data.stream = 1;
+            run_test(&data, (POINTS / 16) << p, 1);
+#ifdef HAVE_PTHREAD
+            data.par.n_threads = 4;
+            run_test(&data, (POINTS / 16) << p, 1);
+            data.par.n_threads = 0;
+#endif
+        }
+    } else if (threads) {
+        /* Scaling with the number of threads, first with all points in a
+         * single batch, then with a scratch space that only fits an eighth of
+         * the points so that several batches run concurrently. */
+        for (p = 0; p < 2; ++p) {
+            if (p == 1) {
+                printf("Using a scratch space for %i points:\n", POINTS / 8);
+                secp256k1_scratch_space_destroy(data.scratch);
+                data.scratch = secp256k1_scratch_space_create(data.ctx, secp256k1_pippenger_scratch_size_max_points(POINTS / 8, 1));
+            }
+            for (i = 1; i <= 8; i *= 2) {
+                data.par.n_threads = i;
+                run_test(&data, 4096, 1);
+                run_test(&data, POINTS, 1);
+            }
+        }
+    } else {
+        for (i = 1; i <= 8; ++i) {
+            run_test(&data, i, 1);
+        }
 
-    for (p = 0; p <= 11; ++p) {
-        for (i = 9; i <= 16; ++i) {
-            run_test(&data, i << p, 1);
+        for (p = 0; p <= 11; ++p) {
+            for (i = 9; i <= 16; ++i) {
+                run_test(&data, i << p, 1);
+            }
         }
     }
     secp256k1_context_destroy(data.ctx);
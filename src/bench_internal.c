@@ -18,6 +18,11 @@
 #include "bench.h"
 #include "secp256k1.c"
 
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+/* Not used by the library; only compared against the MULQ version. */
+#include "field_5x52_asm_mulx_impl.h"
+#endif
+
 typedef struct {
     secp256k1_scalar scalar_x, scalar_y;
     secp256k1_fe fe_x, fe_y;
@@ -25,6 +30,9 @@ typedef struct {
     secp256k1_gej gej_x, gej_y;
     unsigned char data[64];
     int wnaf[256];
+    secp256k1_context *ctx;
+    unsigned char *tables;
+    size_t tableslen;
 } bench_inv;
 
 void bench_setup(void* arg) {
@@ -161,6 +169,100 @@ void bench_field_sqr(void* arg) {
     }
 }
 
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+/* The inner multiplications of the 5x52 field, benchmarked side by side. */
+#ifdef HAVE___INT128
+void bench_field_mul_int128(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_mul_inner_int128(data->fe_x.n, data->fe_x.n, data->fe_y.n);
+    }
+}
+
+void bench_field_sqr_int128(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_sqr_inner_int128(data->fe_x.n, data->fe_x.n);
+    }
+}
+#endif
+
+void bench_field_mul_mulq(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_mul_inner_mulq(data->fe_x.n, data->fe_x.n, data->fe_y.n);
+    }
+}
+
+void bench_field_sqr_mulq(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_sqr_inner_mulq(data->fe_x.n, data->fe_x.n);
+    }
+}
+
+void bench_field_mul_mulx(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_mul_inner_mulx(data->fe_x.n, data->fe_x.n, data->fe_y.n);
+    }
+}
+
+void bench_field_sqr_mulx(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_sqr_inner_mulx(data->fe_x.n, data->fe_x.n);
+    }
+}
+#endif
+
+#ifdef SECP256K1_FIELD_X4
+/* The four-way benchmarks report the time for one operation on four elements. */
+SECP256K1_TARGET_AVX2 void bench_field_x4_mul(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_fe f[4];
+    secp256k1_fe_x4 x, y;
+
+    f[0] = f[1] = f[2] = f[3] = data->fe_x;
+    secp256k1_fe_x4_set_fe(&x, f);
+    f[0] = f[1] = f[2] = f[3] = data->fe_y;
+    secp256k1_fe_x4_set_fe(&y, f);
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_x4_mul(&x, &x, &y);
+    }
+    secp256k1_fe_x4_get_fe(f, &x);
+    data->fe_x = f[0];
+}
+
+SECP256K1_TARGET_AVX2 void bench_field_x4_sqr(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_fe f[4];
+    secp256k1_fe_x4 x;
+
+    f[0] = f[1] = f[2] = f[3] = data->fe_x;
+    secp256k1_fe_x4_set_fe(&x, f);
+    for (i = 0; i < 200000; i++) {
+        secp256k1_fe_x4_sqr(&x, &x);
+    }
+    secp256k1_fe_x4_get_fe(f, &x);
+    data->fe_x = f[0];
+}
+#endif
+
 void bench_field_inverse(void* arg) {
     int i;
     bench_inv *data = (bench_inv*)arg;
@@ -211,6 +313,28 @@ void bench_group_add_var(void* arg) {
     }
 }
 
+#ifdef SECP256K1_FIELD_X4
+SECP256K1_TARGET_AVX2 void bench_group_x4_add_affine(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_gej a[4];
+    secp256k1_ge_storage b[4];
+    secp256k1_gej_x4 ax;
+    secp256k1_ge_x4 bx;
+
+    a[0] = a[1] = a[2] = a[3] = data->gej_x;
+    secp256k1_gej_x4_set_gej(&ax, a);
+    secp256k1_ge_to_storage(&b[0], &data->ge_y);
+    b[1] = b[2] = b[3] = b[0];
+    secp256k1_ge_x4_from_storage(&bx, b);
+    for (i = 0; i < 200000; i++) {
+        secp256k1_gej_x4_add_ge(&ax, &ax, &bx);
+    }
+    secp256k1_gej_x4_get_gej(a, &ax);
+    data->gej_x = a[0];
+}
+#endif
+
 void bench_group_add_affine(void* arg) {
     int i;
     bench_inv *data = (bench_inv*)arg;
@@ -258,6 +382,60 @@ void bench_wnaf_const(void* arg) {
     }
 }
 
+void bench_ecmult_gen(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+
+    for (i = 0; i < 2000; i++) {
+        secp256k1_ecmult_gen(&data->ctx->ecmult_gen_ctx, &data->gej_x, &data->scalar_x);
+        secp256k1_scalar_add(&data->scalar_x, &data->scalar_x, &data->scalar_y);
+    }
+}
+
+void bench_ecmult_gen_batch(void* arg) {
+    int i, k;
+    bench_inv *data = (bench_inv*)arg;
+    secp256k1_scalar s[4];
+    secp256k1_gej r[4];
+
+    for (i = 0; i < 500; i++) {
+        for (k = 0; k < 4; k++) {
+            s[k] = data->scalar_x;
+            secp256k1_scalar_add(&data->scalar_x, &data->scalar_x, &data->scalar_y);
+        }
+        secp256k1_ecmult_gen_batch(&data->ctx->ecmult_gen_ctx, r, s, 4);
+    }
+    data->gej_x = r[0];
+}
+
+/* Scan every row of the signing table once per iteration, like one secp256k1_ecmult_gen. */
+static void bench_ecmult_gen_scan_with(bench_inv *data, void (*scan)(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits)) {
+    int i, j;
+    secp256k1_ge_storage r;
+
+    for (i = 0; i < 20000; i++) {
+        for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+            scan(&r, (*data->ctx->ecmult_gen_ctx.prec)[j], (i + j) & (ECMULT_GEN_PREC_G - 1));
+        }
+        data->data[i & 63] ^= ((unsigned char *)&r)[i & 63];
+    }
+}
+
+void bench_ecmult_gen_scan_cmov(void* arg) {
+    bench_ecmult_gen_scan_with((bench_inv*)arg, secp256k1_ecmult_gen_scan_cmov);
+}
+
+#ifdef SECP256K1_ECMULT_GEN_SCAN_SSE2
+void bench_ecmult_gen_scan_sse2(void* arg) {
+    bench_ecmult_gen_scan_with((bench_inv*)arg, secp256k1_ecmult_gen_scan_sse2);
+}
+#endif
+
+#ifdef SECP256K1_ECMULT_GEN_SCAN_AVX2
+void bench_ecmult_gen_scan_avx2(void* arg) {
+    bench_ecmult_gen_scan_with((bench_inv*)arg, secp256k1_ecmult_gen_scan_avx2);
+}
+#endif
 
 void bench_sha256(void* arg) {
     int i;
@@ -310,6 +488,22 @@ void bench_context_sign(void* arg) {
     }
 }
 
+void bench_context_clone(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    for (i = 0; i < 200; i++) {
+        secp256k1_context_destroy(secp256k1_context_clone(data->ctx));
+    }
+}
+
+void bench_context_tables(void* arg) {
+    int i;
+    bench_inv *data = (bench_inv*)arg;
+    for (i = 0; i < 200; i++) {
+        secp256k1_context_destroy(secp256k1_context_create_from_tables(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY, data->tables, data->tableslen));
+    }
+}
+
 #ifndef USE_NUM_NONE
 void bench_num_jacobi(void* arg) {
     int i;
@@ -328,6 +522,8 @@ void bench_num_jacobi(void* arg) {
 
 int main(int argc, char **argv) {
     bench_inv data;
+    /* The library does this on context creation. */
+    secp256k1_dispatch_init();
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "add")) run_benchmark("scalar_add", bench_scalar_add, bench_setup, NULL, &data, 10, 2000000);
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "negate")) run_benchmark("scalar_negate", bench_scalar_negate, bench_setup, NULL, &data, 10, 2000000);
     if (have_flag(argc, argv, "scalar") || have_flag(argc, argv, "sqr")) run_benchmark("scalar_sqr", bench_scalar_sqr, bench_setup, NULL, &data, 10, 200000);
@@ -342,6 +538,24 @@ int main(int argc, char **argv) {
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "normalize")) run_benchmark("field_normalize_weak", bench_field_normalize_weak, bench_setup, NULL, &data, 10, 2000000);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_sqr", bench_field_sqr, bench_setup, NULL, &data, 10, 200000);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_mul", bench_field_mul, bench_setup, NULL, &data, 10, 200000);
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+#ifdef HAVE___INT128
+    if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_sqr_int128", bench_field_sqr_int128, bench_setup, NULL, &data, 10, 200000);
+    if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_mul_int128", bench_field_mul_int128, bench_setup, NULL, &data, 10, 200000);
+#endif
+    if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_sqr_mulq", bench_field_sqr_mulq, bench_setup, NULL, &data, 10, 200000);
+    if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_mul_mulq", bench_field_mul_mulq, bench_setup, NULL, &data, 10, 200000);
+    if (secp256k1_cpu_features() & SECP256K1_CPU_BMI2_ADX) {
+        if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_sqr_mulx", bench_field_sqr_mulx, bench_setup, NULL, &data, 10, 200000);
+        if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_mul_mulx", bench_field_mul_mulx, bench_setup, NULL, &data, 10, 200000);
+    }
+#endif
+#ifdef SECP256K1_FIELD_X4
+    if (secp256k1_cpu_features() & SECP256K1_CPU_AVX2) {
+        if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqr")) run_benchmark("field_x4_sqr", bench_field_x4_sqr, bench_setup, NULL, &data, 10, 200000);
+        if (have_flag(argc, argv, "field") || have_flag(argc, argv, "mul")) run_benchmark("field_x4_mul", bench_field_x4_mul, bench_setup, NULL, &data, 10, 200000);
+    }
+#endif
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "inverse")) run_benchmark("field_inverse", bench_field_inverse, bench_setup, NULL, &data, 10, 20000);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "inverse")) run_benchmark("field_inverse_var", bench_field_inverse_var, bench_setup, NULL, &data, 10, 20000);
     if (have_flag(argc, argv, "field") || have_flag(argc, argv, "sqrt")) run_benchmark("field_sqrt", bench_field_sqrt, bench_setup, NULL, &data, 10, 20000);
@@ -349,11 +563,29 @@ int main(int argc, char **argv) {
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "double")) run_benchmark("group_double_var", bench_group_double_var, bench_setup, NULL, &data, 10, 200000);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_var", bench_group_add_var, bench_setup, NULL, &data, 10, 200000);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_affine", bench_group_add_affine, bench_setup, NULL, &data, 10, 200000);
+#ifdef SECP256K1_FIELD_X4
+    if ((secp256k1_cpu_features() & SECP256K1_CPU_AVX2) && (have_flag(argc, argv, "group") || have_flag(argc, argv, "add"))) run_benchmark("group_x4_add_affine", bench_group_x4_add_affine, bench_setup, NULL, &data, 10, 200000);
+#endif
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "add")) run_benchmark("group_add_affine_var", bench_group_add_affine_var, bench_setup, NULL, &data, 10, 200000);
     if (have_flag(argc, argv, "group") || have_flag(argc, argv, "jacobi")) run_benchmark("group_jacobi_var", bench_group_jacobi_var, bench_setup, NULL, &data, 10, 20000);
 
     if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "wnaf")) run_benchmark("wnaf_const", bench_wnaf_const, bench_setup, NULL, &data, 10, 20000);
     if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "wnaf")) run_benchmark("ecmult_wnaf", bench_ecmult_wnaf, bench_setup, NULL, &data, 10, 20000);
+    if (have_flag(argc, argv, "ecmult") || have_flag(argc, argv, "gen")) {
+        data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+        run_benchmark("ecmult_gen", bench_ecmult_gen, bench_setup, NULL, &data, 10, 2000);
+        run_benchmark("ecmult_gen_batch", bench_ecmult_gen_batch, bench_setup, NULL, &data, 10, 2000);
+        run_benchmark("ecmult_gen_scan_cmov", bench_ecmult_gen_scan_cmov, bench_setup, NULL, &data, 10, 20000);
+#ifdef SECP256K1_ECMULT_GEN_SCAN_SSE2
+        run_benchmark("ecmult_gen_scan_sse2", bench_ecmult_gen_scan_sse2, bench_setup, NULL, &data, 10, 20000);
+#endif
+#ifdef SECP256K1_ECMULT_GEN_SCAN_AVX2
+        if (secp256k1_cpu_features() & SECP256K1_CPU_AVX2) {
+            run_benchmark("ecmult_gen_scan_avx2", bench_ecmult_gen_scan_avx2, bench_setup, NULL, &data, 10, 20000);
+        }
+#endif
+        secp256k1_context_destroy(data.ctx);
+    }
 
     if (have_flag(argc, argv, "hash") || have_flag(argc, argv, "sha256")) run_benchmark("hash_sha256", bench_sha256, bench_setup, NULL, &data, 10, 20000);
     if (have_flag(argc, argv, "hash") || have_flag(argc, argv, "hmac")) run_benchmark("hash_hmac_sha256", bench_hmac_sha256, bench_setup, NULL, &data, 10, 20000);
@@ -361,6 +593,20 @@ int main(int argc, char **argv) {
 
     if (have_flag(argc, argv, "context") || have_flag(argc, argv, "verify")) run_benchmark("context_verify", bench_context_verify, bench_setup, NULL, &data, 10, 20);
     if (have_flag(argc, argv, "context") || have_flag(argc, argv, "sign")) run_benchmark("context_sign", bench_context_sign, bench_setup, NULL, &data, 10, 200);
+    if (have_flag(argc, argv, "context") || have_flag(argc, argv, "clone")) {
+        data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+        run_benchmark("context_clone", bench_context_clone, bench_setup, NULL, &data, 10, 200);
+        secp256k1_context_destroy(data.ctx);
+    }
+    if (have_flag(argc, argv, "context") || have_flag(argc, argv, "tables")) {
+        data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+        data.tableslen = secp256k1_context_tables_size(data.ctx);
+        data.tables = (unsigned char *)malloc(data.tableslen);
+        CHECK(secp256k1_context_tables_serialize(data.ctx, data.tables, data.tableslen));
+        run_benchmark("context_from_tables", bench_context_tables, bench_setup, NULL, &data, 10, 200);
+        free(data.tables);
+        secp256k1_context_destroy(data.ctx);
+    }
 
 #ifndef USE_NUM_NONE
     if (have_flag(argc, argv, "num") || have_flag(argc, argv, "jacobi")) run_benchmark("num_jacobi", bench_num_jacobi, bench_setup, NULL, &data, 10, 200000);
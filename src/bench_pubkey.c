@@ -0,0 +1,82 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#include <stdlib.h>
+
+#include "include/secp256k1.h"
+#include "util.h"
+#include "bench.h"
+
+#define MAX_BATCH 4096
+
+typedef struct {
+    secp256k1_context *ctx;
+    secp256k1_scratch_space *scratch;
+    unsigned char (*keys)[32];
+    const unsigned char **key_ptrs;
+    secp256k1_pubkey *pubkeys;
+    size_t batch_size;
+} bench_pubkey_data;
+
+static void bench_pubkey_setup(void* arg) {
+    size_t i;
+    bench_pubkey_data *data = (bench_pubkey_data*)arg;
+
+    for (i = 0; i < MAX_BATCH; i++) {
+        memset(data->keys[i], 0, 32);
+        data->keys[i][0] = 1;
+        data->keys[i][28] = i >> 24;
+        data->keys[i][29] = i >> 16;
+        data->keys[i][30] = i >> 8;
+        data->keys[i][31] = i;
+        data->key_ptrs[i] = data->keys[i];
+    }
+}
+
+static void bench_pubkey_create(void* arg) {
+    size_t i;
+    bench_pubkey_data *data = (bench_pubkey_data*)arg;
+
+    for (i = 0; i < MAX_BATCH; i++) {
+        CHECK(secp256k1_ec_pubkey_create(data->ctx, &data->pubkeys[i], data->keys[i]));
+    }
+}
+
+static void bench_pubkey_create_batch(void* arg) {
+    size_t i;
+    bench_pubkey_data *data = (bench_pubkey_data*)arg;
+
+    for (i = 0; i < MAX_BATCH; i += data->batch_size) {
+        CHECK(secp256k1_ec_pubkey_create_batch(data->ctx, data->scratch, &data->pubkeys[i], &data->key_ptrs[i], data->batch_size));
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_pubkey_data data;
+
+    data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    data.scratch = secp256k1_scratch_space_create(data.ctx, 1024 * 1024);
+    data.keys = malloc(MAX_BATCH * sizeof(*data.keys));
+    data.key_ptrs = malloc(MAX_BATCH * sizeof(*data.key_ptrs));
+    data.pubkeys = malloc(MAX_BATCH * sizeof(*data.pubkeys));
+
+    if (have_flag(argc, argv, "create")) run_benchmark("ec_pubkey_create", bench_pubkey_create, bench_pubkey_setup, NULL, &data, 10, MAX_BATCH);
+
+    if (have_flag(argc, argv, "batch")) {
+        char name[64];
+        for (data.batch_size = 1; data.batch_size <= MAX_BATCH; data.batch_size *= 2) {
+            sprintf(name, "ec_pubkey_create_batch_%i", (int)data.batch_size);
+            run_benchmark(name, bench_pubkey_create_batch, bench_pubkey_setup, NULL, &data, 10, MAX_BATCH);
+        }
+    }
+
+    free(data.keys);
+    free(data.key_ptrs);
+    free(data.pubkeys);
+    secp256k1_scratch_space_destroy(data.scratch);
+    secp256k1_context_destroy(data.ctx);
+    return 0;
+}
@@ -4,15 +4,28 @@
  * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
  **********************************************************************/
 
+#include <stdlib.h>
+
 #include "include/secp256k1.h"
 #include "include/secp256k1_recovery.h"
 #include "util.h"
 #include "bench.h"
 
+#define MAX_BATCH 4096
+
 typedef struct {
     secp256k1_context *ctx;
     unsigned char msg[32];
     unsigned char sig[64];
+
+    /* For batch recovery. */
+    secp256k1_scratch_space *scratch;
+    secp256k1_ecdsa_recoverable_signature *sigs;
+    const secp256k1_ecdsa_recoverable_signature **sig_ptrs;
+    unsigned char (*msgs)[32];
+    const unsigned char **msg_ptrs;
+    secp256k1_pubkey *pubkeys;
+    size_t batch_size;
 } bench_recover_data;
 
 void bench_recover(void* arg) {
@@ -48,12 +61,67 @@ void bench_recover_setup(void* arg) {
     }
 }
 
-int main(void) {
+void bench_recover_batch(void* arg) {
+    size_t i;
+    bench_recover_data *data = (bench_recover_data*)arg;
+
+    for (i = 0; i < MAX_BATCH; i += data->batch_size) {
+        CHECK(secp256k1_ecdsa_recover_batch(data->ctx, data->scratch, NULL, &data->pubkeys[i], &data->sig_ptrs[i], &data->msg_ptrs[i], data->batch_size));
+    }
+}
+
+void bench_recover_batch_setup(bench_recover_data *data) {
+    size_t i;
+    secp256k1_context *sign_ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+
+    data->scratch = secp256k1_scratch_space_create(data->ctx, 4 * 1024 * 1024);
+    data->sigs = malloc(MAX_BATCH * sizeof(*data->sigs));
+    data->sig_ptrs = malloc(MAX_BATCH * sizeof(*data->sig_ptrs));
+    data->msgs = malloc(MAX_BATCH * sizeof(*data->msgs));
+    data->msg_ptrs = malloc(MAX_BATCH * sizeof(*data->msg_ptrs));
+    data->pubkeys = malloc(MAX_BATCH * sizeof(*data->pubkeys));
+    for (i = 0; i < MAX_BATCH; i++) {
+        unsigned char privkey[32];
+        memset(privkey, 0, 32);
+        privkey[0] = 1;
+        privkey[28] = i >> 24;
+        privkey[29] = i >> 16;
+        privkey[30] = i >> 8;
+        privkey[31] = i;
+        memset(data->msgs[i], 0, 32);
+        memcpy(data->msgs[i], privkey + 28, 4);
+        CHECK(secp256k1_ecdsa_sign_recoverable(sign_ctx, &data->sigs[i], data->msgs[i], privkey, NULL, NULL));
+        data->sig_ptrs[i] = &data->sigs[i];
+        data->msg_ptrs[i] = data->msgs[i];
+    }
+    secp256k1_context_destroy(sign_ctx);
+}
+
+void bench_recover_batch_teardown(bench_recover_data *data) {
+    secp256k1_scratch_space_destroy(data->scratch);
+    free(data->sigs);
+    free(data->sig_ptrs);
+    free(data->msgs);
+    free(data->msg_ptrs);
+    free(data->pubkeys);
+}
+
+int main(int argc, char **argv) {
     bench_recover_data data;
 
     data.ctx = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
 
-    run_benchmark("ecdsa_recover", bench_recover, bench_recover_setup, NULL, &data, 10, 20000);
+    if (have_flag(argc, argv, "ecdsa") || have_flag(argc, argv, "recover")) run_benchmark("ecdsa_recover", bench_recover, bench_recover_setup, NULL, &data, 10, 20000);
+
+    if (have_flag(argc, argv, "batch")) {
+        char name[64];
+        bench_recover_batch_setup(&data);
+        for (data.batch_size = 1; data.batch_size <= MAX_BATCH; data.batch_size *= 2) {
+            sprintf(name, "ecdsa_recover_batch_%i", (int)data.batch_size);
+            run_benchmark(name, bench_recover_batch, NULL, NULL, &data, 3, MAX_BATCH);
+        }
+        bench_recover_batch_teardown(&data);
+    }
 
     secp256k1_context_destroy(data.ctx);
     return 0;
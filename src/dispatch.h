@@ -0,0 +1,111 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_DISPATCH_H
+#define SECP256K1_DISPATCH_H
+
+/** Runtime selection of code paths that depend on the CPU.
+ *
+ *  The representations of field elements and scalars (--with-field and
+ *  --with-scalar) and the inner field and scalar arithmetic (--with-asm) stay
+ *  compile-time choices: they determine the layout of every structure and
+ *  table, and the inner arithmetic is cheap enough that an indirect call
+ *  would cost more than the measured differences between its versions.
+ *
+ *  What is called through secp256k1_dispatch_table are coarser operations
+ *  with an implementation that needs an instruction set extension:
+ *  - the SHA-256 transform (C or the SHA extensions);
+ *  - the constant-time scan of a signing table row (SSE2 or AVX2);
+ *  - batch multiplication with the generator (one at a time, or four at a
+ *    time with the AVX2 field and group backend).
+ *  The table starts out with choices that work on every CPU of the target
+ *  architecture. secp256k1_dispatch_init, called on context creation, fills
+ *  in the best ones for the CPU it runs on, once per process. The entries are
+ *  written and read with relaxed atomic operations, so a thread may call
+ *  through the table while another one sets it up.
+ */
+
+#if defined HAVE_CONFIG_H
+#include "libsecp256k1-config.h"
+#endif
+
+#include <stdint.h>
+
+#include "util.h"
+#include "ecmult_gen.h"
+#include "field_x4.h"
+
+#ifdef SECP256K1_HAVE_ATOMICS
+#  if defined(__GNUC__) && defined(__x86_64__) && \
+      (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#    define SECP256K1_DISPATCH_SHA256 1
+#  endif
+#  ifdef SECP256K1_ECMULT_GEN_SCAN_AVX2
+#    define SECP256K1_DISPATCH_ECMULT_GEN_SCAN 1
+#  endif
+#  ifdef SECP256K1_FIELD_X4
+#    define SECP256K1_DISPATCH_ECMULT_GEN_BATCH 1
+#  endif
+#endif
+
+/* CPU features, as returned by secp256k1_cpu_features. */
+#define SECP256K1_CPU_BMI2_ADX (1U << 0)
+#define SECP256K1_CPU_SHA      (1U << 1)
+#define SECP256K1_CPU_AVX2     (1U << 2)
+
+typedef struct {
+    /** The features the current choices were made for. */
+    unsigned int features;
+#ifdef SECP256K1_DISPATCH_SHA256
+    void (*sha256_transform)(uint32_t* s, const uint32_t* chunk);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+    void (*ecmult_gen_scan)(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    void (*ecmult_gen_batch)(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn, size_t n);
+#endif
+} secp256k1_dispatch;
+
+/* The implementations the table starts out with. */
+#ifdef SECP256K1_DISPATCH_SHA256
+static void secp256k1_sha256_transform_generic(uint32_t* s, const uint32_t* chunk);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+static void secp256k1_ecmult_gen_scan_sse2(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+static void secp256k1_ecmult_gen_batch_serial(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn, size_t n);
+#endif
+
+static secp256k1_dispatch secp256k1_dispatch_table = {
+    0
+#ifdef SECP256K1_DISPATCH_SHA256
+    , secp256k1_sha256_transform_generic
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+    , secp256k1_ecmult_gen_scan_sse2
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    , secp256k1_ecmult_gen_batch_serial
+#endif
+};
+
+/** The current value of entry name of secp256k1_dispatch_table. */
+#define SECP256K1_DISPATCH_GET(name) __atomic_load_n(&secp256k1_dispatch_table.name, __ATOMIC_RELAXED)
+
+/** Return the SECP256K1_CPU_* features of the CPU this runs on. */
+static unsigned int secp256k1_cpu_features(void);
+
+/** Fill d with the implementations to use on a CPU with the given features. */
+static void secp256k1_dispatch_select(secp256k1_dispatch *d, unsigned int features);
+
+/** Set secp256k1_dispatch_table up for the CPU this runs on. Only the first
+ *  call does any work; it may run concurrently with other calls and with
+ *  readers of the table. */
+static void secp256k1_dispatch_init(void);
+
+#endif /* SECP256K1_DISPATCH_H */
@@ -0,0 +1,98 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_DISPATCH_IMPL_H
+#define SECP256K1_DISPATCH_IMPL_H
+
+#include "dispatch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+static unsigned int secp256k1_cpu_features(void) {
+    unsigned int features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    unsigned int eax, ebx, ecx, edx, ecx1, xcr0 = 0;
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid(1, eax, ebx, ecx1, edx);
+        /* AVX2 also needs the OS to save the YMM registers: CPUID.1:ECX bit 27
+         * (OSXSAVE), then XCR0 bits 1 and 2 (SSE and AVX state). */
+        if (ecx1 & (1U << 27)) {
+            __asm__ __volatile__("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+        }
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        /* CPUID.(EAX=7,ECX=0):EBX bit 5 is AVX2, bit 8 BMI2, bit 19 ADX and bit 29 SHA.
+         * The SHA code also uses SSSE3 and SSE4.1, CPUID.1:ECX bits 9 and 19. */
+        if ((ebx & (1U << 8)) && (ebx & (1U << 19))) {
+            features |= SECP256K1_CPU_BMI2_ADX;
+        }
+        if ((ebx & (1U << 29)) && (ecx1 & (1U << 9)) && (ecx1 & (1U << 19))) {
+            features |= SECP256K1_CPU_SHA;
+        }
+        if ((ebx & (1U << 5)) && (xcr0 & 6) == 6) {
+            features |= SECP256K1_CPU_AVX2;
+        }
+    }
+    (void)eax; (void)ecx; (void)edx;
+#endif
+    return features;
+}
+
+static void secp256k1_dispatch_select(secp256k1_dispatch *d, unsigned int features) {
+    d->features = features;
+#ifdef SECP256K1_DISPATCH_SHA256
+    if (features & SECP256K1_CPU_SHA) {
+        d->sha256_transform = secp256k1_sha256_transform_shani;
+    } else {
+        d->sha256_transform = secp256k1_sha256_transform_generic;
+    }
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+    if (features & SECP256K1_CPU_AVX2) {
+        d->ecmult_gen_scan = secp256k1_ecmult_gen_scan_avx2;
+    } else {
+        d->ecmult_gen_scan = secp256k1_ecmult_gen_scan_sse2;
+    }
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    if (features & SECP256K1_CPU_AVX2) {
+        d->ecmult_gen_batch = secp256k1_ecmult_gen_batch_x4;
+    } else {
+        d->ecmult_gen_batch = secp256k1_ecmult_gen_batch_serial;
+    }
+#endif
+}
+
+static void secp256k1_dispatch_init(void) {
+#ifdef SECP256K1_HAVE_ATOMICS
+    /* 0: not set up, 1: being set up, 2: set up. */
+    static int state = 0;
+    secp256k1_dispatch d;
+    if (EXPECT(secp256k1_atomic_load(&state) == 2, 1)) {
+        return;
+    }
+    if (!secp256k1_atomic_cas(&state, 0, 1)) {
+        /* Another thread is setting the table up. Until it is done, the
+         * entries it has not replaced yet still work on this CPU. */
+        return;
+    }
+    secp256k1_dispatch_select(&d, secp256k1_cpu_features());
+#ifdef SECP256K1_DISPATCH_SHA256
+    __atomic_store_n(&secp256k1_dispatch_table.sha256_transform, d.sha256_transform, __ATOMIC_RELAXED);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+    __atomic_store_n(&secp256k1_dispatch_table.ecmult_gen_scan, d.ecmult_gen_scan, __ATOMIC_RELAXED);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    __atomic_store_n(&secp256k1_dispatch_table.ecmult_gen_batch, d.ecmult_gen_batch, __ATOMIC_RELAXED);
+#endif
+    __atomic_store_n(&secp256k1_dispatch_table.features, d.features, __ATOMIC_RELAXED);
+    secp256k1_atomic_store(&state, 2);
+#endif
+}
+
+#endif /* SECP256K1_DISPATCH_IMPL_H */
@@ -17,5 +17,8 @@ static int secp256k1_ecdsa_sig_parse(secp256k1_scalar *r, secp256k1_scalar *s, c
 static int secp256k1_ecdsa_sig_serialize(unsigned char *sig, size_t *size, const secp256k1_scalar *r, const secp256k1_scalar *s);
 static int secp256k1_ecdsa_sig_verify(const secp256k1_ecmult_context *ctx, const secp256k1_scalar* r, const secp256k1_scalar* s, const secp256k1_ge *pubkey, const secp256k1_scalar *message);
 static int secp256k1_ecdsa_sig_sign(const secp256k1_ecmult_gen_context *ctx, secp256k1_scalar* r, secp256k1_scalar* s, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce, int *recid);
+/** Finish a signature given the affine nonce point R = k*G and the inverse of k, which lets
+ *  batch signing compute both with a single inversion each. nonce_point is normalized in place. */
+static int secp256k1_ecdsa_sig_sign_finish(secp256k1_scalar* r, secp256k1_scalar* s, secp256k1_ge *nonce_point, const secp256k1_scalar *seckey, const secp256k1_scalar *message, const secp256k1_scalar *nonce_inv, int *recid);
 
 #endif /* SECP256K1_ECDSA_H */
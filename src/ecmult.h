@@ -18,6 +18,7 @@ typedef struct {
 #ifdef USE_ENDOMORPHISM
     secp256k1_ge_storage (*pre_g_128)[]; /* odd multiples of 2^128*generator */
 #endif
+    int *refs; /* number of contexts sharing the tables, or NULL if they are not allocated */
 } secp256k1_ecmult_context;
 
 static void secp256k1_ecmult_context_init(secp256k1_ecmult_context *ctx);
@@ -30,6 +31,24 @@ static int secp256k1_ecmult_context_is_built(const secp256k1_ecmult_context *ctx
 /** Double multiply: R = na*A + ng*G */
 static void secp256k1_ecmult(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_scalar *ng);
 
+typedef struct {
+    /* The same tables as in secp256k1_ecmult_context, for an arbitrary point A: */
+    secp256k1_ge_storage (*pre)[];      /* odd multiples of A */
+#ifdef USE_ENDOMORPHISM
+    secp256k1_ge_storage (*pre_128)[];  /* odd multiples of 2^128*A */
+#endif
+} secp256k1_ecmult_fixed_base;
+
+static void secp256k1_ecmult_fixed_base_init(secp256k1_ecmult_fixed_base *fb);
+/** Precompute the tables for a (which may not be infinity). */
+static void secp256k1_ecmult_fixed_base_build(secp256k1_ecmult_fixed_base *fb, const secp256k1_ge *a, const secp256k1_callback *cb);
+static void secp256k1_ecmult_fixed_base_clear(secp256k1_ecmult_fixed_base *fb);
+
+/** Double multiply with a precomputed point: R = na*A + ng*G, where fb was
+ *  built for A. ng may be NULL, in which case G is not added. ctx is only
+ *  used (and needs to be built) if ng is not NULL. */
+static void secp256k1_ecmult_fixed(const secp256k1_ecmult_context *ctx, const secp256k1_ecmult_fixed_base *fb, secp256k1_gej *r, const secp256k1_scalar *na, const secp256k1_scalar *ng);
+
 typedef int (secp256k1_ecmult_multi_callback)(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data);
 
 /**
@@ -45,4 +64,46 @@ typedef int (secp256k1_ecmult_multi_callback)(secp256k1_scalar *sc, secp256k1_ge
  */
 static int secp256k1_ecmult_multi_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n);
 
+/** A unit of work handed to a secp256k1_ecmult_parallel_callback. */
+typedef void (secp256k1_ecmult_parallel_task)(void *task_data, size_t idx);
+
+/** Runs task(task_data, idx) for every idx < n_tasks, possibly concurrently,
+ *  and only returns once all of them have finished. Returns 1 on success and
+ *  0 if the tasks could not be run. */
+typedef int (secp256k1_ecmult_parallel_callback)(secp256k1_ecmult_parallel_task *task, void *task_data, size_t n_tasks, void *data);
+
+typedef struct {
+    secp256k1_ecmult_parallel_callback *fn;
+    void *data;
+    size_t n_threads;
+} secp256k1_ecmult_parallel;
+
+/**
+ * Same as secp256k1_ecmult_multi_var, but runs in up to par->n_threads tasks
+ * through par->fn. If all points fit into the scratch space the Pippenger
+ * algorithm splits its windows between the tasks. Otherwise the scratch space
+ * is split between the tasks and each of them runs its own batches, in which
+ * case cb may be called concurrently. If par is NULL or par->n_threads <= 1
+ * this is identical to secp256k1_ecmult_multi_var.
+ * Returns 0 also if par->fn fails.
+ */
+static int secp256k1_ecmult_multi_parallel_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, const secp256k1_ecmult_parallel *par);
+
+/**
+ * Streaming multi-multiply: R = inp_g_sc * G + sum_i ni * Ai.
+ * Instead of copying all points of a batch into the scratch space before
+ * running Pippenger's algorithm on them, this keeps a set of buckets for
+ * every window and pulls the points from cb in chunks that are added to all
+ * of them, so that n can be arbitrarily large for a given scratch space
+ * without splitting the computation into batches. At most half of the scratch
+ * space is used for the buckets, which limits the window size. cb is called
+ * for the indices in increasing order and never concurrently, but if par asks
+ * for more than one thread, the next chunk is fetched by one of the tasks
+ * while the others add the previous one to the buckets.
+ * Returns: 1 on success
+ *          0 if the scratch space is too small for the buckets of the
+ *          smallest window and a single point, cb returns 0 or par->fn fails
+ */
+static int secp256k1_ecmult_multi_stream_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, const secp256k1_ecmult_parallel *par);
+
 #endif /* SECP256K1_ECMULT_H */
@@ -10,20 +10,67 @@
 #include "scalar.h"
 #include "group.h"
 
+#ifndef ECMULT_GEN_PREC_BITS
+#  define ECMULT_GEN_PREC_BITS 4
+#endif
+#if ECMULT_GEN_PREC_BITS != 2 && ECMULT_GEN_PREC_BITS != 4 && ECMULT_GEN_PREC_BITS != 8
+#  error "Set ECMULT_GEN_PREC_BITS to 2, 4 or 8."
+#endif
+#define ECMULT_GEN_PREC_B ECMULT_GEN_PREC_BITS
+#ifdef USE_ECMULT_GEN_GLV
+#  ifndef USE_ENDOMORPHISM
+#    error "USE_ECMULT_GEN_GLV requires USE_ENDOMORPHISM."
+#  endif
+/* Only the odd multiples are stored, for the PREC_B bit groups of the two
+ * ECMULT_GEN_GLV_BITS bit halves of the recoded multiplicand. */
+#  define ECMULT_GEN_GLV_BITS 130
+#  define ECMULT_GEN_PREC_G (1 << (ECMULT_GEN_PREC_B - 1))
+#  define ECMULT_GEN_PREC_N ((ECMULT_GEN_GLV_BITS + ECMULT_GEN_PREC_B - 1) / ECMULT_GEN_PREC_B)
+#else
+#  define ECMULT_GEN_PREC_G (1 << ECMULT_GEN_PREC_B)
+#  define ECMULT_GEN_PREC_N (256 / ECMULT_GEN_PREC_B)
+#endif
+
+/* Vectorized table scans are used on x86 with GCC-compatible compilers. SSE2 is
+ * part of the x86_64 baseline; AVX2 is compiled in through a target attribute
+ * and only used if the CPU supports it. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#  define SECP256K1_ECMULT_GEN_SCAN_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__AVX2__) || defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#    define SECP256K1_ECMULT_GEN_SCAN_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
 typedef struct {
     /* For accelerating the computation of a*G:
      * To harden against timing attacks, use the following mechanism:
-     * * Break up the multiplicand into groups of 4 bits, called n_0, n_1, n_2, ..., n_63.
-     * * Compute sum(n_i * 16^i * G + U_i, i=0..63), where:
-     *   * U_i = U * 2^i (for i=0..62)
-     *   * U_i = U * (1-2^63) (for i=63)
-     *   where U is a point with no known corresponding scalar. Note that sum(U_i, i=0..63) = 0.
-     * For each i, and each of the 16 possible values of n_i, (n_i * 16^i * G + U_i) is
-     * precomputed (call it prec(i, n_i)). The formula now becomes sum(prec(i, n_i), i=0..63).
+     * * Break up the multiplicand into groups of PREC_B bits, called n_0, n_1, n_2, ..., n_(PREC_N-1).
+     * * Compute sum(n_i * (PREC_G)^i * G + U_i, i=0 ... PREC_N-1), where:
+     *   * U_i = U * 2^i, for i=0 ... PREC_N-2
+     *   * U_i = U * (1-2^(PREC_N-1)), for i=PREC_N-1
+     *   where U is a point with no known corresponding scalar. Note that sum(U_i, i=0 ... PREC_N-1) = 0.
+     * For each i, and each of the PREC_G possible values of n_i, (n_i * (PREC_G)^i * G + U_i) is
+     * precomputed (call it prec(i, n_i)). The formula now becomes sum(prec(i, n_i), i=0 ... PREC_N-1).
      * None of the resulting prec group elements have a known scalar, and neither do any of
      * the intermediate sums while computing a*G.
+     *
+     * ECMULT_GEN_PREC_BITS trades table size for the number of additions: 2 bits use a
+     * 32 KiB table and 128 additions, 4 bits 64 KiB and 64 additions, 8 bits 512 KiB
+     * and 32 additions.
+     *
+     * With USE_ECMULT_GEN_GLV, the multiplicand is instead split with the endomorphism
+     * into two halves of at least ECMULT_GEN_GLV_BITS bits, recoded into signed odd digits
+     * of PREC_B bits (see secp256k1_ecmult_gen_glv_split). prec[j][i] is then (2*i + 1) * 2^(j*PREC_B) * G,
+     * which is negated in constant time for negative digits and multiplied by lambda for
+     * the second half. This needs 2*PREC_N additions with a table a quarter of the size
+     * for the same PREC_B: 8 KiB and 130 additions for 2 bits, 16.5 KiB and 66 additions
+     * for 4 bits, and 136 KiB and 34 additions for 8 bits. The intermediate sums remain
+     * without known scalar through the blinding.
      */
-    secp256k1_ge_storage (*prec)[64][16]; /* prec[j][i] = 16^j * i * G + U_i */
+    secp256k1_ge_storage (*prec)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G]; /* prec[j][i] = (PREC_G)^j * i * G + U_i */
+    int *refs; /* number of contexts sharing prec, or NULL if it is not allocated */
     secp256k1_scalar blind;
     secp256k1_gej initial;
 } secp256k1_ecmult_gen_context;
@@ -38,6 +85,10 @@ static int secp256k1_ecmult_gen_context_is_built(const secp256k1_ecmult_gen_cont
 /** Multiply with the generator: R = a*G */
 static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context* ctx, secp256k1_gej *r, const secp256k1_scalar *a);
 
+/** Multiply with the generator for n scalars: r[i] = a[i] * G. On CPUs with AVX2,
+ *  groups of four are computed together with the four-way field backend. */
+static void secp256k1_ecmult_gen_batch(const secp256k1_ecmult_gen_context* ctx, secp256k1_gej *r, const secp256k1_scalar *a, size_t n);
+
 static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const unsigned char *seed32);
 
 #endif /* SECP256K1_ECMULT_GEN_H */
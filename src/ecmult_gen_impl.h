@@ -11,18 +11,24 @@
 #include "group.h"
 #include "ecmult_gen.h"
 #include "hash_impl.h"
+#include "group_x4_impl.h"
+#include "dispatch.h"
 #ifdef USE_ECMULT_STATIC_PRECOMPUTATION
 #include "ecmult_static_context.h"
 #endif
+
 static void secp256k1_ecmult_gen_context_init(secp256k1_ecmult_gen_context *ctx) {
     ctx->prec = NULL;
+    ctx->refs = NULL;
 }
 
 static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx, const secp256k1_callback* cb) {
 #ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    secp256k1_ge prec[1024];
+    secp256k1_ge *prec;
     secp256k1_gej gj;
+#ifndef USE_ECMULT_GEN_GLV
     secp256k1_gej nums_gej;
+#endif
     int i, j;
 #endif
 
@@ -30,11 +36,35 @@ static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx
         return;
     }
 #ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    ctx->prec = (secp256k1_ge_storage (*)[64][16])checked_malloc(cb, sizeof(*ctx->prec));
+    ctx->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])checked_malloc(cb, sizeof(*ctx->prec));
+    prec = (secp256k1_ge *)checked_malloc(cb, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G * sizeof(*prec));
 
     /* get the generator */
     secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
 
+#ifdef USE_ECMULT_GEN_GLV
+    /* compute prec. */
+    {
+        secp256k1_gej *precj = (secp256k1_gej *)checked_malloc(cb, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G * sizeof(*precj)); /* Jacobian versions of prec. */
+        secp256k1_gej gbase;
+        secp256k1_gej gbase2;
+        gbase = gj; /* 2^(j*PREC_B) * G */
+        for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+            /* Set precj[j*PREC_G .. j*PREC_G+(PREC_G-1)] to (gbase, 3*gbase, ..., (2*PREC_G-1)*gbase). */
+            precj[j*ECMULT_GEN_PREC_G] = gbase;
+            secp256k1_gej_double_var(&gbase2, &gbase, NULL);
+            for (i = 1; i < ECMULT_GEN_PREC_G; i++) {
+                secp256k1_gej_add_var(&precj[j*ECMULT_GEN_PREC_G + i], &precj[j*ECMULT_GEN_PREC_G + i - 1], &gbase2, NULL);
+            }
+            /* Multiply gbase by 2^PREC_B. */
+            for (i = 0; i < ECMULT_GEN_PREC_B; i++) {
+                secp256k1_gej_double_var(&gbase, &gbase, NULL);
+            }
+        }
+        secp256k1_ge_set_all_gej_var(prec, precj, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G);
+        free(precj);
+    }
+#else
     /* Construct a group element with no known corresponding scalar (nothing up my sleeve). */
     {
         static const unsigned char nums_b32[33] = "The scalar for this x is unknown";
@@ -54,39 +84,44 @@ static void secp256k1_ecmult_gen_context_build(secp256k1_ecmult_gen_context *ctx
 
     /* compute prec. */
     {
-        secp256k1_gej precj[1024]; /* Jacobian versions of prec. */
+        secp256k1_gej *precj = (secp256k1_gej *)checked_malloc(cb, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G * sizeof(*precj)); /* Jacobian versions of prec. */
         secp256k1_gej gbase;
         secp256k1_gej numsbase;
-        gbase = gj; /* 16^j * G */
+        gbase = gj; /* PREC_G^j * G */
         numsbase = nums_gej; /* 2^j * nums. */
-        for (j = 0; j < 64; j++) {
-            /* Set precj[j*16 .. j*16+15] to (numsbase, numsbase + gbase, ..., numsbase + 15*gbase). */
-            precj[j*16] = numsbase;
-            for (i = 1; i < 16; i++) {
-                secp256k1_gej_add_var(&precj[j*16 + i], &precj[j*16 + i - 1], &gbase, NULL);
+        for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+            /* Set precj[j*PREC_G .. j*PREC_G+(PREC_G-1)] to (numsbase, numsbase + gbase, ..., numsbase + (PREC_G-1)*gbase). */
+            precj[j*ECMULT_GEN_PREC_G] = numsbase;
+            for (i = 1; i < ECMULT_GEN_PREC_G; i++) {
+                secp256k1_gej_add_var(&precj[j*ECMULT_GEN_PREC_G + i], &precj[j*ECMULT_GEN_PREC_G + i - 1], &gbase, NULL);
             }
-            /* Multiply gbase by 16. */
-            for (i = 0; i < 4; i++) {
+            /* Multiply gbase by PREC_G. */
+            for (i = 0; i < ECMULT_GEN_PREC_B; i++) {
                 secp256k1_gej_double_var(&gbase, &gbase, NULL);
             }
             /* Multiply numbase by 2. */
             secp256k1_gej_double_var(&numsbase, &numsbase, NULL);
-            if (j == 62) {
+            if (j == ECMULT_GEN_PREC_N - 2) {
                 /* In the last iteration, numsbase is (1 - 2^j) * nums instead. */
                 secp256k1_gej_neg(&numsbase, &numsbase);
                 secp256k1_gej_add_var(&numsbase, &numsbase, &nums_gej, NULL);
             }
         }
-        secp256k1_ge_set_all_gej_var(prec, precj, 1024);
+        secp256k1_ge_set_all_gej_var(prec, precj, ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G);
+        free(precj);
     }
-    for (j = 0; j < 64; j++) {
-        for (i = 0; i < 16; i++) {
-            secp256k1_ge_to_storage(&(*ctx->prec)[j][i], &prec[j*16 + i]);
+#endif
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+            secp256k1_ge_to_storage(&(*ctx->prec)[j][i], &prec[j*ECMULT_GEN_PREC_G + i]);
         }
     }
+    free(prec);
+    ctx->refs = (int *)checked_malloc(cb, sizeof(*ctx->refs));
+    *ctx->refs = 1;
 #else
     (void)cb;
-    ctx->prec = (secp256k1_ge_storage (*)[64][16])secp256k1_ecmult_static_context;
+    ctx->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])secp256k1_ecmult_static_context;
 #endif
     secp256k1_ecmult_gen_blind(ctx, NULL);
 }
@@ -98,14 +133,25 @@ static int secp256k1_ecmult_gen_context_is_built(const secp256k1_ecmult_gen_cont
 static void secp256k1_ecmult_gen_context_clone(secp256k1_ecmult_gen_context *dst,
                                                const secp256k1_ecmult_gen_context *src, const secp256k1_callback* cb) {
     if (src->prec == NULL) {
-        dst->prec = NULL;
+        secp256k1_ecmult_gen_context_init(dst);
     } else {
-#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-        dst->prec = (secp256k1_ge_storage (*)[64][16])checked_malloc(cb, sizeof(*dst->prec));
+#if !defined(USE_ECMULT_STATIC_PRECOMPUTATION) && !defined(SECP256K1_HAVE_ATOMICS)
+        /* Without atomic reference counts, every context owns a copy. */
+        dst->prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])checked_malloc(cb, sizeof(*dst->prec));
         memcpy(dst->prec, src->prec, sizeof(*dst->prec));
+        dst->refs = (int *)checked_malloc(cb, sizeof(*dst->refs));
+        *dst->refs = 1;
 #else
+        /* Only the blinding differs between clones, so they share prec,
+         * counting references to an allocated one. */
         (void)cb;
         dst->prec = src->prec;
+        dst->refs = src->refs;
+#ifdef SECP256K1_HAVE_ATOMICS
+        if (dst->refs != NULL) {
+            secp256k1_atomic_add(dst->refs, 1);
+        }
+#endif
 #endif
         dst->initial = src->initial;
         dst->blind = src->blind;
@@ -113,48 +159,296 @@ static void secp256k1_ecmult_gen_context_clone(secp256k1_ecmult_gen_context *dst
 }
 
 static void secp256k1_ecmult_gen_context_clear(secp256k1_ecmult_gen_context *ctx) {
-#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
-    free(ctx->prec);
+#ifdef SECP256K1_HAVE_ATOMICS
+    if (ctx->refs != NULL && secp256k1_atomic_add(ctx->refs, -1) == 0) {
+#else
+    if (ctx->refs != NULL && --*ctx->refs == 0) {
 #endif
+        free(ctx->prec);
+        free(ctx->refs);
+    }
     secp256k1_scalar_clear(&ctx->blind);
     secp256k1_gej_clear(&ctx->initial);
-    ctx->prec = NULL;
+    secp256k1_ecmult_gen_context_init(ctx);
+}
+
+/** Set r to row[bits] while reading every entry of the row, so that the memory
+ *  access pattern does not depend on bits. */
+static void secp256k1_ecmult_gen_scan_cmov(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits) {
+    int i;
+    memset(r, 0, sizeof(*r));
+    for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+        /** This uses a conditional move to avoid any secret data in array indexes.
+         *   _Any_ use of secret indexes has been demonstrated to result in timing
+         *   sidechannels, even when the cache-line access patterns are uniform.
+         *  See also:
+         *   "A word of warning", CHES 2013 Rump Session, by Daniel J. Bernstein and Peter Schwabe
+         *    (https://cryptojedi.org/peter/data/chesrump-20130822.pdf) and
+         *   "Cache Attacks and Countermeasures: the Case of AES", RSA 2006,
+         *    by Dag Arne Osvik, Adi Shamir, and Eran Tromer
+         *    (http://www.tau.ac.il/~tromer/papers/cache.pdf)
+         */
+        secp256k1_ge_storage_cmov(r, &row[i], i == bits);
+    }
+}
+
+#ifdef SECP256K1_ECMULT_GEN_SCAN_SSE2
+/* As secp256k1_ecmult_gen_scan_cmov, masking whole 16-byte lanes of each entry. */
+static void secp256k1_ecmult_gen_scan_sse2(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits) {
+    const __m128i *p = (const __m128i *)row;
+    __m128i *out = (__m128i *)r;
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    __m128i acc2 = _mm_setzero_si128();
+    __m128i acc3 = _mm_setzero_si128();
+    int i;
+    VERIFY_CHECK(sizeof(secp256k1_ge_storage) == 4 * sizeof(__m128i));
+    for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+        __m128i mask = _mm_set1_epi32(-(int)(i == bits));
+        acc0 = _mm_or_si128(acc0, _mm_and_si128(mask, _mm_loadu_si128(&p[4 * i + 0])));
+        acc1 = _mm_or_si128(acc1, _mm_and_si128(mask, _mm_loadu_si128(&p[4 * i + 1])));
+        acc2 = _mm_or_si128(acc2, _mm_and_si128(mask, _mm_loadu_si128(&p[4 * i + 2])));
+        acc3 = _mm_or_si128(acc3, _mm_and_si128(mask, _mm_loadu_si128(&p[4 * i + 3])));
+    }
+    _mm_storeu_si128(&out[0], acc0);
+    _mm_storeu_si128(&out[1], acc1);
+    _mm_storeu_si128(&out[2], acc2);
+    _mm_storeu_si128(&out[3], acc3);
+}
+#endif
+
+#ifdef SECP256K1_ECMULT_GEN_SCAN_AVX2
+/* As secp256k1_ecmult_gen_scan_cmov, blending whole 32-byte lanes of each entry. */
+#ifndef __AVX2__
+__attribute__((target("avx2")))
+#endif
+static void secp256k1_ecmult_gen_scan_avx2(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits) {
+    const __m256i *p = (const __m256i *)row;
+    __m256i *out = (__m256i *)r;
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int i;
+    VERIFY_CHECK(sizeof(secp256k1_ge_storage) == 2 * sizeof(__m256i));
+    for (i = 0; i < ECMULT_GEN_PREC_G; i++) {
+        __m256i mask = _mm256_set1_epi32(-(int)(i == bits));
+        acc0 = _mm256_blendv_epi8(acc0, _mm256_loadu_si256(&p[2 * i + 0]), mask);
+        acc1 = _mm256_blendv_epi8(acc1, _mm256_loadu_si256(&p[2 * i + 1]), mask);
+    }
+    _mm256_storeu_si256(&out[0], acc0);
+    _mm256_storeu_si256(&out[1], acc1);
+}
+#endif
+
+/** Set r to row[bits] with the fastest constant-time scan available on this CPU. */
+static void secp256k1_ecmult_gen_scan(secp256k1_ge_storage *r, const secp256k1_ge_storage *row, int bits) {
+#if defined(SECP256K1_DISPATCH_ECMULT_GEN_SCAN)
+    SECP256K1_DISPATCH_GET(ecmult_gen_scan)(r, row, bits);
+#elif defined(SECP256K1_ECMULT_GEN_SCAN_SSE2)
+    secp256k1_ecmult_gen_scan_sse2(r, row, bits);
+#else
+    secp256k1_ecmult_gen_scan_cmov(r, row, bits);
+#endif
+}
+
+#ifdef USE_ECMULT_GEN_GLV
+/** Split a into u1 and u2 of at most L = PREC_N*PREC_B bits each, such that
+ *  (2*u1 - (2^L - 1)) + lambda * (2*u2 - (2^L - 1)) == a (mod n). Read bit by bit,
+ *  2*u - (2^L - 1) is sum((2*u_i - 1) * 2^i, i=0 ... L-1): a fixed number of digits
+ *  that are all +1 or -1, so every PREC_B bit group of u stands for an odd digit.
+ *
+ *  Writing u1 = a1 + 2^(L-1) and u2 = a2 + 2^(L-1), the condition becomes
+ *  a1 + lambda * a2 == (a - 1 - lambda) / 2, which secp256k1_scalar_split_lambda
+ *  solves with |a1|, |a2| < 2^128, so that u1 and u2 are in [0, 2^L) with a bit to
+ *  spare as L >= ECMULT_GEN_GLV_BITS. This takes the same time for every a. */
+static void secp256k1_ecmult_gen_glv_split(secp256k1_scalar *u1, secp256k1_scalar *u2, const secp256k1_scalar *a) {
+#if defined(EXHAUSTIVE_TEST_ORDER)
+    secp256k1_scalar lambda, half;
+#else
+    static const secp256k1_scalar lambda = SECP256K1_SCALAR_CONST(
+        0x5363AD4CUL, 0xC05C30E0UL, 0xA5261C02UL, 0x8812645AUL,
+        0x122E22EAUL, 0x20816678UL, 0xDF02967CUL, 0x1B23BD72UL
+    );
+    /* 1/2 mod n */
+    static const secp256k1_scalar half = SECP256K1_SCALAR_CONST(
+        0x7FFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+        0x5D576E73UL, 0x57A4501DUL, 0xDFE92F46UL, 0x681B20A1UL
+    );
+#endif
+    secp256k1_scalar t, top;
+    unsigned char top32[32] = {0};
+#if defined(EXHAUSTIVE_TEST_ORDER)
+    secp256k1_scalar_set_int(&lambda, EXHAUSTIVE_TEST_LAMBDA);
+    secp256k1_scalar_set_int(&half, (EXHAUSTIVE_TEST_ORDER + 1) / 2);
+#endif
+    top32[31 - (ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_B - 1) / 8] = 1 << ((ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_B - 1) % 8);
+    secp256k1_scalar_set_b32(&top, top32, NULL);
+
+    secp256k1_scalar_set_int(&t, 1);
+    secp256k1_scalar_add(&t, &t, &lambda);
+    secp256k1_scalar_negate(&t, &t);
+    secp256k1_scalar_add(&t, &t, a);
+    secp256k1_scalar_mul(&t, &t, &half);
+    secp256k1_scalar_split_lambda(u1, u2, &t);
+    secp256k1_scalar_add(u1, u1, &top);
+    secp256k1_scalar_add(u2, u2, &top);
+    secp256k1_scalar_clear(&t);
 }
 
+/** Set r to the odd multiple of row[0] for a group of PREC_B bits of a half recoded by
+ *  secp256k1_ecmult_gen_glv_split: if the top bit is set, the digit is 2*i + 1 for the
+ *  lower bits i; otherwise it is -(2*i + 1) for their complement i. adds is scratch
+ *  space for the scan, which reads the whole row either way. */
+static void secp256k1_ecmult_gen_lookup_signed(secp256k1_ge *r, secp256k1_ge_storage *adds, const secp256k1_ge_storage *row, int bits) {
+    int negative = ((bits >> (ECMULT_GEN_PREC_B - 1)) & 1) ^ 1;
+    int index = (bits ^ -negative) & (ECMULT_GEN_PREC_G - 1);
+    secp256k1_fe neg_y;
+    secp256k1_ecmult_gen_scan(adds, row, index);
+    secp256k1_ge_from_storage(r, adds);
+    secp256k1_fe_negate(&neg_y, &r->y, 1);
+    secp256k1_fe_cmov(&r->y, &neg_y, negative);
+}
+#endif
+
 static void secp256k1_ecmult_gen(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn) {
     secp256k1_ge add;
     secp256k1_ge_storage adds;
     secp256k1_scalar gnb;
+#ifdef USE_ECMULT_GEN_GLV
+    secp256k1_scalar u1, u2;
+#endif
     int bits;
-    int i, j;
+    int j;
     memset(&adds, 0, sizeof(adds));
     *r = ctx->initial;
     /* Blind scalar/point multiplication by computing (n-b)G + bG instead of nG. */
     secp256k1_scalar_add(&gnb, gn, &ctx->blind);
     add.infinity = 0;
-    for (j = 0; j < 64; j++) {
-        bits = secp256k1_scalar_get_bits(&gnb, j * 4, 4);
-        for (i = 0; i < 16; i++) {
-            /** This uses a conditional move to avoid any secret data in array indexes.
-             *   _Any_ use of secret indexes has been demonstrated to result in timing
-             *   sidechannels, even when the cache-line access patterns are uniform.
-             *  See also:
-             *   "A word of warning", CHES 2013 Rump Session, by Daniel J. Bernstein and Peter Schwabe
-             *    (https://cryptojedi.org/peter/data/chesrump-20130822.pdf) and
-             *   "Cache Attacks and Countermeasures: the Case of AES", RSA 2006,
-             *    by Dag Arne Osvik, Adi Shamir, and Eran Tromer
-             *    (http://www.tau.ac.il/~tromer/papers/cache.pdf)
-             */
-            secp256k1_ge_storage_cmov(&adds, &(*ctx->prec)[j][i], i == bits);
-        }
+#ifdef USE_ECMULT_GEN_GLV
+    /* Sum the signed odd digits of both halves, one table row per PREC_B bit group of
+     * each, applying lambda to the entries for u2. */
+    secp256k1_ecmult_gen_glv_split(&u1, &u2, &gnb);
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        bits = secp256k1_scalar_get_bits(&u1, j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+        secp256k1_ecmult_gen_lookup_signed(&add, &adds, (*ctx->prec)[j], bits);
+        secp256k1_gej_add_ge(r, r, &add);
+        bits = secp256k1_scalar_get_bits(&u2, j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+        secp256k1_ecmult_gen_lookup_signed(&add, &adds, (*ctx->prec)[j], bits);
+        secp256k1_ge_mul_lambda(&add, &add);
+        secp256k1_gej_add_ge(r, r, &add);
+    }
+    secp256k1_scalar_clear(&u1);
+    secp256k1_scalar_clear(&u2);
+#else
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        bits = secp256k1_scalar_get_bits(&gnb, j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+        secp256k1_ecmult_gen_scan(&adds, (*ctx->prec)[j], bits);
         secp256k1_ge_from_storage(&add, &adds);
         secp256k1_gej_add_ge(r, r, &add);
     }
+#endif
     bits = 0;
     secp256k1_ge_clear(&add);
     secp256k1_scalar_clear(&gnb);
 }
 
+#ifdef SECP256K1_FIELD_X4
+/** Set r[k] = gn[k] * G for k = 0..3 exactly as secp256k1_ecmult_gen does, with one
+ *  four-way addition per table row. The entries are still looked up one scalar at
+ *  a time, with the same constant-time scans. */
+SECP256K1_TARGET_AVX2 static void secp256k1_ecmult_gen_x4(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn) {
+    secp256k1_gej_x4 acc;
+    secp256k1_ge_x4 add;
+    secp256k1_ge_storage adds[4];
+    secp256k1_gej initial[4];
+    secp256k1_scalar gnb[4];
+#ifdef USE_ECMULT_GEN_GLV
+    secp256k1_scalar u1[4], u2[4];
+    secp256k1_ge_storage scan;
+    secp256k1_ge ge;
+#endif
+    int bits;
+    int j, k;
+    for (k = 0; k < 4; k++) {
+        initial[k] = ctx->initial;
+        /* Blind scalar/point multiplication by computing (n-b)G + bG instead of nG. */
+        secp256k1_scalar_add(&gnb[k], &gn[k], &ctx->blind);
+    }
+    secp256k1_gej_x4_set_gej(&acc, initial);
+#ifdef USE_ECMULT_GEN_GLV
+    for (k = 0; k < 4; k++) {
+        secp256k1_ecmult_gen_glv_split(&u1[k], &u2[k], &gnb[k]);
+    }
+    memset(&scan, 0, sizeof(scan));
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        for (k = 0; k < 4; k++) {
+            bits = secp256k1_scalar_get_bits(&u1[k], j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+            secp256k1_ecmult_gen_lookup_signed(&ge, &scan, (*ctx->prec)[j], bits);
+            secp256k1_ge_to_storage(&adds[k], &ge);
+        }
+        secp256k1_ge_x4_from_storage(&add, adds);
+        secp256k1_gej_x4_add_ge(&acc, &acc, &add);
+        for (k = 0; k < 4; k++) {
+            bits = secp256k1_scalar_get_bits(&u2[k], j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+            secp256k1_ecmult_gen_lookup_signed(&ge, &scan, (*ctx->prec)[j], bits);
+            secp256k1_ge_mul_lambda(&ge, &ge);
+            secp256k1_ge_to_storage(&adds[k], &ge);
+        }
+        secp256k1_ge_x4_from_storage(&add, adds);
+        secp256k1_gej_x4_add_ge(&acc, &acc, &add);
+    }
+    for (k = 0; k < 4; k++) {
+        secp256k1_scalar_clear(&u1[k]);
+        secp256k1_scalar_clear(&u2[k]);
+    }
+    secp256k1_ge_clear(&ge);
+    memset(&scan, 0, sizeof(scan));
+#else
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        for (k = 0; k < 4; k++) {
+            bits = secp256k1_scalar_get_bits(&gnb[k], j * ECMULT_GEN_PREC_B, ECMULT_GEN_PREC_B);
+            secp256k1_ecmult_gen_scan(&adds[k], (*ctx->prec)[j], bits);
+        }
+        secp256k1_ge_x4_from_storage(&add, adds);
+        secp256k1_gej_x4_add_ge(&acc, &acc, &add);
+    }
+#endif
+    secp256k1_gej_x4_get_gej(r, &acc);
+    bits = 0;
+    memset(adds, 0, sizeof(adds));
+    memset(&add, 0, sizeof(add));
+    memset(&acc, 0, sizeof(acc));
+    for (k = 0; k < 4; k++) {
+        secp256k1_scalar_clear(&gnb[k]);
+    }
+}
+#endif
+
+static void secp256k1_ecmult_gen_batch_serial(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        secp256k1_ecmult_gen(ctx, &r[i], &gn[i]);
+    }
+}
+
+#ifdef SECP256K1_FIELD_X4
+/* For CPUs with AVX2: groups of four at a time, and the rest one at a time. */
+static void secp256k1_ecmult_gen_batch_x4(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        secp256k1_ecmult_gen_x4(ctx, &r[i], &gn[i]);
+    }
+    secp256k1_ecmult_gen_batch_serial(ctx, &r[i], &gn[i], n - i);
+}
+#endif
+
+static void secp256k1_ecmult_gen_batch(const secp256k1_ecmult_gen_context *ctx, secp256k1_gej *r, const secp256k1_scalar *gn, size_t n) {
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    SECP256K1_DISPATCH_GET(ecmult_gen_batch)(ctx, r, gn, n);
+#else
+    secp256k1_ecmult_gen_batch_serial(ctx, r, gn, n);
+#endif
+}
+
 /* Setup blinding values for secp256k1_ecmult_gen. */
 static void secp256k1_ecmult_gen_blind(secp256k1_ecmult_gen_context *ctx, const unsigned char *seed32) {
     secp256k1_scalar b;
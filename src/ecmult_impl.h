@@ -13,6 +13,7 @@
 #include "group.h"
 #include "scalar.h"
 #include "ecmult.h"
+#include "scratch_impl.h"
 
 #if defined(EXHAUSTIVE_TEST_ORDER)
 /* We need to lower these values for exhaustive tests because
@@ -47,6 +48,16 @@
 #else
     #define WNAF_BITS 256
 #endif
+#ifdef USE_ECMULT_STATIC_PRECOMPUTATION
+#include "ecmult_static_pre_g.h"
+#if WINDOW_G > ECMULT_STATIC_PRE_G_WINDOW
+#  error "The static pre_g table is too small for WINDOW_G."
+#endif
+#if defined(USE_ENDOMORPHISM) && WINDOW_G > ECMULT_STATIC_PRE_G_128_WINDOW
+#  error "The static pre_g_128 table is too small for WINDOW_G."
+#endif
+#endif
+
 #define WNAF_SIZE_BITS(bits, w) (((bits) + (w) - 1) / (w))
 #define WNAF_SIZE(w) WNAF_SIZE_BITS(WNAF_BITS, w)
 
@@ -54,17 +65,42 @@
 #define ECMULT_TABLE_SIZE(w) (1 << ((w)-2))
 
 /* The number of objects allocated on the scratch space for ecmult_multi algorithms */
-#define PIPPENGER_SCRATCH_OBJECTS 6
+#define PIPPENGER_SCRATCH_OBJECTS 10
 #define STRAUSS_SCRATCH_OBJECTS 6
 
 #define PIPPENGER_MAX_BUCKET_WINDOW 12
 
+#ifdef ECMULT_TUNING_FILE
+/* Thresholds measured on the target machine by "bench_ecmult tune", which
+ * take precedence over the defaults below */
+#include ECMULT_TUNING_FILE
+#endif
+
+/* Minimum bucket_window for which pippenger_wnaf adds up the points of each
+ * bucket in affine coordinates, sharing inversions between all buckets */
+#ifndef PIPPENGER_AFFINE_MIN_BUCKET_WINDOW
+#define PIPPENGER_AFFINE_MIN_BUCKET_WINDOW 5
+#endif
+
 /* Minimum number of points for which pippenger_wnaf is faster than strauss wnaf */
+#ifndef ECMULT_PIPPENGER_THRESHOLD
 #ifdef USE_ENDOMORPHISM
     #define ECMULT_PIPPENGER_THRESHOLD 88
 #else
     #define ECMULT_PIPPENGER_THRESHOLD 160
 #endif
+#endif
+
+/* The maximum number of points for which bucket windows 1 to
+ * PIPPENGER_MAX_BUCKET_WINDOW-1 are optimal. A window that is never optimal
+ * repeats the limit of the previous one. */
+#ifndef PIPPENGER_WINDOW_LIMITS
+#ifdef USE_ENDOMORPHISM
+    #define PIPPENGER_WINDOW_LIMITS 1, 4, 20, 57, 136, 235, 1260, 1260, 4420, 7880, 16050
+#else
+    #define PIPPENGER_WINDOW_LIMITS 1, 11, 45, 100, 275, 625, 1850, 3400, 9630, 17900, 32800
+#endif
+#endif
 
 #ifdef USE_ENDOMORPHISM
     #define ECMULT_MAX_POINTS_PER_BATCH 5000000
@@ -299,58 +335,94 @@ static void secp256k1_ecmult_context_init(secp256k1_ecmult_context *ctx) {
 #ifdef USE_ENDOMORPHISM
     ctx->pre_g_128 = NULL;
 #endif
+    ctx->refs = NULL;
 }
 
-static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, const secp256k1_callback *cb) {
-    secp256k1_gej gj;
-
-    if (ctx->pre_g != NULL) {
-        return;
-    }
-
-    /* get the generator */
-    secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
-
-    ctx->pre_g = (secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((*ctx->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
+/** Allocate and fill *pre with the odd multiples of a and, with the
+ *  endomorphism, *pre_128 with the odd multiples of 2^128*a. */
+static void secp256k1_ecmult_build_tables(secp256k1_ge_storage (**pre)[], secp256k1_ge_storage (**pre_128)[], const secp256k1_gej *a, const secp256k1_callback *cb) {
+    *pre = (secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((**pre)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
 
     /* precompute the tables with odd multiples */
-    secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g, &gj);
+    secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), **pre, a);
 
 #ifdef USE_ENDOMORPHISM
     {
-        secp256k1_gej g_128j;
+        secp256k1_gej a_128j;
         int i;
 
-        ctx->pre_g_128 = (secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((*ctx->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
+        *pre_128 = (secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((**pre_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
 
-        /* calculate 2^128*generator */
-        g_128j = gj;
+        /* calculate 2^128*a */
+        a_128j = *a;
         for (i = 0; i < 128; i++) {
-            secp256k1_gej_double_var(&g_128j, &g_128j, NULL);
+            secp256k1_gej_double_var(&a_128j, &a_128j, NULL);
         }
-        secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g_128, &g_128j);
+        secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), **pre_128, &a_128j);
     }
+#else
+    (void)pre_128;
+#endif
+}
+
+static void secp256k1_ecmult_context_build(secp256k1_ecmult_context *ctx, const secp256k1_callback *cb) {
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    secp256k1_gej gj;
+#endif
+
+    if (ctx->pre_g != NULL) {
+        return;
+    }
+
+#ifndef USE_ECMULT_STATIC_PRECOMPUTATION
+    /* get the generator */
+    secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
+
+#ifdef USE_ENDOMORPHISM
+    secp256k1_ecmult_build_tables(&ctx->pre_g, &ctx->pre_g_128, &gj, cb);
+#else
+    secp256k1_ecmult_build_tables(&ctx->pre_g, NULL, &gj, cb);
+#endif
+    ctx->refs = (int *)checked_malloc(cb, sizeof(*ctx->refs));
+    *ctx->refs = 1;
+#else
+    /* The static tables hold at least ECMULT_TABLE_SIZE(WINDOW_G) entries. */
+    (void)cb;
+    ctx->pre_g = (secp256k1_ge_storage (*)[])secp256k1_ecmult_static_pre_g;
+#ifdef USE_ENDOMORPHISM
+    ctx->pre_g_128 = (secp256k1_ge_storage (*)[])secp256k1_ecmult_static_pre_g_128;
+#endif
 #endif
 }
 
 static void secp256k1_ecmult_context_clone(secp256k1_ecmult_context *dst,
                                            const secp256k1_ecmult_context *src, const secp256k1_callback *cb) {
+#if !defined(USE_ECMULT_STATIC_PRECOMPUTATION) && !defined(SECP256K1_HAVE_ATOMICS)
+    /* Without atomic reference counts, every context owns a copy. */
     if (src->pre_g == NULL) {
-        dst->pre_g = NULL;
+        secp256k1_ecmult_context_init(dst);
     } else {
         size_t size = sizeof((*dst->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G);
         dst->pre_g = (secp256k1_ge_storage (*)[])checked_malloc(cb, size);
         memcpy(dst->pre_g, src->pre_g, size);
-    }
 #ifdef USE_ENDOMORPHISM
-    if (src->pre_g_128 == NULL) {
-        dst->pre_g_128 = NULL;
-    } else {
-        size_t size = sizeof((*dst->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G);
         dst->pre_g_128 = (secp256k1_ge_storage (*)[])checked_malloc(cb, size);
         memcpy(dst->pre_g_128, src->pre_g_128, size);
+#endif
+        dst->refs = (int *)checked_malloc(cb, sizeof(*dst->refs));
+        *dst->refs = 1;
+    }
+#else
+    /* The tables are never modified after they are built, so clones share
+     * them, counting references to allocated ones. */
+    (void)cb;
+    *dst = *src;
+#ifdef SECP256K1_HAVE_ATOMICS
+    if (dst->refs != NULL) {
+        secp256k1_atomic_add(dst->refs, 1);
     }
 #endif
+#endif
 }
 
 static int secp256k1_ecmult_context_is_built(const secp256k1_ecmult_context *ctx) {
@@ -358,13 +430,48 @@ static int secp256k1_ecmult_context_is_built(const secp256k1_ecmult_context *ctx
 }
 
 static void secp256k1_ecmult_context_clear(secp256k1_ecmult_context *ctx) {
-    free(ctx->pre_g);
+#ifdef SECP256K1_HAVE_ATOMICS
+    if (ctx->refs != NULL && secp256k1_atomic_add(ctx->refs, -1) == 0) {
+#else
+    if (ctx->refs != NULL && --*ctx->refs == 0) {
+#endif
+        free(ctx->pre_g);
 #ifdef USE_ENDOMORPHISM
-    free(ctx->pre_g_128);
+        free(ctx->pre_g_128);
 #endif
+        free(ctx->refs);
+    }
     secp256k1_ecmult_context_init(ctx);
 }
 
+static void secp256k1_ecmult_fixed_base_init(secp256k1_ecmult_fixed_base *fb) {
+    fb->pre = NULL;
+#ifdef USE_ENDOMORPHISM
+    fb->pre_128 = NULL;
+#endif
+}
+
+static void secp256k1_ecmult_fixed_base_build(secp256k1_ecmult_fixed_base *fb, const secp256k1_ge *a, const secp256k1_callback *cb) {
+    secp256k1_gej aj;
+
+    VERIFY_CHECK(fb->pre == NULL);
+    VERIFY_CHECK(!a->infinity);
+    secp256k1_gej_set_ge(&aj, a);
+#ifdef USE_ENDOMORPHISM
+    secp256k1_ecmult_build_tables(&fb->pre, &fb->pre_128, &aj, cb);
+#else
+    secp256k1_ecmult_build_tables(&fb->pre, NULL, &aj, cb);
+#endif
+}
+
+static void secp256k1_ecmult_fixed_base_clear(secp256k1_ecmult_fixed_base *fb) {
+    free(fb->pre);
+#ifdef USE_ENDOMORPHISM
+    free(fb->pre_128);
+#endif
+    secp256k1_ecmult_fixed_base_init(fb);
+}
+
 /** Convert a number to WNAF notation. The number becomes represented by sum(2^i * wnaf[i], i=0..bits),
  *  with the following guarantees:
  *  - each wnaf[i] is either 0, or an odd integer between -(1<<(w-1) - 1) and (1<<(w-1) - 1)
@@ -617,6 +724,78 @@ static void secp256k1_ecmult(const secp256k1_ecmult_context *ctx, secp256k1_gej
     secp256k1_ecmult_strauss_wnaf(ctx, &state, r, 1, a, na, ng);
 }
 
+#ifdef USE_ENDOMORPHISM
+#define ECMULT_FIXED_WNAF_LEN 129
+#define ECMULT_FIXED_MAX_TABLES 4
+#else
+#define ECMULT_FIXED_WNAF_LEN 256
+#define ECMULT_FIXED_MAX_TABLES 2
+#endif
+
+/** Append the wnaf representation(s) of sc, and the table(s) they index, for
+ *  the odd multiples in pre (and pre_128) to the arrays. Returns the new
+ *  number of tables in use. */
+static int secp256k1_ecmult_fixed_prepare(const secp256k1_ge_storage **tables, int (*wnaf)[ECMULT_FIXED_WNAF_LEN], int *bits, int n, const secp256k1_ge_storage *pre, const secp256k1_ge_storage *pre_128, const secp256k1_scalar *sc) {
+#ifdef USE_ENDOMORPHISM
+    secp256k1_scalar sc_1, sc_128;
+
+    /* split sc into sc_1 and sc_128 (where sc = sc_1 + sc_128*2^128, and sc_1 and sc_128 are ~128 bit) */
+    secp256k1_scalar_split_128(&sc_1, &sc_128, sc);
+    tables[n] = pre;
+    bits[n] = secp256k1_ecmult_wnaf(wnaf[n], ECMULT_FIXED_WNAF_LEN, &sc_1, WINDOW_G);
+    n++;
+    tables[n] = pre_128;
+    bits[n] = secp256k1_ecmult_wnaf(wnaf[n], ECMULT_FIXED_WNAF_LEN, &sc_128, WINDOW_G);
+    n++;
+#else
+    (void)pre_128;
+    tables[n] = pre;
+    bits[n] = secp256k1_ecmult_wnaf(wnaf[n], ECMULT_FIXED_WNAF_LEN, sc, WINDOW_G);
+    n++;
+#endif
+    return n;
+}
+
+static void secp256k1_ecmult_fixed(const secp256k1_ecmult_context *ctx, const secp256k1_ecmult_fixed_base *fb, secp256k1_gej *r, const secp256k1_scalar *na, const secp256k1_scalar *ng) {
+    const secp256k1_ge_storage *tables[ECMULT_FIXED_MAX_TABLES];
+    int wnaf[ECMULT_FIXED_MAX_TABLES][ECMULT_FIXED_WNAF_LEN];
+    int bits_t[ECMULT_FIXED_MAX_TABLES];
+    int n_tables = 0;
+    int bits = 0;
+    int i, t;
+
+#ifdef USE_ENDOMORPHISM
+    n_tables = secp256k1_ecmult_fixed_prepare(tables, wnaf, bits_t, n_tables, *fb->pre, *fb->pre_128, na);
+    if (ng != NULL) {
+        n_tables = secp256k1_ecmult_fixed_prepare(tables, wnaf, bits_t, n_tables, *ctx->pre_g, *ctx->pre_g_128, ng);
+    }
+#else
+    n_tables = secp256k1_ecmult_fixed_prepare(tables, wnaf, bits_t, n_tables, *fb->pre, NULL, na);
+    if (ng != NULL) {
+        n_tables = secp256k1_ecmult_fixed_prepare(tables, wnaf, bits_t, n_tables, *ctx->pre_g, NULL, ng);
+    }
+#endif
+    for (t = 0; t < n_tables; t++) {
+        if (bits_t[t] > bits) {
+            bits = bits_t[t];
+        }
+    }
+
+    secp256k1_gej_set_infinity(r);
+
+    for (i = bits - 1; i >= 0; i--) {
+        int n;
+        secp256k1_gej_double_var(r, r, NULL);
+        for (t = 0; t < n_tables; t++) {
+            if (i < bits_t[t] && (n = wnaf[t][i])) {
+                secp256k1_ge tmpa;
+                ECMULT_TABLE_GET_GE_STORAGE(&tmpa, tables[t], n, WINDOW_G);
+                secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+            }
+        }
+    }
+}
+
 static size_t secp256k1_strauss_scratch_size(size_t n_points) {
 #ifdef USE_ENDOMORPHISM
     static const size_t point_size = (2 * sizeof(secp256k1_ge) + sizeof(secp256k1_gej) + sizeof(secp256k1_fe)) * ECMULT_TABLE_SIZE(WINDOW_A) + sizeof(struct secp256k1_strauss_point_state) + sizeof(secp256k1_gej) + sizeof(secp256k1_scalar);
@@ -753,14 +932,289 @@ struct secp256k1_pippenger_state {
     struct secp256k1_pippenger_point_state* ps;
 };
 
+/*
+ * The buckets used by one task of pippenger_wnaf. For small bucket windows the
+ * buckets are kept in jacobian coordinates in 'buckets'. For large ones (see
+ * secp256k1_pippenger_affine_buckets) the points of a window are instead
+ * sorted by bucket into 'points', where bucket j occupies count[j] entries
+ * starting at offset[j], and every bucket is added up in affine coordinates
+ * using 'fe' for the batched inversions.
+ */
+struct secp256k1_pippenger_buckets {
+    secp256k1_gej *buckets;
+    secp256k1_ge *points;
+    secp256k1_fe *fe;
+    size_t *offset;
+    size_t *count;
+};
+
+/*
+ * State shared by the tasks of a parallel pippenger_wnaf. The points are cut
+ * into n_slices slices and every (window, slice) pair is a unit of work whose
+ * result is stored in window_sums. Task t uses buckets[t] and processes the
+ * units t, t + n_tasks, ...
+ */
+struct secp256k1_pippenger_parallel_state {
+    const struct secp256k1_pippenger_buckets *buckets;
+    secp256k1_gej *window_sums;
+    const struct secp256k1_pippenger_state *state;
+    const secp256k1_ge *pt;
+    int bucket_window;
+    size_t n_points;
+    size_t n_slices;
+    size_t n_tasks;
+};
+
+/* Returns whether pippenger_wnaf adds up the buckets in affine coordinates
+ * for a given bucket_window. */
+static int secp256k1_pippenger_affine_buckets(int bucket_window) {
+    return bucket_window >= PIPPENGER_AFFINE_MIN_BUCKET_WINDOW;
+}
+
+/* Prepares the affine addition of b to a by computing the numerator and the
+ * denominator of the slope. If the sum can be computed without an inversion,
+ * it is stored in a, b is set to infinity and den to 1. */
+static void secp256k1_ecmult_pippenger_affine_add_prepare(secp256k1_fe *den, secp256k1_fe *num, secp256k1_ge *a, secp256k1_ge *b) {
+    if (!b->infinity && a->infinity) {
+        *a = *b;
+        b->infinity = 1;
+    }
+    if (b->infinity) {
+        secp256k1_fe_set_int(den, 1);
+        return;
+    }
+    secp256k1_fe_negate(den, &a->x, 1);
+    secp256k1_fe_add(den, &b->x);
+    if (secp256k1_fe_normalizes_to_zero_var(den)) {
+        *num = a->y;
+        secp256k1_fe_add(num, &b->y);
+        if (secp256k1_fe_normalizes_to_zero_var(num)) {
+            /* b = -a */
+            secp256k1_ge_set_infinity(a);
+            b->infinity = 1;
+            secp256k1_fe_set_int(den, 1);
+            return;
+        }
+        /* b = a: the slope is 3*x^2 / 2*y */
+        secp256k1_fe_sqr(num, &a->x);
+        secp256k1_fe_mul_int(num, 3);
+        *den = a->y;
+        secp256k1_fe_mul_int(den, 2);
+        return;
+    }
+    secp256k1_fe_negate(num, &a->y, 2);
+    secp256k1_fe_add(num, &b->y);
+}
+
+/* Sets r = a + b given the numerator and the inverse denominator of the slope
+ * computed by secp256k1_ecmult_pippenger_affine_add_prepare. r may alias a. */
+static void secp256k1_ecmult_pippenger_affine_add_finish(secp256k1_ge *r, const secp256k1_ge *a, const secp256k1_ge *b, const secp256k1_fe *num, const secp256k1_fe *inv) {
+    secp256k1_fe lambda, x3, y3, t;
+
+    if (b->infinity) {
+        *r = *a;
+        return;
+    }
+    secp256k1_fe_mul(&lambda, num, inv);
+    /* x3 = lambda^2 - a.x - b.x */
+    secp256k1_fe_sqr(&x3, &lambda);
+    secp256k1_fe_negate(&t, &a->x, 1);
+    secp256k1_fe_add(&x3, &t);
+    secp256k1_fe_negate(&t, &b->x, 1);
+    secp256k1_fe_add(&x3, &t);
+    secp256k1_fe_normalize_weak(&x3);
+    /* y3 = lambda * (a.x - x3) - a.y */
+    secp256k1_fe_negate(&t, &x3, 1);
+    secp256k1_fe_add(&t, &a->x);
+    secp256k1_fe_mul(&y3, &lambda, &t);
+    secp256k1_fe_negate(&t, &a->y, 2);
+    secp256k1_fe_add(&y3, &t);
+    secp256k1_fe_normalize_weak(&y3);
+    r->x = x3;
+    r->y = y3;
+    r->infinity = 0;
+}
+
+/* Adds up the points of every bucket, leaving the sum of bucket j in
+ * points[offset[j]] if count[j] > 0. Every round adds up pairs of points of
+ * the same bucket in affine coordinates, with one field inversion shared by
+ * all pairs, which halves the number of points per bucket. fe must have room
+ * for three times half the number of points. */
+static void secp256k1_ecmult_pippenger_affine_reduce(const struct secp256k1_pippenger_buckets *buckets, size_t n_buckets, size_t n_points) {
+    secp256k1_fe *den = buckets->fe;
+    secp256k1_fe *num = &den[n_points / 2];
+    secp256k1_fe *inv = &num[n_points / 2];
+
+    while (1) {
+        size_t n_pairs = 0;
+        size_t j, k;
+
+        for (j = 0; j < n_buckets; j++) {
+            secp256k1_ge *p = &buckets->points[buckets->offset[j]];
+            for (k = 0; k + 1 < buckets->count[j]; k += 2) {
+                secp256k1_ecmult_pippenger_affine_add_prepare(&den[n_pairs], &num[n_pairs], &p[k], &p[k + 1]);
+                n_pairs++;
+            }
+        }
+        if (n_pairs == 0) {
+            break;
+        }
+        secp256k1_fe_inv_all_var(inv, den, n_pairs);
+        n_pairs = 0;
+        for (j = 0; j < n_buckets; j++) {
+            secp256k1_ge *p = &buckets->points[buckets->offset[j]];
+            size_t count = buckets->count[j];
+            for (k = 0; k + 1 < count; k += 2) {
+                secp256k1_ecmult_pippenger_affine_add_finish(&p[k / 2], &p[k], &p[k + 1], &num[n_pairs], &inv[n_pairs]);
+                n_pairs++;
+            }
+            if (count & 1) {
+                p[count / 2] = p[count - 1];
+            }
+            buckets->count[j] = (count + 1) / 2;
+        }
+    }
+}
+
+/* Sets r = 1*bucket[0] + 3*bucket[1] + 5*bucket[2] + ... where bucket[j]
+ * is the sum of the points with state index in [begin, end) whose wnaf digit
+ * of window i is +-(2*j + 1), with the sign applied. For i = 0 the wnaf skew
+ * is corrected for as well. */
+static void secp256k1_ecmult_pippenger_window_sum(secp256k1_gej *r, const struct secp256k1_pippenger_buckets *buckets, int bucket_window, const struct secp256k1_pippenger_state *state, int i, const secp256k1_ge *pt, size_t begin, size_t end) {
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
+    size_t n_buckets = ECMULT_TABLE_SIZE(bucket_window+2);
+    size_t np;
+    size_t j;
+    secp256k1_gej skew;
+    secp256k1_gej running_sum;
+
+    secp256k1_gej_set_infinity(&skew);
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        for(j = 0; j < n_buckets; j++) {
+            secp256k1_gej_set_infinity(&buckets->buckets[j]);
+        }
+    } else {
+        for(j = 0; j < n_buckets; j++) {
+            buckets->count[j] = 0;
+        }
+    }
+
+    for (np = begin; np < end; ++np) {
+        int n = state->wnaf_na[np*n_wnaf + i];
+        struct secp256k1_pippenger_point_state point_state = state->ps[np];
+        secp256k1_ge tmp;
+        int idx;
+
+        if (i == 0) {
+            /* correct for wnaf skew */
+            int skew_na = point_state.skew_na;
+            if (skew_na) {
+                secp256k1_ge_neg(&tmp, &pt[point_state.input_pos]);
+                secp256k1_gej_add_ge_var(&skew, &skew, &tmp, NULL);
+            }
+        }
+        if (n == 0) {
+            continue;
+        }
+        idx = n > 0 ? (n - 1)/2 : -(n + 1)/2;
+        if (secp256k1_pippenger_affine_buckets(bucket_window)) {
+            /* Only count the points of each bucket for now */
+            buckets->count[idx]++;
+        } else if (n > 0) {
+            secp256k1_gej_add_ge_var(&buckets->buckets[idx], &buckets->buckets[idx], &pt[point_state.input_pos], NULL);
+        } else {
+            secp256k1_ge_neg(&tmp, &pt[point_state.input_pos]);
+            secp256k1_gej_add_ge_var(&buckets->buckets[idx], &buckets->buckets[idx], &tmp, NULL);
+        }
+    }
+
+    if (secp256k1_pippenger_affine_buckets(bucket_window)) {
+        size_t pos = 0;
+        for (j = 0; j < n_buckets; j++) {
+            buckets->offset[j] = pos;
+            pos += buckets->count[j];
+        }
+        /* Sort the points by bucket, using offset[j] as the insert position
+         * of bucket j and restoring it afterwards */
+        for (np = begin; np < end; ++np) {
+            int n = state->wnaf_na[np*n_wnaf + i];
+            const secp256k1_ge *p = &pt[state->ps[np].input_pos];
+            if (n > 0) {
+                buckets->points[buckets->offset[(n - 1)/2]++] = *p;
+            } else if (n < 0) {
+                secp256k1_ge_neg(&buckets->points[buckets->offset[-(n + 1)/2]++], p);
+            }
+        }
+        for (j = 0; j < n_buckets; j++) {
+            buckets->offset[j] -= buckets->count[j];
+        }
+        secp256k1_ecmult_pippenger_affine_reduce(buckets, n_buckets, pos);
+    }
+
+    /* Accumulate the sum: bucket[0] + 3*bucket[1] + 5*bucket[2] + 7*bucket[3] + ...
+     *                   = bucket[0] +   bucket[1] +   bucket[2] +   bucket[3] + ...
+     *                   +         2 *  (bucket[1] + 2*bucket[2] + 3*bucket[3] + ...)
+     * using an intermediate running sum:
+     * running_sum = bucket[0] +   bucket[1] +   bucket[2] + ...
+     */
+    secp256k1_gej_set_infinity(r);
+    secp256k1_gej_set_infinity(&running_sum);
+    for(j = n_buckets - 1; j > 0; j--) {
+        if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+            secp256k1_gej_add_var(&running_sum, &running_sum, &buckets->buckets[j], NULL);
+        } else if (buckets->count[j] > 0) {
+            secp256k1_gej_add_ge_var(&running_sum, &running_sum, &buckets->points[buckets->offset[j]], NULL);
+        }
+        secp256k1_gej_add_var(r, r, &running_sum, NULL);
+    }
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        secp256k1_gej_add_var(&running_sum, &running_sum, &buckets->buckets[0], NULL);
+    } else if (buckets->count[0] > 0) {
+        secp256k1_gej_add_ge_var(&running_sum, &running_sum, &buckets->points[buckets->offset[0]], NULL);
+    }
+    secp256k1_gej_add_var(&running_sum, &running_sum, &skew, NULL);
+    secp256k1_gej_double_var(r, r, NULL);
+    secp256k1_gej_add_var(r, r, &running_sum, NULL);
+}
+
+static void secp256k1_ecmult_pippenger_task(void *task_data, size_t task) {
+    const struct secp256k1_pippenger_parallel_state *par_state = (const struct secp256k1_pippenger_parallel_state *) task_data;
+    size_t n_units = WNAF_SIZE(par_state->bucket_window+1) * par_state->n_slices;
+    size_t slice_size = par_state->n_points / par_state->n_slices;
+    size_t slice_rem = par_state->n_points % par_state->n_slices;
+    size_t unit;
+
+    for (unit = task; unit < n_units; unit += par_state->n_tasks) {
+        size_t slice = unit % par_state->n_slices;
+        size_t begin = slice * slice_size + (slice < slice_rem ? slice : slice_rem);
+        size_t end = begin + slice_size + (slice < slice_rem);
+
+        secp256k1_ecmult_pippenger_window_sum(&par_state->window_sums[unit], &par_state->buckets[task], par_state->bucket_window, par_state->state, unit / par_state->n_slices, par_state->pt, begin, end);
+    }
+}
+
+/* Returns the number of point slices used by a parallel pippenger_wnaf with
+ * n_wnaf windows. Every window is cut into just enough slices to give each
+ * task at least one unit of work, because each unit costs a full pass over
+ * the buckets. */
+static size_t secp256k1_pippenger_parallel_slices(size_t n_wnaf, size_t n_threads) {
+    return (n_threads + n_wnaf - 1) / n_wnaf;
+}
+
 /*
  * pippenger_wnaf computes the result of a multi-point multiplication as
  * follows: The scalars are brought into wnaf with n_wnaf elements each. Then
  * for every i < n_wnaf, first each point is added to a "bucket" corresponding
  * to the point's wnaf[i]. Second, the buckets are added together such that
  * r += 1*bucket[0] + 3*bucket[1] + 5*bucket[2] + ...
+ *
+ * If par is not NULL and asks for more than one thread, the windows (and if
+ * there are fewer windows than threads, slices of the points) are distributed
+ * over par->n_threads tasks. Then buckets must contain a set of buckets for
+ * every task and window_sums must have room for n_wnaf * n_slices group
+ * elements. Returns 0 if par->fn fails.
  */
-static int secp256k1_ecmult_pippenger_wnaf(secp256k1_gej *buckets, int bucket_window, struct secp256k1_pippenger_state *state, secp256k1_gej *r, const secp256k1_scalar *sc, const secp256k1_ge *pt, size_t num) {
+static int secp256k1_ecmult_pippenger_wnaf(const struct secp256k1_pippenger_buckets *buckets, int bucket_window, struct secp256k1_pippenger_state *state, secp256k1_gej *r, const secp256k1_scalar *sc, const secp256k1_ge *pt, size_t num, const secp256k1_ecmult_parallel *par, secp256k1_gej *window_sums) {
     size_t n_wnaf = WNAF_SIZE(bucket_window+1);
     size_t np;
     size_t no = 0;
@@ -781,154 +1235,76 @@ static int secp256k1_ecmult_pippenger_wnaf(secp256k1_gej *buckets, int bucket_wi
         return 1;
     }
 
-    for (i = n_wnaf - 1; i >= 0; i--) {
-        secp256k1_gej running_sum;
-
-        for(j = 0; j < ECMULT_TABLE_SIZE(bucket_window+2); j++) {
-            secp256k1_gej_set_infinity(&buckets[j]);
+    if (par != NULL && par->n_threads > 1) {
+        struct secp256k1_pippenger_parallel_state par_state;
+        size_t unit;
+
+        par_state.buckets = buckets;
+        par_state.window_sums = window_sums;
+        par_state.state = state;
+        par_state.pt = pt;
+        par_state.bucket_window = bucket_window;
+        par_state.n_points = no;
+        par_state.n_slices = secp256k1_pippenger_parallel_slices(n_wnaf, par->n_threads);
+        par_state.n_tasks = par->n_threads;
+        if (!par->fn(secp256k1_ecmult_pippenger_task, &par_state, par->n_threads, par->data)) {
+            return 0;
         }
 
-        for (np = 0; np < no; ++np) {
-            int n = state->wnaf_na[np*n_wnaf + i];
-            struct secp256k1_pippenger_point_state point_state = state->ps[np];
-            secp256k1_ge tmp;
-            int idx;
-
-            if (i == 0) {
-                /* correct for wnaf skew */
-                int skew = point_state.skew_na;
-                if (skew) {
-                    secp256k1_ge_neg(&tmp, &pt[point_state.input_pos]);
-                    secp256k1_gej_add_ge_var(&buckets[0], &buckets[0], &tmp, NULL);
-                }
+        unit = n_wnaf * par_state.n_slices;
+        for (i = n_wnaf - 1; i >= 0; i--) {
+            size_t slice;
+            for(j = 0; j < bucket_window+1; j++) {
+                secp256k1_gej_double_var(r, r, NULL);
             }
-            if (n > 0) {
-                idx = (n - 1)/2;
-                secp256k1_gej_add_ge_var(&buckets[idx], &buckets[idx], &pt[point_state.input_pos], NULL);
-            } else if (n < 0) {
-                idx = -(n + 1)/2;
-                secp256k1_ge_neg(&tmp, &pt[point_state.input_pos]);
-                secp256k1_gej_add_ge_var(&buckets[idx], &buckets[idx], &tmp, NULL);
+            for (slice = 0; slice < par_state.n_slices; slice++) {
+                unit--;
+                secp256k1_gej_add_var(r, r, &window_sums[unit], NULL);
             }
         }
+        return 1;
+    }
 
-        for(j = 0; j < bucket_window; j++) {
-            secp256k1_gej_double_var(r, r, NULL);
-        }
+    for (i = n_wnaf - 1; i >= 0; i--) {
+        secp256k1_gej window_sum;
 
-        secp256k1_gej_set_infinity(&running_sum);
-        /* Accumulate the sum: bucket[0] + 3*bucket[1] + 5*bucket[2] + 7*bucket[3] + ...
-         *                   = bucket[0] +   bucket[1] +   bucket[2] +   bucket[3] + ...
-         *                   +         2 *  (bucket[1] + 2*bucket[2] + 3*bucket[3] + ...)
-         * using an intermediate running sum:
-         * running_sum = bucket[0] +   bucket[1] +   bucket[2] + ...
-         *
-         * The doubling is done implicitly by deferring the final window doubling (of 'r').
-         */
-        for(j = ECMULT_TABLE_SIZE(bucket_window+2) - 1; j > 0; j--) {
-            secp256k1_gej_add_var(&running_sum, &running_sum, &buckets[j], NULL);
-            secp256k1_gej_add_var(r, r, &running_sum, NULL);
+        for(j = 0; j < bucket_window+1; j++) {
+            secp256k1_gej_double_var(r, r, NULL);
         }
-
-        secp256k1_gej_add_var(&running_sum, &running_sum, &buckets[0], NULL);
-        secp256k1_gej_double_var(r, r, NULL);
-        secp256k1_gej_add_var(r, r, &running_sum, NULL);
+        secp256k1_ecmult_pippenger_window_sum(&window_sum, buckets, bucket_window, state, i, pt, 0, no);
+        secp256k1_gej_add_var(r, r, &window_sum, NULL);
     }
     return 1;
 }
 
+static const size_t secp256k1_pippenger_window_limits[PIPPENGER_MAX_BUCKET_WINDOW - 1] = { PIPPENGER_WINDOW_LIMITS };
+
 /**
  * Returns optimal bucket_window (number of bits of a scalar represented by a
  * set of buckets) for a given number of points.
  */
 static int secp256k1_pippenger_bucket_window(size_t n) {
-#ifdef USE_ENDOMORPHISM
-    if (n <= 1) {
-        return 1;
-    } else if (n <= 4) {
-        return 2;
-    } else if (n <= 20) {
-        return 3;
-    } else if (n <= 57) {
-        return 4;
-    } else if (n <= 136) {
-        return 5;
-    } else if (n <= 235) {
-        return 6;
-    } else if (n <= 1260) {
-        return 7;
-    } else if (n <= 4420) {
-        return 9;
-    } else if (n <= 7880) {
-        return 10;
-    } else if (n <= 16050) {
-        return 11;
-    } else {
-        return PIPPENGER_MAX_BUCKET_WINDOW;
-    }
-#else
-    if (n <= 1) {
-        return 1;
-    } else if (n <= 11) {
-        return 2;
-    } else if (n <= 45) {
-        return 3;
-    } else if (n <= 100) {
-        return 4;
-    } else if (n <= 275) {
-        return 5;
-    } else if (n <= 625) {
-        return 6;
-    } else if (n <= 1850) {
-        return 7;
-    } else if (n <= 3400) {
-        return 8;
-    } else if (n <= 9630) {
-        return 9;
-    } else if (n <= 17900) {
-        return 10;
-    } else if (n <= 32800) {
-        return 11;
-    } else {
-        return PIPPENGER_MAX_BUCKET_WINDOW;
+    int bucket_window;
+
+    for (bucket_window = 1; bucket_window < PIPPENGER_MAX_BUCKET_WINDOW; bucket_window++) {
+        if (n <= secp256k1_pippenger_window_limits[bucket_window - 1]) {
+            return bucket_window;
+        }
     }
-#endif
+    return PIPPENGER_MAX_BUCKET_WINDOW;
 }
 
 /**
  * Returns the maximum optimal number of points for a bucket_window.
  */
 static size_t secp256k1_pippenger_bucket_window_inv(int bucket_window) {
-    switch(bucket_window) {
-#ifdef USE_ENDOMORPHISM
-        case 1: return 1;
-        case 2: return 4;
-        case 3: return 20;
-        case 4: return 57;
-        case 5: return 136;
-        case 6: return 235;
-        case 7: return 1260;
-        case 8: return 1260;
-        case 9: return 4420;
-        case 10: return 7880;
-        case 11: return 16050;
-        case PIPPENGER_MAX_BUCKET_WINDOW: return SIZE_MAX;
-#else
-        case 1: return 1;
-        case 2: return 11;
-        case 3: return 45;
-        case 4: return 100;
-        case 5: return 275;
-        case 6: return 625;
-        case 7: return 1850;
-        case 8: return 3400;
-        case 9: return 9630;
-        case 10: return 17900;
-        case 11: return 32800;
-        case PIPPENGER_MAX_BUCKET_WINDOW: return SIZE_MAX;
-#endif
+    if (bucket_window < 1 || bucket_window > PIPPENGER_MAX_BUCKET_WINDOW) {
+        return 0;
     }
-    return 0;
+    if (bucket_window == PIPPENGER_MAX_BUCKET_WINDOW) {
+        return SIZE_MAX;
+    }
+    return secp256k1_pippenger_window_limits[bucket_window - 1];
 }
 
 
@@ -949,6 +1325,19 @@ SECP256K1_INLINE static void secp256k1_ecmult_endo_split(secp256k1_scalar *s1, s
 }
 #endif
 
+/**
+ * Returns the scratch size of the buckets of a single task of pippenger_wnaf
+ * for a given number of entries (the points after splitting them with the
+ * endomorphism, including G) without considering alignment.
+ */
+static size_t secp256k1_pippenger_buckets_scratch_size(size_t entries, int bucket_window) {
+    size_t size = sizeof(struct secp256k1_pippenger_buckets);
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        return size + (sizeof(secp256k1_gej) << bucket_window);
+    }
+    return size + (2 * sizeof(size_t) << bucket_window) + entries * sizeof(secp256k1_ge) + 3 * (entries / 2) * sizeof(secp256k1_fe);
+}
+
 /**
  * Returns the scratch size required for a given number of points (excluding
  * base point G) without considering alignment.
@@ -960,10 +1349,32 @@ static size_t secp256k1_pippenger_scratch_size(size_t n_points, int bucket_windo
     size_t entries = n_points + 1;
 #endif
     size_t entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
-    return (sizeof(secp256k1_gej) << bucket_window) + sizeof(struct secp256k1_pippenger_state) + entries * entry_size;
+    return secp256k1_pippenger_buckets_scratch_size(entries, bucket_window) + sizeof(struct secp256k1_pippenger_state) + entries * entry_size;
+}
+
+/**
+ * Returns the scratch size required in addition to
+ * secp256k1_pippenger_scratch_size to run pippenger_wnaf with n_threads tasks.
+ */
+static size_t secp256k1_pippenger_parallel_scratch_size(size_t n_points, int bucket_window, size_t n_threads) {
+#ifdef USE_ENDOMORPHISM
+    size_t entries = 2*n_points + 2;
+#else
+    size_t entries = n_points + 1;
+#endif
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
+    if (n_threads <= 1) {
+        return 0;
+    }
+    return (n_threads - 1) * secp256k1_pippenger_buckets_scratch_size(entries, bucket_window)
+        + n_wnaf * secp256k1_pippenger_parallel_slices(n_wnaf, n_threads) * sizeof(secp256k1_gej);
 }
 
-static int secp256k1_ecmult_pippenger_batch(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset) {
+/*
+ * Runs pippenger_wnaf with a given bucket_window on the n_points points
+ * returned by cb starting at index cb_offset.
+ */
+static int secp256k1_ecmult_pippenger_batch_window(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset, int bucket_window, const secp256k1_ecmult_parallel *par) {
     /* Use 2(n+1) with the endomorphism, n+1 without, when calculating batch
      * sizes. The reason for +1 is that we add the G scalar to the list of
      * other scalars. */
@@ -972,14 +1383,18 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_ecmult_context *ctx,
 #else
     size_t entries = n_points + 1;
 #endif
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
     secp256k1_ge *points;
     secp256k1_scalar *scalars;
-    secp256k1_gej *buckets;
+    struct secp256k1_pippenger_buckets *buckets;
+    secp256k1_gej *window_sums = NULL;
     struct secp256k1_pippenger_state *state_space;
+    size_t n_threads = par != NULL && par->n_threads > 1 ? par->n_threads : 1;
     size_t idx = 0;
     size_t point_idx = 0;
-    int i, j;
-    int bucket_window;
+    size_t i;
+    size_t j;
+    int ret;
 
     (void)ctx;
     secp256k1_gej_set_infinity(r);
@@ -987,16 +1402,34 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_ecmult_context *ctx,
         return 1;
     }
 
-    bucket_window = secp256k1_pippenger_bucket_window(n_points);
-    if (!secp256k1_scratch_allocate_frame(scratch, secp256k1_pippenger_scratch_size(n_points, bucket_window), PIPPENGER_SCRATCH_OBJECTS)) {
+    if (!secp256k1_scratch_allocate_frame(scratch, secp256k1_pippenger_scratch_size(n_points, bucket_window) + secp256k1_pippenger_parallel_scratch_size(n_points, bucket_window, n_threads), PIPPENGER_SCRATCH_OBJECTS)) {
         return 0;
     }
     points = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, entries * sizeof(*points));
     scalars = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, entries * sizeof(*scalars));
     state_space = (struct secp256k1_pippenger_state *) secp256k1_scratch_alloc(scratch, sizeof(*state_space));
     state_space->ps = (struct secp256k1_pippenger_point_state *) secp256k1_scratch_alloc(scratch, entries * sizeof(*state_space->ps));
-    state_space->wnaf_na = (int *) secp256k1_scratch_alloc(scratch, entries*(WNAF_SIZE(bucket_window+1)) * sizeof(int));
-    buckets = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, sizeof(*buckets) << bucket_window);
+    state_space->wnaf_na = (int *) secp256k1_scratch_alloc(scratch, entries * n_wnaf * sizeof(int));
+    buckets = (struct secp256k1_pippenger_buckets *) secp256k1_scratch_alloc(scratch, n_threads * sizeof(*buckets));
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        secp256k1_gej *bucket_space = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, n_threads * sizeof(secp256k1_gej) << bucket_window);
+        for (i = 0; i < n_threads; i++) {
+            buckets[i].buckets = &bucket_space[i << bucket_window];
+        }
+    } else {
+        secp256k1_ge *point_space = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, n_threads * entries * sizeof(secp256k1_ge));
+        secp256k1_fe *fe_space = (secp256k1_fe *) secp256k1_scratch_alloc(scratch, n_threads * 3 * (entries / 2) * sizeof(secp256k1_fe));
+        size_t *count_space = (size_t *) secp256k1_scratch_alloc(scratch, n_threads * 2 * sizeof(size_t) << bucket_window);
+        for (i = 0; i < n_threads; i++) {
+            buckets[i].points = &point_space[i * entries];
+            buckets[i].fe = &fe_space[i * 3 * (entries / 2)];
+            buckets[i].offset = &count_space[2 * i << bucket_window];
+            buckets[i].count = &count_space[(2 * i + 1) << bucket_window];
+        }
+    }
+    if (n_threads > 1) {
+        window_sums = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, n_wnaf * secp256k1_pippenger_parallel_slices(n_wnaf, n_threads) * sizeof(*window_sums));
+    }
 
     if (inp_g_sc != NULL) {
         scalars[0] = *inp_g_sc;
@@ -1021,49 +1454,85 @@ static int secp256k1_ecmult_pippenger_batch(const secp256k1_ecmult_context *ctx,
         point_idx++;
     }
 
-    secp256k1_ecmult_pippenger_wnaf(buckets, bucket_window, state_space, r, scalars, points, idx);
+    ret = secp256k1_ecmult_pippenger_wnaf(buckets, bucket_window, state_space, r, scalars, points, idx, par, window_sums);
 
     /* Clear data */
-    for(i = 0; (size_t)i < idx; i++) {
+    for(i = 0; i < idx; i++) {
         secp256k1_scalar_clear(&scalars[i]);
         state_space->ps[i].skew_na = 0;
-        for(j = 0; j < WNAF_SIZE(bucket_window+1); j++) {
-            state_space->wnaf_na[i * WNAF_SIZE(bucket_window+1) + j] = 0;
+        for(j = 0; j < n_wnaf; j++) {
+            state_space->wnaf_na[i * n_wnaf + j] = 0;
         }
     }
-    for(i = 0; i < 1<<bucket_window; i++) {
-        secp256k1_gej_clear(&buckets[i]);
+    for(i = 0; i < n_threads; i++) {
+        if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+            for(j = 0; j < (size_t)1 << bucket_window; j++) {
+                secp256k1_gej_clear(&buckets[i].buckets[j]);
+            }
+        } else {
+            for(j = 0; j < idx; j++) {
+                secp256k1_ge_clear(&buckets[i].points[j]);
+            }
+        }
     }
     secp256k1_scratch_deallocate_frame(scratch);
-    return 1;
+    return ret;
+}
+
+static int secp256k1_ecmult_pippenger_batch(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points, size_t cb_offset, const secp256k1_ecmult_parallel *par) {
+    return secp256k1_ecmult_pippenger_batch_window(ctx, scratch, r, inp_g_sc, cb, cbdata, n_points, cb_offset, secp256k1_pippenger_bucket_window(n_points), par);
 }
 
 /* Wrapper for secp256k1_ecmult_multi_func interface */
 static int secp256k1_ecmult_pippenger_batch_single(const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
-    return secp256k1_ecmult_pippenger_batch(actx, scratch, r, inp_g_sc, cb, cbdata, n, 0);
+    return secp256k1_ecmult_pippenger_batch(actx, scratch, r, inp_g_sc, cb, cbdata, n, 0, NULL);
+}
+
+/**
+ * Computes the scratch space needed by pippenger_wnaf with n_threads tasks as
+ * an upper bound of the form overhead + n_points * entry_size. Returns the
+ * overhead.
+ */
+static size_t secp256k1_pippenger_space_bound(size_t *entry_size, int bucket_window, size_t n_threads) {
+    size_t space_overhead;
+
+    *entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
+    /* Every task needs the fixed part of its buckets, and with affine
+     * buckets also room for every entry. */
+    space_overhead = n_threads * secp256k1_pippenger_buckets_scratch_size(0, bucket_window) + sizeof(struct secp256k1_pippenger_state);
+    if (secp256k1_pippenger_affine_buckets(bucket_window)) {
+        *entry_size += n_threads * (sizeof(secp256k1_ge) + (3 * sizeof(secp256k1_fe) + 1) / 2);
+    }
+    if (n_threads > 1) {
+        space_overhead += WNAF_SIZE(bucket_window+1) * secp256k1_pippenger_parallel_slices(WNAF_SIZE(bucket_window+1), n_threads) * sizeof(secp256k1_gej);
+    }
+#ifdef USE_ENDOMORPHISM
+    *entry_size = 2 * *entry_size;
+#endif
+    /* The extra entry is for G */
+    return space_overhead + *entry_size;
 }
 
 /**
  * Returns the maximum number of points in addition to G that can be used with
- * a given scratch space. The function ensures that fewer points may also be
- * used.
+ * a given scratch space when running with n_threads tasks. The function
+ * ensures that fewer points may also be used.
  */
-static size_t secp256k1_pippenger_max_points(secp256k1_scratch *scratch) {
+static size_t secp256k1_pippenger_max_points(secp256k1_scratch *scratch, size_t n_threads) {
     size_t max_alloc = secp256k1_scratch_max_allocation(scratch, PIPPENGER_SCRATCH_OBJECTS);
     int bucket_window;
     size_t res = 0;
 
+    if (n_threads < 1) {
+        n_threads = 1;
+    }
     for (bucket_window = 1; bucket_window <= PIPPENGER_MAX_BUCKET_WINDOW; bucket_window++) {
         size_t n_points;
         size_t max_points = secp256k1_pippenger_bucket_window_inv(bucket_window);
         size_t space_for_points;
-        size_t space_overhead;
-        size_t entry_size = sizeof(secp256k1_ge) + sizeof(secp256k1_scalar) + sizeof(struct secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
+        size_t entry_size;
+        size_t space_overhead = secp256k1_pippenger_space_bound(&entry_size, bucket_window, n_threads);
 
-#ifdef USE_ENDOMORPHISM
-        entry_size = 2*entry_size;
-#endif
-        space_overhead = (sizeof(secp256k1_gej) << bucket_window) + entry_size + sizeof(struct secp256k1_pippenger_state);
         if (space_overhead > max_alloc) {
             break;
         }
@@ -1084,6 +1553,32 @@ static size_t secp256k1_pippenger_max_points(secp256k1_scratch *scratch) {
     return res;
 }
 
+/**
+ * Returns the smallest scratch space size (including alignment overhead) for
+ * which secp256k1_pippenger_max_points(scratch, n_threads) returns at least
+ * n_points. This is more than secp256k1_pippenger_scratch_size(n_points, ...)
+ * because secp256k1_pippenger_max_points must also be able to use every
+ * smaller bucket_window up to its maximum number of points.
+ */
+static size_t secp256k1_pippenger_scratch_size_max_points(size_t n_points, size_t n_threads) {
+    int bucket_window;
+    size_t res = 0;
+
+    if (n_threads < 1) {
+        n_threads = 1;
+    }
+    for (bucket_window = 1; bucket_window <= secp256k1_pippenger_bucket_window(n_points); bucket_window++) {
+        size_t max_points = secp256k1_pippenger_bucket_window_inv(bucket_window);
+        size_t entry_size;
+        size_t size = secp256k1_pippenger_space_bound(&entry_size, bucket_window, n_threads);
+        size += (n_points < max_points ? n_points : max_points) * entry_size;
+        if (size > res) {
+            res = size;
+        }
+    }
+    return res + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT;
+}
+
 /* Computes ecmult_multi by simply multiplying and adding each point. Does not
  * require a scratch space */
 static int secp256k1_ecmult_multi_simple_var(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n_points) {
@@ -1131,11 +1626,114 @@ static int secp256k1_ecmult_multi_batch_size_helper(size_t *n_batches, size_t *n
     return 1;
 }
 
+/* Compute the number of batches, their size and the algorithm to use for n
+ * points given a scratch space and the number of threads per batch. Returns 0
+ * if the scratch space does not suffice for a single point. */
+static int secp256k1_ecmult_multi_batch_sizes(size_t *n_batches, size_t *n_batch_points, int *use_pippenger, secp256k1_scratch *scratch, size_t n_threads, size_t n) {
+    /* Compute the batch sizes for pippenger given a scratch space. If it's greater than a threshold
+     * use pippenger. Otherwise use strauss */
+    if (secp256k1_ecmult_multi_batch_size_helper(n_batches, n_batch_points, secp256k1_pippenger_max_points(scratch, n_threads), n)
+        && *n_batch_points >= ECMULT_PIPPENGER_THRESHOLD) {
+        *use_pippenger = 1;
+        return 1;
+    }
+    *use_pippenger = 0;
+    return secp256k1_ecmult_multi_batch_size_helper(n_batches, n_batch_points, secp256k1_strauss_max_points(scratch), n);
+}
+
+/*
+ * State shared by the tasks of secp256k1_ecmult_multi_parallel_batches. Task
+ * t runs the batches t, t + n_tasks, ... with its own scratch space
+ * scratches[t] of size task_scratch_size and stores their sum in results[t].
+ */
+struct secp256k1_ecmult_multi_batch_state {
+    const secp256k1_ecmult_context *ctx;
+    secp256k1_scratch *scratches;
+    secp256k1_gej *results;
+    int *ok;
+    const secp256k1_scalar *inp_g_sc;
+    secp256k1_ecmult_multi_callback *cb;
+    void *cbdata;
+    size_t n;
+    size_t n_batches;
+    size_t n_batch_points;
+    size_t n_tasks;
+    size_t task_scratch_size;
+    int use_pippenger;
+};
+
+/* The objects secp256k1_ecmult_multi_parallel_batches allocates for every task */
+#define ECMULT_MULTI_TASK_SIZE (sizeof(secp256k1_scratch) + sizeof(secp256k1_gej) + sizeof(int))
+
+/* Returns how much of the scratch space each of n_tasks tasks of
+ * secp256k1_ecmult_multi_parallel_batches can use */
+static size_t secp256k1_ecmult_multi_task_scratch_size(const secp256k1_scratch *scratch, size_t n_tasks) {
+    size_t max_alloc = secp256k1_scratch_max_allocation(scratch, 3);
+    if (max_alloc <= n_tasks * ECMULT_MULTI_TASK_SIZE) {
+        return 0;
+    }
+    return (max_alloc - n_tasks * ECMULT_MULTI_TASK_SIZE) / n_tasks;
+}
+
+static void secp256k1_ecmult_multi_batch_task(void *task_data, size_t task) {
+    const struct secp256k1_ecmult_multi_batch_state *batch_state = (const struct secp256k1_ecmult_multi_batch_state *) task_data;
+    secp256k1_scratch *scratch = &batch_state->scratches[task];
+    size_t i;
+
+    secp256k1_gej_set_infinity(&batch_state->results[task]);
+    batch_state->ok[task] = 1;
+    for (i = task; i < batch_state->n_batches; i += batch_state->n_tasks) {
+        size_t offset = batch_state->n_batch_points*i;
+        size_t nbp = batch_state->n - offset < batch_state->n_batch_points ? batch_state->n - offset : batch_state->n_batch_points;
+        const secp256k1_scalar *inp_g_sc = i == 0 ? batch_state->inp_g_sc : NULL;
+        secp256k1_gej tmp;
+        int ret;
+
+        if (batch_state->use_pippenger) {
+            ret = secp256k1_ecmult_pippenger_batch(batch_state->ctx, scratch, &tmp, inp_g_sc, batch_state->cb, batch_state->cbdata, nbp, offset, NULL);
+        } else {
+            ret = secp256k1_ecmult_strauss_batch(batch_state->ctx, scratch, &tmp, inp_g_sc, batch_state->cb, batch_state->cbdata, nbp, offset);
+        }
+        if (!ret) {
+            batch_state->ok[task] = 0;
+            return;
+        }
+        secp256k1_gej_add_var(&batch_state->results[task], &batch_state->results[task], &tmp, NULL);
+    }
+}
+
+/* Runs the batches described by batch_state concurrently. The scratch space
+ * budget is split evenly between the tasks, each of which gets its own
+ * scratch space object. */
+static int secp256k1_ecmult_multi_parallel_batches(struct secp256k1_ecmult_multi_batch_state *batch_state, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_ecmult_parallel *par) {
+    size_t i;
+    int ret;
+
+    if (!secp256k1_scratch_allocate_frame(scratch, batch_state->n_tasks * ECMULT_MULTI_TASK_SIZE, 3)) {
+        return 0;
+    }
+    batch_state->scratches = (secp256k1_scratch *) secp256k1_scratch_alloc(scratch, batch_state->n_tasks * sizeof(secp256k1_scratch));
+    batch_state->results = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, batch_state->n_tasks * sizeof(secp256k1_gej));
+    batch_state->ok = (int *) secp256k1_scratch_alloc(scratch, batch_state->n_tasks * sizeof(int));
+    for (i = 0; i < batch_state->n_tasks; i++) {
+        secp256k1_scratch_init(&batch_state->scratches[i], scratch->error_callback, batch_state->task_scratch_size);
+    }
+
+    ret = par->fn(secp256k1_ecmult_multi_batch_task, batch_state, batch_state->n_tasks, par->data);
+    for (i = 0; ret && i < batch_state->n_tasks; i++) {
+        ret = batch_state->ok[i];
+        secp256k1_gej_add_var(r, r, &batch_state->results[i], NULL);
+    }
+    secp256k1_scratch_deallocate_frame(scratch);
+    return ret;
+}
+
 typedef int (*secp256k1_ecmult_multi_func)(const secp256k1_ecmult_context*, secp256k1_scratch*, secp256k1_gej*, const secp256k1_scalar*, secp256k1_ecmult_multi_callback cb, void*, size_t);
-static int secp256k1_ecmult_multi_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+static int secp256k1_ecmult_multi_parallel_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, const secp256k1_ecmult_parallel *par) {
     size_t i;
 
-    int (*f)(const secp256k1_ecmult_context*, secp256k1_scratch*, secp256k1_gej*, const secp256k1_scalar*, secp256k1_ecmult_multi_callback cb, void*, size_t, size_t);
+    int use_pippenger;
+    size_t n_threads = par != NULL && par->n_threads > 1 ? par->n_threads : 1;
     size_t n_batches;
     size_t n_batch_points;
 
@@ -1152,25 +1750,40 @@ static int secp256k1_ecmult_multi_var(const secp256k1_ecmult_context *ctx, secp2
         return secp256k1_ecmult_multi_simple_var(ctx, r, inp_g_sc, cb, cbdata, n);
     }
 
-    /* Compute the batch sizes for pippenger given a scratch space. If it's greater than a threshold
-     * use pippenger. Otherwise use strauss */
-    if (!secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, secp256k1_pippenger_max_points(scratch), n)) {
+    if (!secp256k1_ecmult_multi_batch_sizes(&n_batches, &n_batch_points, &use_pippenger, scratch, n_threads, n)) {
         return 0;
     }
-    if (n_batch_points >= ECMULT_PIPPENGER_THRESHOLD) {
-        f = secp256k1_ecmult_pippenger_batch;
-    } else {
-        if (!secp256k1_ecmult_multi_batch_size_helper(&n_batches, &n_batch_points, secp256k1_strauss_max_points(scratch), n)) {
-            return 0;
+    if (n_threads > 1 && n_batches > 1) {
+        /* Rather than running the batches one after another with all threads
+         * working on each, run smaller batches concurrently if the scratch
+         * space can be split. */
+        struct secp256k1_ecmult_multi_batch_state batch_state;
+        secp256k1_scratch task_scratch;
+
+        batch_state.task_scratch_size = secp256k1_ecmult_multi_task_scratch_size(scratch, n_threads);
+        secp256k1_scratch_init(&task_scratch, scratch->error_callback, batch_state.task_scratch_size);
+        if (secp256k1_ecmult_multi_batch_sizes(&batch_state.n_batches, &batch_state.n_batch_points, &batch_state.use_pippenger, &task_scratch, 1, n)) {
+            batch_state.ctx = ctx;
+            batch_state.inp_g_sc = inp_g_sc;
+            batch_state.cb = cb;
+            batch_state.cbdata = cbdata;
+            batch_state.n = n;
+            batch_state.n_tasks = n_threads < batch_state.n_batches ? n_threads : batch_state.n_batches;
+            return secp256k1_ecmult_multi_parallel_batches(&batch_state, scratch, r, par);
         }
-        f = secp256k1_ecmult_strauss_batch;
     }
     for(i = 0; i < n_batches; i++) {
         size_t nbp = n < n_batch_points ? n : n_batch_points;
         size_t offset = n_batch_points*i;
         secp256k1_gej tmp;
-        if (!f(ctx, scratch, &tmp, i == 0 ? inp_g_sc : NULL, cb, cbdata, nbp, offset)) {
-            return 0;
+        if (use_pippenger) {
+            if (!secp256k1_ecmult_pippenger_batch(ctx, scratch, &tmp, i == 0 ? inp_g_sc : NULL, cb, cbdata, nbp, offset, par)) {
+                return 0;
+            }
+        } else {
+            if (!secp256k1_ecmult_strauss_batch(ctx, scratch, &tmp, i == 0 ? inp_g_sc : NULL, cb, cbdata, nbp, offset)) {
+                return 0;
+            }
         }
         secp256k1_gej_add_var(r, r, &tmp, NULL);
         n -= nbp;
@@ -1178,4 +1791,369 @@ static int secp256k1_ecmult_multi_var(const secp256k1_ecmult_context *ctx, secp2
     return 1;
 }
 
+static int secp256k1_ecmult_multi_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    return secp256k1_ecmult_multi_parallel_var(ctx, scratch, r, inp_g_sc, cb, cbdata, n, NULL);
+}
+
+#ifdef USE_ENDOMORPHISM
+#define STREAM_ENTRIES_PER_POINT 2
+#else
+#define STREAM_ENTRIES_PER_POINT 1
+#endif
+
+/* A buffer of points fetched from the callback by
+ * secp256k1_ecmult_multi_stream_var, with the wnaf digits of their scalars
+ * followed by the skew for every entry. */
+struct secp256k1_pippenger_stream_chunk {
+    secp256k1_ge *pt;
+    int *wnaf;
+    size_t n_entries;
+};
+
+/*
+ * State of secp256k1_ecmult_multi_stream_var. Unlike pippenger_wnaf, which
+ * fills one set of buckets per window after another, every window keeps its
+ * own set of buckets for the whole computation, so that the points only have
+ * to be available while they are added to the buckets and can be fetched in
+ * chunks of any size. With affine buckets, the buckets are kept in affine
+ * coordinates and reduced together with the points of every chunk by
+ * secp256k1_ecmult_pippenger_affine_reduce, using work[t] in task t.
+ */
+struct secp256k1_pippenger_stream_state {
+    secp256k1_ecmult_multi_callback *cb;
+    void *cbdata;
+    /* n_wnaf sets of buckets, one after another */
+    secp256k1_gej *buckets;
+    secp256k1_ge *affine_buckets;
+    struct secp256k1_pippenger_buckets *work;
+    secp256k1_gej *window_sums;
+    /* correction for the wnaf skews, part of window 0 */
+    secp256k1_gej skew;
+    struct secp256k1_pippenger_stream_chunk *current;
+    struct secp256k1_pippenger_stream_chunk *next;
+    size_t next_offset;
+    size_t next_points;
+    int fetch_ok;
+    int bucket_window;
+    size_t n_wnaf;
+    size_t n_tasks;
+};
+
+/* Fetches n_points points starting at offset into chunk. */
+static int secp256k1_ecmult_stream_fetch(const struct secp256k1_pippenger_stream_state *state, struct secp256k1_pippenger_stream_chunk *chunk, size_t offset, size_t n_points) {
+    size_t stride = state->n_wnaf + 1;
+    size_t idx = 0;
+    size_t i;
+
+    for (i = 0; i < n_points; i++) {
+        secp256k1_scalar sc[STREAM_ENTRIES_PER_POINT];
+        int k;
+
+        if (!state->cb(&sc[0], &chunk->pt[idx], offset + i, state->cbdata)) {
+            return 0;
+        }
+#ifdef USE_ENDOMORPHISM
+        secp256k1_ecmult_endo_split(&sc[0], &sc[1], &chunk->pt[idx], &chunk->pt[idx + 1]);
+#endif
+        for (k = 0; k < STREAM_ENTRIES_PER_POINT; k++) {
+            int *wnaf = &chunk->wnaf[idx * stride];
+            if (secp256k1_ge_is_infinity(&chunk->pt[idx])) {
+                secp256k1_scalar_set_int(&sc[k], 0);
+            }
+            wnaf[state->n_wnaf] = secp256k1_wnaf_fixed(wnaf, &sc[k], state->bucket_window+1);
+            idx++;
+        }
+    }
+    chunk->n_entries = idx;
+    return 1;
+}
+
+/* Adds the entries of chunk to the buckets of window i, using work for
+ * affine buckets. */
+static void secp256k1_ecmult_stream_accumulate(struct secp256k1_pippenger_stream_state *state, const struct secp256k1_pippenger_buckets *work, const struct secp256k1_pippenger_stream_chunk *chunk, size_t i) {
+    size_t n_buckets = ECMULT_TABLE_SIZE(state->bucket_window+2);
+    size_t stride = state->n_wnaf + 1;
+    size_t np;
+    size_t j;
+
+    if (i == 0) {
+        /* correct for wnaf skew */
+        for (np = 0; np < chunk->n_entries; np++) {
+            if (chunk->wnaf[np * stride + state->n_wnaf]) {
+                secp256k1_ge tmp;
+                secp256k1_ge_neg(&tmp, &chunk->pt[np]);
+                secp256k1_gej_add_ge_var(&state->skew, &state->skew, &tmp, NULL);
+            }
+        }
+    }
+
+    if (!secp256k1_pippenger_affine_buckets(state->bucket_window)) {
+        secp256k1_gej *buckets = &state->buckets[i * n_buckets];
+        for (np = 0; np < chunk->n_entries; np++) {
+            int n = chunk->wnaf[np * stride + i];
+            if (n > 0) {
+                secp256k1_gej_add_ge_var(&buckets[(n - 1)/2], &buckets[(n - 1)/2], &chunk->pt[np], NULL);
+            } else if (n < 0) {
+                secp256k1_ge tmp;
+                secp256k1_ge_neg(&tmp, &chunk->pt[np]);
+                secp256k1_gej_add_ge_var(&buckets[-(n + 1)/2], &buckets[-(n + 1)/2], &tmp, NULL);
+            }
+        }
+    } else {
+        /* Sort the current value of every bucket and the points that go into
+         * it like secp256k1_ecmult_pippenger_window_sum, and add them all up
+         * in affine coordinates. */
+        secp256k1_ge *buckets = &state->affine_buckets[i * n_buckets];
+        size_t pos = 0;
+
+        for (j = 0; j < n_buckets; j++) {
+            work->count[j] = !secp256k1_ge_is_infinity(&buckets[j]);
+        }
+        for (np = 0; np < chunk->n_entries; np++) {
+            int n = chunk->wnaf[np * stride + i];
+            if (n != 0) {
+                work->count[n > 0 ? (n - 1)/2 : -(n + 1)/2]++;
+            }
+        }
+        for (j = 0; j < n_buckets; j++) {
+            work->offset[j] = pos;
+            pos += work->count[j];
+            if (!secp256k1_ge_is_infinity(&buckets[j])) {
+                work->points[work->offset[j]++] = buckets[j];
+            }
+        }
+        for (np = 0; np < chunk->n_entries; np++) {
+            int n = chunk->wnaf[np * stride + i];
+            if (n > 0) {
+                work->points[work->offset[(n - 1)/2]++] = chunk->pt[np];
+            } else if (n < 0) {
+                secp256k1_ge_neg(&work->points[work->offset[-(n + 1)/2]++], &chunk->pt[np]);
+            }
+        }
+        for (j = 0; j < n_buckets; j++) {
+            work->offset[j] -= work->count[j];
+        }
+        secp256k1_ecmult_pippenger_affine_reduce(work, n_buckets, pos);
+        for (j = 0; j < n_buckets; j++) {
+            if (work->count[j] > 0) {
+                buckets[j] = work->points[work->offset[j]];
+            }
+        }
+    }
+}
+
+/* Work unit 0 fetches the next chunk, unit 1 + i adds the current chunk to
+ * the buckets of window i. Every unit only touches its own data, so the units
+ * can run concurrently. */
+static void secp256k1_ecmult_stream_task(void *task_data, size_t task) {
+    struct secp256k1_pippenger_stream_state *state = (struct secp256k1_pippenger_stream_state *) task_data;
+    size_t unit;
+
+    for (unit = task; unit <= state->n_wnaf; unit += state->n_tasks) {
+        if (unit == 0) {
+            if (state->next_points > 0) {
+                state->fetch_ok = secp256k1_ecmult_stream_fetch(state, state->next, state->next_offset, state->next_points);
+            }
+        } else if (state->current != NULL) {
+            secp256k1_ecmult_stream_accumulate(state, &state->work[task], state->current, unit - 1);
+        }
+    }
+}
+
+/* Adds up the buckets of every window like secp256k1_ecmult_pippenger_window_sum. */
+static void secp256k1_ecmult_stream_window_sum_task(void *task_data, size_t task) {
+    struct secp256k1_pippenger_stream_state *state = (struct secp256k1_pippenger_stream_state *) task_data;
+    size_t n_buckets = ECMULT_TABLE_SIZE(state->bucket_window+2);
+    int affine = secp256k1_pippenger_affine_buckets(state->bucket_window);
+    size_t i;
+
+    for (i = task; i < state->n_wnaf; i += state->n_tasks) {
+        secp256k1_gej *r = &state->window_sums[i];
+        secp256k1_gej running_sum;
+        size_t j;
+
+        secp256k1_gej_set_infinity(r);
+        secp256k1_gej_set_infinity(&running_sum);
+        for (j = n_buckets - 1; j > 0; j--) {
+            if (affine) {
+                secp256k1_gej_add_ge_var(&running_sum, &running_sum, &state->affine_buckets[i * n_buckets + j], NULL);
+            } else {
+                secp256k1_gej_add_var(&running_sum, &running_sum, &state->buckets[i * n_buckets + j], NULL);
+            }
+            secp256k1_gej_add_var(r, r, &running_sum, NULL);
+        }
+        if (affine) {
+            secp256k1_gej_add_ge_var(&running_sum, &running_sum, &state->affine_buckets[i * n_buckets], NULL);
+        } else {
+            secp256k1_gej_add_var(&running_sum, &running_sum, &state->buckets[i * n_buckets], NULL);
+        }
+        if (i == 0) {
+            secp256k1_gej_add_var(&running_sum, &running_sum, &state->skew, NULL);
+        }
+        secp256k1_gej_double_var(r, r, NULL);
+        secp256k1_gej_add_var(r, r, &running_sum, NULL);
+    }
+}
+
+/* Returns the scratch size of secp256k1_ecmult_multi_stream_var that does not
+ * depend on the chunk size, without considering alignment. */
+static size_t secp256k1_ecmult_stream_buckets_scratch_size(int bucket_window, size_t n_tasks) {
+    size_t n_wnaf = WNAF_SIZE(bucket_window+1);
+    size_t n_buckets = ECMULT_TABLE_SIZE(bucket_window+2);
+    size_t size = n_wnaf * sizeof(secp256k1_gej) + n_tasks * sizeof(struct secp256k1_pippenger_buckets);
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        return size + n_wnaf * n_buckets * sizeof(secp256k1_gej);
+    }
+    /* Every task also sorts the current values of the buckets */
+    return size + n_wnaf * n_buckets * sizeof(secp256k1_ge)
+        + n_tasks * (2 * n_buckets * sizeof(size_t) + n_buckets * sizeof(secp256k1_ge) + 3 * (n_buckets / 2 + 1) * sizeof(secp256k1_fe));
+}
+
+/* Returns the scratch size of secp256k1_ecmult_multi_stream_var per point of
+ * a chunk. */
+static size_t secp256k1_ecmult_stream_point_scratch_size(int bucket_window, size_t n_tasks, size_t n_chunks) {
+    size_t entry_size = n_chunks * (sizeof(secp256k1_ge) + (WNAF_SIZE(bucket_window+1) + 1) * sizeof(int));
+    if (secp256k1_pippenger_affine_buckets(bucket_window)) {
+        entry_size += n_tasks * (sizeof(secp256k1_ge) + (3 * sizeof(secp256k1_fe) + 1) / 2);
+    }
+    return STREAM_ENTRIES_PER_POINT * entry_size;
+}
+
+static int secp256k1_ecmult_multi_stream_var(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n, const secp256k1_ecmult_parallel *par) {
+    struct secp256k1_pippenger_stream_state state;
+    struct secp256k1_pippenger_stream_chunk chunks[2];
+    size_t n_threads = par != NULL && par->n_threads > 1 ? par->n_threads : 1;
+    size_t n_chunks = n_threads > 1 ? 2 : 1;
+    size_t max_alloc = secp256k1_scratch_max_allocation(scratch, PIPPENGER_SCRATCH_OBJECTS);
+    size_t fixed_size;
+    size_t chunk_points;
+    size_t n_buckets;
+    size_t offset;
+    size_t i;
+    int bucket_window;
+    int ret = 1;
+
+    secp256k1_gej_set_infinity(r);
+    if (n == 0) {
+        secp256k1_scalar szero;
+        secp256k1_scalar_set_int(&szero, 0);
+        secp256k1_ecmult(ctx, r, r, &szero, inp_g_sc);
+        return 1;
+    }
+
+    /* Use the largest window that is still worth it for n points and whose
+     * buckets take up at most half of the scratch space, and spend the rest
+     * on the chunks. */
+    for (bucket_window = secp256k1_pippenger_bucket_window(n); bucket_window > 0; bucket_window--) {
+        if (secp256k1_ecmult_stream_buckets_scratch_size(bucket_window, n_threads) <= max_alloc / 2) {
+            break;
+        }
+    }
+    if (bucket_window == 0) {
+        return 0;
+    }
+    fixed_size = secp256k1_ecmult_stream_buckets_scratch_size(bucket_window, n_threads);
+    chunk_points = (max_alloc - fixed_size) / secp256k1_ecmult_stream_point_scratch_size(bucket_window, n_threads, n_chunks);
+    if (chunk_points == 0) {
+        return 0;
+    }
+    if (chunk_points > n) {
+        chunk_points = n;
+    }
+
+    state.cb = cb;
+    state.cbdata = cbdata;
+    state.bucket_window = bucket_window;
+    state.n_wnaf = WNAF_SIZE(bucket_window+1);
+    state.n_tasks = n_threads;
+    n_buckets = ECMULT_TABLE_SIZE(bucket_window+2);
+    if (!secp256k1_scratch_allocate_frame(scratch, fixed_size + chunk_points * secp256k1_ecmult_stream_point_scratch_size(bucket_window, n_threads, n_chunks), PIPPENGER_SCRATCH_OBJECTS)) {
+        return 0;
+    }
+    state.window_sums = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, state.n_wnaf * sizeof(secp256k1_gej));
+    state.work = (struct secp256k1_pippenger_buckets *) secp256k1_scratch_alloc(scratch, n_threads * sizeof(struct secp256k1_pippenger_buckets));
+    if (!secp256k1_pippenger_affine_buckets(bucket_window)) {
+        state.buckets = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, state.n_wnaf * n_buckets * sizeof(secp256k1_gej));
+        for (i = 0; i < state.n_wnaf * n_buckets; i++) {
+            secp256k1_gej_set_infinity(&state.buckets[i]);
+        }
+    } else {
+        /* Every task reduces up to a chunk of entries and a set of buckets at once */
+        size_t work_points = chunk_points * STREAM_ENTRIES_PER_POINT + n_buckets;
+        secp256k1_ge *point_space = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, n_threads * work_points * sizeof(secp256k1_ge));
+        secp256k1_fe *fe_space = (secp256k1_fe *) secp256k1_scratch_alloc(scratch, n_threads * 3 * (work_points / 2) * sizeof(secp256k1_fe));
+        size_t *count_space = (size_t *) secp256k1_scratch_alloc(scratch, n_threads * 2 * n_buckets * sizeof(size_t));
+        for (i = 0; i < n_threads; i++) {
+            state.work[i].points = &point_space[i * work_points];
+            state.work[i].fe = &fe_space[i * 3 * (work_points / 2)];
+            state.work[i].offset = &count_space[2 * i * n_buckets];
+            state.work[i].count = &count_space[(2 * i + 1) * n_buckets];
+        }
+        state.affine_buckets = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, state.n_wnaf * n_buckets * sizeof(secp256k1_ge));
+        for (i = 0; i < state.n_wnaf * n_buckets; i++) {
+            secp256k1_ge_set_infinity(&state.affine_buckets[i]);
+        }
+    }
+    for (i = 0; i < n_chunks; i++) {
+        chunks[i].pt = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, chunk_points * STREAM_ENTRIES_PER_POINT * sizeof(secp256k1_ge));
+        chunks[i].wnaf = (int *) secp256k1_scratch_alloc(scratch, chunk_points * STREAM_ENTRIES_PER_POINT * (state.n_wnaf + 1) * sizeof(int));
+    }
+    secp256k1_gej_set_infinity(&state.skew);
+
+    if (n_threads == 1) {
+        for (offset = 0; offset < n; offset += chunk_points) {
+            size_t nbp = n - offset < chunk_points ? n - offset : chunk_points;
+            if (!secp256k1_ecmult_stream_fetch(&state, &chunks[0], offset, nbp)) {
+                ret = 0;
+                break;
+            }
+            for (i = 0; i < state.n_wnaf; i++) {
+                secp256k1_ecmult_stream_accumulate(&state, &state.work[0], &chunks[0], i);
+            }
+        }
+        if (ret) {
+            secp256k1_ecmult_stream_window_sum_task(&state, 0);
+        }
+    } else {
+        /* Fetch the next chunk while the current one is added to the buckets. */
+        state.current = NULL;
+        state.next = &chunks[0];
+        for (offset = 0; ret && (offset < n || state.current != NULL); offset += chunk_points) {
+            state.next_offset = offset;
+            state.next_points = offset < n ? (n - offset < chunk_points ? n - offset : chunk_points) : 0;
+            state.fetch_ok = 1;
+            ret = par->fn(secp256k1_ecmult_stream_task, &state, n_threads, par->data) && state.fetch_ok;
+            if (state.next_points > 0) {
+                state.current = state.next;
+                state.next = state.current == &chunks[0] ? &chunks[1] : &chunks[0];
+            } else {
+                state.current = NULL;
+            }
+        }
+        if (ret) {
+            ret = par->fn(secp256k1_ecmult_stream_window_sum_task, &state, n_threads, par->data);
+        }
+    }
+
+    if (ret) {
+        for (i = state.n_wnaf; i-- > 0; ) {
+            int j;
+            for (j = 0; j < bucket_window+1; j++) {
+                secp256k1_gej_double_var(r, r, NULL);
+            }
+            secp256k1_gej_add_var(r, r, &state.window_sums[i], NULL);
+        }
+        if (inp_g_sc != NULL) {
+            secp256k1_gej gj;
+            secp256k1_scalar szero;
+            secp256k1_scalar_set_int(&szero, 0);
+            secp256k1_gej_set_infinity(&gj);
+            secp256k1_ecmult(ctx, &gj, &gj, &szero, inp_g_sc);
+            secp256k1_gej_add_var(r, r, &gj, NULL);
+        }
+    }
+    secp256k1_scratch_deallocate_frame(scratch);
+    return ret;
+}
+
 #endif /* SECP256K1_ECMULT_IMPL_H */
@@ -0,0 +1,92 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_FIELD_X4_H
+#define SECP256K1_FIELD_X4_H
+
+#if defined HAVE_CONFIG_H
+#include "libsecp256k1-config.h"
+#endif
+
+#include "field.h"
+
+/* The four-way field backend is built on x86_64 with GCC-compatible compilers
+ * that can compile AVX2 code through a target attribute. Callers must check that
+ * secp256k1_cpu_features() reports SECP256K1_CPU_AVX2 before using any of the
+ * functions below. */
+#if defined(__GNUC__) && defined(__x86_64__) && \
+    (defined(__AVX2__) || defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define SECP256K1_FIELD_X4 1
+#  include <immintrin.h>
+#  ifdef __AVX2__
+#    define SECP256K1_TARGET_AVX2
+#  else
+#    define SECP256K1_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+#ifdef SECP256K1_FIELD_X4
+
+/** Four independent field elements, in the representation of field_10x26.h:
+ *  limb i of element k is in 64-bit lane k of n[i], and each element is
+ *  sum(i=0..9, n[i] << (i*26)) mod p. The magnitude bounds and the normalized
+ *  condition of field_10x26.h apply to every lane, and all lanes share one
+ *  magnitude. Every operation takes the same time for all values.
+ */
+typedef struct {
+    __m256i n[10];
+#ifdef VERIFY
+    int magnitude;
+    int normalized;
+#endif
+} secp256k1_fe_x4;
+
+/** Set r to the four elements a[0..3]. The output is normalized. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_fe(secp256k1_fe_x4 *r, const secp256k1_fe *a);
+
+/** Set r to the four elements of storage a[0..3]. The output is normalized. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_storage(secp256k1_fe_x4 *r, const secp256k1_fe_storage *a0, const secp256k1_fe_storage *a1, const secp256k1_fe_storage *a2, const secp256k1_fe_storage *a3);
+
+/** Set r[0..3] to the four elements of a. The outputs are normalized. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_get_fe(secp256k1_fe *r, const secp256k1_fe_x4 *a);
+
+/** Set all four elements of r to the small integer a. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_int(secp256k1_fe_x4 *r, int a);
+
+/** Normalize all four elements. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalize(secp256k1_fe_x4 *r);
+
+/** Weakly normalize all four elements: reduce the magnitude to 1. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalize_weak(secp256k1_fe_x4 *r);
+
+/** Set mask to all ones in every lane whose element normalizes to zero, and to zero
+ *  in the other lanes. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalizes_to_zero(__m256i *mask, const secp256k1_fe_x4 *r);
+
+/** Set r to -a, where a has magnitude at most m. The output has magnitude m+1. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_negate(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, int m);
+
+/** Multiply all four elements by a small integer. The magnitude is multiplied by a. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_mul_int(secp256k1_fe_x4 *r, int a);
+
+/** Add a to r lane by lane. The magnitudes add up. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_add(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a);
+
+/** Multiply a and b lane by lane. Both inputs must have magnitude at most 8; the
+ *  output has magnitude 1. r may alias a or b. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_mul(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, const secp256k1_fe_x4 *b);
+
+/** Square a lane by lane. The input must have magnitude at most 8; the output
+ *  has magnitude 1. r may alias a. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_sqr(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a);
+
+/** Replace r's elements with a's in the lanes where mask is all ones. mask must be
+ *  all ones or all zeros in every lane. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_cmov(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, const __m256i *mask);
+
+#endif /* SECP256K1_FIELD_X4 */
+
+#endif /* SECP256K1_FIELD_X4_H */
@@ -0,0 +1,455 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_FIELD_X4_IMPL_H
+#define SECP256K1_FIELD_X4_IMPL_H
+
+#include <string.h>
+
+#include "util.h"
+#include "field_x4.h"
+
+#ifdef SECP256K1_FIELD_X4
+
+/* The 10x26 representation in 64-bit lanes: _mm256_mul_epu32 multiplies the low
+ * 32 bits of every lane into a 64-bit product, which holds any product of two
+ * limbs of magnitude at most 8 (below 2^30 each) and a sum of ten of them. */
+
+#ifdef VERIFY
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_verify(const secp256k1_fe_x4 *a) {
+    uint64_t d[10][4];
+    int i, k;
+    int m = a->normalized ? 1 : 2 * a->magnitude;
+    for (i = 0; i < 10; i++) {
+        _mm256_storeu_si256((__m256i *)d[i], a->n[i]);
+    }
+    VERIFY_CHECK(a->magnitude >= 0);
+    VERIFY_CHECK(a->magnitude <= 32);
+    for (k = 0; k < 4; k++) {
+        int r = 1;
+        for (i = 0; i < 9; i++) {
+            r &= (d[i][k] <= 0x3FFFFFFULL * m);
+        }
+        r &= (d[9][k] <= 0x03FFFFFULL * m);
+        if (a->normalized) {
+            r &= (a->magnitude <= 1);
+            if (r && (d[9][k] == 0x03FFFFFULL)) {
+                uint64_t mid = d[8][k] & d[7][k] & d[6][k] & d[5][k] & d[4][k] & d[3][k] & d[2][k];
+                if (mid == 0x3FFFFFFULL) {
+                    r &= ((d[1][k] + 0x40ULL + ((d[0][k] + 0x3D1ULL) >> 26)) <= 0x3FFFFFFULL);
+                }
+            }
+        }
+        VERIFY_CHECK(r == 1);
+    }
+}
+#endif
+
+/** Set r from four 256-bit values given as little-endian 64-bit words, one
+ *  value per lane. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_words(secp256k1_fe_x4 *r, const uint64_t (*w)[4]) {
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i d0 = _mm256_set_epi64x(w[3][0], w[2][0], w[1][0], w[0][0]);
+    __m256i d1 = _mm256_set_epi64x(w[3][1], w[2][1], w[1][1], w[0][1]);
+    __m256i d2 = _mm256_set_epi64x(w[3][2], w[2][2], w[1][2], w[0][2]);
+    __m256i d3 = _mm256_set_epi64x(w[3][3], w[2][3], w[1][3], w[0][3]);
+
+    r->n[0] = _mm256_and_si256(d0, M26);
+    r->n[1] = _mm256_and_si256(_mm256_srli_epi64(d0, 26), M26);
+    r->n[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(d0, 52), _mm256_slli_epi64(d1, 12)), M26);
+    r->n[3] = _mm256_and_si256(_mm256_srli_epi64(d1, 14), M26);
+    r->n[4] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(d1, 40), _mm256_slli_epi64(d2, 24)), M26);
+    r->n[5] = _mm256_and_si256(_mm256_srli_epi64(d2, 2), M26);
+    r->n[6] = _mm256_and_si256(_mm256_srli_epi64(d2, 28), M26);
+    r->n[7] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(d2, 54), _mm256_slli_epi64(d3, 10)), M26);
+    r->n[8] = _mm256_and_si256(_mm256_srli_epi64(d3, 16), M26);
+    r->n[9] = _mm256_srli_epi64(d3, 42);
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 1;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_storage(secp256k1_fe_x4 *r, const secp256k1_fe_storage *a0, const secp256k1_fe_storage *a1, const secp256k1_fe_storage *a2, const secp256k1_fe_storage *a3) {
+    /* Both storage layouts hold the value as little-endian limbs, so on x86 their
+     * bytes are the four little-endian 64-bit words of the value. */
+    uint64_t w[4][4];
+    VERIFY_CHECK(sizeof(secp256k1_fe_storage) == sizeof(w[0]));
+    memcpy(w[0], a0, sizeof(w[0]));
+    memcpy(w[1], a1, sizeof(w[1]));
+    memcpy(w[2], a2, sizeof(w[2]));
+    memcpy(w[3], a3, sizeof(w[3]));
+    secp256k1_fe_x4_set_words(r, (const uint64_t (*)[4])w);
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_fe(secp256k1_fe_x4 *r, const secp256k1_fe *a) {
+    secp256k1_fe_storage s[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+        secp256k1_fe t = a[k];
+        secp256k1_fe_normalize(&t);
+        secp256k1_fe_to_storage(&s[k], &t);
+    }
+    secp256k1_fe_x4_set_storage(r, &s[0], &s[1], &s[2], &s[3]);
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_get_fe(secp256k1_fe *r, const secp256k1_fe_x4 *a) {
+    secp256k1_fe_x4 t = *a;
+    secp256k1_fe_storage s;
+    uint64_t w[4][4];
+    int k;
+    secp256k1_fe_x4_normalize(&t);
+    _mm256_storeu_si256((__m256i *)w[0], _mm256_or_si256(_mm256_or_si256(t.n[0], _mm256_slli_epi64(t.n[1], 26)), _mm256_slli_epi64(t.n[2], 52)));
+    _mm256_storeu_si256((__m256i *)w[1], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(t.n[2], 12), _mm256_slli_epi64(t.n[3], 14)), _mm256_slli_epi64(t.n[4], 40)));
+    _mm256_storeu_si256((__m256i *)w[2], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(t.n[4], 24), _mm256_slli_epi64(t.n[5], 2)),
+                                                         _mm256_or_si256(_mm256_slli_epi64(t.n[6], 28), _mm256_slli_epi64(t.n[7], 54))));
+    _mm256_storeu_si256((__m256i *)w[3], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(t.n[7], 10), _mm256_slli_epi64(t.n[8], 16)), _mm256_slli_epi64(t.n[9], 42)));
+    for (k = 0; k < 4; k++) {
+        uint64_t v[4];
+        v[0] = w[0][k];
+        v[1] = w[1][k];
+        v[2] = w[2][k];
+        v[3] = w[3][k];
+        memcpy(&s, v, sizeof(s));
+        secp256k1_fe_from_storage(&r[k], &s);
+    }
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_set_int(secp256k1_fe_x4 *r, int a) {
+    int i;
+    r->n[0] = _mm256_set1_epi64x(a);
+    for (i = 1; i < 10; i++) {
+        r->n[i] = _mm256_setzero_si256();
+    }
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 1;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+/** Carry t[0..9] into 26-bit limbs (22 bits for the top one), after reducing the
+ *  top limb so that at most a carry into bit 22 of t[9] remains. */
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_carry(__m256i *t) {
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i M22 = _mm256_set1_epi64x(0x03FFFFF);
+    __m256i x = _mm256_srli_epi64(t[9], 22);
+    int i;
+    t[9] = _mm256_and_si256(t[9], M22);
+    t[0] = _mm256_add_epi64(t[0], _mm256_mul_epu32(x, _mm256_set1_epi64x(0x3D1)));
+    t[1] = _mm256_add_epi64(t[1], _mm256_slli_epi64(x, 6));
+    for (i = 0; i < 9; i++) {
+        t[i + 1] = _mm256_add_epi64(t[i + 1], _mm256_srli_epi64(t[i], 26));
+        t[i] = _mm256_and_si256(t[i], M26);
+    }
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalize_weak(secp256k1_fe_x4 *r) {
+    /* With magnitude at most 32 every limb is below 2^32, so a single carry pass
+     * over all limbs at once leaves them below 2^26 + 2^21, within magnitude 1;
+     * a full carry chain is only needed for normalize. */
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i M22 = _mm256_set1_epi64x(0x03FFFFF);
+    __m256i *t = r->n;
+    __m256i x = _mm256_srli_epi64(t[9], 22);
+    int i;
+#ifdef VERIFY
+    secp256k1_fe_x4_verify(r);
+#endif
+    t[9] = _mm256_add_epi64(_mm256_and_si256(t[9], M22), _mm256_srli_epi64(t[8], 26));
+    for (i = 8; i > 1; i--) {
+        t[i] = _mm256_add_epi64(_mm256_and_si256(t[i], M26), _mm256_srli_epi64(t[i - 1], 26));
+    }
+    t[1] = _mm256_add_epi64(_mm256_add_epi64(_mm256_and_si256(t[1], M26), _mm256_srli_epi64(t[0], 26)), _mm256_slli_epi64(x, 6));
+    t[0] = _mm256_add_epi64(_mm256_and_si256(t[0], M26), _mm256_mul_epu32(x, _mm256_set1_epi64x(0x3D1)));
+#ifdef VERIFY
+    r->magnitude = 1;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalize(secp256k1_fe_x4 *r) {
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i M22 = _mm256_set1_epi64x(0x03FFFFF);
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i *t = r->n;
+    __m256i m, x, ge;
+    int i;
+
+    /* The first pass ensures the magnitude is 1, except for a possible carry at
+     * bit 22 of t[9] (i.e. bit 256 of the field element). */
+    secp256k1_fe_x4_carry(t);
+    m = t[2];
+    for (i = 3; i < 9; i++) {
+        m = _mm256_and_si256(m, t[i]);
+    }
+
+    /* At most a single final reduction is needed; check if the value is >= the
+     * field characteristic. */
+    ge = _mm256_and_si256(_mm256_cmpeq_epi64(t[9], M22), _mm256_cmpeq_epi64(m, M26));
+    ge = _mm256_and_si256(ge, _mm256_cmpgt_epi64(
+        _mm256_add_epi64(_mm256_add_epi64(t[1], _mm256_set1_epi64x(0x40)),
+                         _mm256_srli_epi64(_mm256_add_epi64(t[0], _mm256_set1_epi64x(0x3D1)), 26)),
+        M26));
+    x = _mm256_or_si256(_mm256_srli_epi64(t[9], 22), _mm256_and_si256(ge, one));
+
+    /* Apply the final reduction (for constant-time behaviour, we do it always) and
+     * mask off the possible multiple of 2^256. */
+    t[0] = _mm256_add_epi64(t[0], _mm256_mul_epu32(x, _mm256_set1_epi64x(0x3D1)));
+    t[1] = _mm256_add_epi64(t[1], _mm256_slli_epi64(x, 6));
+    for (i = 0; i < 9; i++) {
+        t[i + 1] = _mm256_add_epi64(t[i + 1], _mm256_srli_epi64(t[i], 26));
+        t[i] = _mm256_and_si256(t[i], M26);
+    }
+    t[9] = _mm256_and_si256(t[9], M22);
+
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 1;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_normalizes_to_zero(__m256i *mask, const secp256k1_fe_x4 *r) {
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i t[10];
+    __m256i z0, z1;
+    int i;
+#ifdef VERIFY
+    secp256k1_fe_x4_verify(r);
+#endif
+    for (i = 0; i < 10; i++) {
+        t[i] = r->n[i];
+    }
+    secp256k1_fe_x4_carry(t);
+
+    /* z0 tracks a possible raw value of 0, z1 tracks a possible raw value of P. */
+    z0 = t[0];
+    z1 = _mm256_xor_si256(t[0], _mm256_set1_epi64x(0x3D0));
+    z0 = _mm256_or_si256(z0, t[1]);
+    z1 = _mm256_and_si256(z1, _mm256_xor_si256(t[1], _mm256_set1_epi64x(0x40)));
+    for (i = 2; i < 9; i++) {
+        z0 = _mm256_or_si256(z0, t[i]);
+        z1 = _mm256_and_si256(z1, t[i]);
+    }
+    z0 = _mm256_or_si256(z0, t[9]);
+    z1 = _mm256_and_si256(z1, _mm256_xor_si256(t[9], _mm256_set1_epi64x(0x3C00000)));
+
+    *mask = _mm256_or_si256(_mm256_cmpeq_epi64(z0, _mm256_setzero_si256()), _mm256_cmpeq_epi64(z1, M26));
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_negate(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, int m) {
+    const uint64_t f = 2 * (m + 1);
+    int i;
+#ifdef VERIFY
+    VERIFY_CHECK(a->magnitude <= m);
+    secp256k1_fe_x4_verify(a);
+#endif
+    r->n[0] = _mm256_sub_epi64(_mm256_set1_epi64x(0x3FFFC2FULL * f), a->n[0]);
+    r->n[1] = _mm256_sub_epi64(_mm256_set1_epi64x(0x3FFFFBFULL * f), a->n[1]);
+    for (i = 2; i < 9; i++) {
+        r->n[i] = _mm256_sub_epi64(_mm256_set1_epi64x(0x3FFFFFFULL * f), a->n[i]);
+    }
+    r->n[9] = _mm256_sub_epi64(_mm256_set1_epi64x(0x03FFFFFULL * f), a->n[9]);
+#ifdef VERIFY
+    r->magnitude = m + 1;
+    r->normalized = 0;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_mul_int(secp256k1_fe_x4 *r, int a) {
+    const __m256i f = _mm256_set1_epi64x(a);
+    int i;
+    for (i = 0; i < 10; i++) {
+        r->n[i] = _mm256_mul_epu32(r->n[i], f);
+    }
+#ifdef VERIFY
+    r->magnitude *= a;
+    r->normalized = 0;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_add(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a) {
+    int i;
+#ifdef VERIFY
+    secp256k1_fe_x4_verify(a);
+#endif
+    for (i = 0; i < 10; i++) {
+        r->n[i] = _mm256_add_epi64(r->n[i], a->n[i]);
+    }
+#ifdef VERIFY
+    r->magnitude += a->magnitude;
+    r->normalized = 0;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+/** Reduce the 19 columns c[0..18] of a product into r.
+ *
+ *  With both inputs of magnitude at most 8, every limb is below 2^30 and the
+ *  top ones below 2^26, so each column fits in 64 bits and the product is
+ *  below 2^521. Two carry passes across all columns at once bring every column
+ *  below 2^27 without a serial carry chain. The columns at and above 2^260 are
+ *  then folded down using 2^260 = 0x3D10 + 0x400 * 2^26 (mod p), which leaves
+ *  every limb below 2^42, and one more parallel carry pass plus a reduction of
+ *  bits 256 and up gives magnitude 1.
+ */
+SECP256K1_TARGET_AVX2 static SECP256K1_INLINE void secp256k1_fe_x4_reduce(__m256i *r, const __m256i *c) {
+    const __m256i M26 = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i M22 = _mm256_set1_epi64x(0x03FFFFF);
+    const __m256i R0 = _mm256_set1_epi64x(0x3D10);
+    const __m256i R1 = _mm256_set1_epi64x(0x400);
+    __m256i u[20], t[20], s[10], e, elo, ehi, x;
+    int i;
+
+    u[0] = _mm256_and_si256(c[0], M26);
+    for (i = 1; i < 19; i++) {
+        u[i] = _mm256_add_epi64(_mm256_and_si256(c[i], M26), _mm256_srli_epi64(c[i - 1], 26));
+    }
+    u[19] = _mm256_srli_epi64(c[18], 26);
+    t[0] = _mm256_and_si256(u[0], M26);
+    for (i = 1; i < 19; i++) {
+        t[i] = _mm256_add_epi64(_mm256_and_si256(u[i], M26), _mm256_srli_epi64(u[i - 1], 26));
+    }
+    /* Keep what would carry out of t[19] in t[19] itself: the product bound
+     * keeps t[19] below 2^27 either way. */
+    t[19] = _mm256_add_epi64(u[19], _mm256_srli_epi64(u[18], 26));
+
+    /* t[19] * 2^494 = t[19] * 2^234 * (0x3D10 + 0x400 * 2^26): the second part lands
+     * at 2^260, where it is split into 26-bit halves and folded once more. */
+    e = _mm256_mul_epu32(t[19], R1);
+    elo = _mm256_and_si256(e, M26);
+    ehi = _mm256_srli_epi64(e, 26);
+
+    s[0] = _mm256_add_epi64(t[0], _mm256_mul_epu32(_mm256_add_epi64(t[10], elo), R0));
+    s[1] = _mm256_add_epi64(_mm256_add_epi64(t[1], _mm256_mul_epu32(_mm256_add_epi64(t[11], ehi), R0)),
+                            _mm256_mul_epu32(_mm256_add_epi64(t[10], elo), R1));
+    s[2] = _mm256_add_epi64(_mm256_add_epi64(t[2], _mm256_mul_epu32(t[12], R0)),
+                            _mm256_mul_epu32(_mm256_add_epi64(t[11], ehi), R1));
+    for (i = 3; i < 9; i++) {
+        s[i] = _mm256_add_epi64(_mm256_add_epi64(t[i], _mm256_mul_epu32(t[i + 10], R0)),
+                                _mm256_mul_epu32(t[i + 9], R1));
+    }
+    s[9] = _mm256_add_epi64(_mm256_add_epi64(t[9], _mm256_mul_epu32(t[19], R0)),
+                            _mm256_mul_epu32(t[18], R1));
+
+    /* Every s[i] is below 2^42, so after one carry pass r[1..8] are below
+     * 2^26 + 2^16 and r[9] below 2^22 + 2^16. The bits of s[9] from 22 on are
+     * below 2^20; folding them into r[0] and r[1] and carrying r[0] once leaves
+     * r[1] below 1.6 * 2^26, within magnitude 1. */
+    x = _mm256_srli_epi64(s[9], 22);
+    r[0] = _mm256_add_epi64(_mm256_and_si256(s[0], M26), _mm256_mul_epu32(x, _mm256_set1_epi64x(0x3D1)));
+    r[1] = _mm256_add_epi64(_mm256_add_epi64(_mm256_and_si256(s[1], M26), _mm256_srli_epi64(s[0], 26)), _mm256_slli_epi64(x, 6));
+    for (i = 2; i < 9; i++) {
+        r[i] = _mm256_add_epi64(_mm256_and_si256(s[i], M26), _mm256_srli_epi64(s[i - 1], 26));
+    }
+    r[9] = _mm256_add_epi64(_mm256_and_si256(s[9], M22), _mm256_srli_epi64(s[8], 26));
+    r[1] = _mm256_add_epi64(r[1], _mm256_srli_epi64(r[0], 26));
+    r[0] = _mm256_and_si256(r[0], M26);
+}
+
+#define MUL(x, y) _mm256_mul_epu32(x, y)
+#define ADD(x, y) _mm256_add_epi64(x, y)
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_mul(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, const secp256k1_fe_x4 *b) {
+    __m256i c[19];
+    const __m256i a0 = a->n[0], a1 = a->n[1], a2 = a->n[2], a3 = a->n[3], a4 = a->n[4],
+                  a5 = a->n[5], a6 = a->n[6], a7 = a->n[7], a8 = a->n[8], a9 = a->n[9];
+    const __m256i b0 = b->n[0], b1 = b->n[1], b2 = b->n[2], b3 = b->n[3], b4 = b->n[4],
+                  b5 = b->n[5], b6 = b->n[6], b7 = b->n[7], b8 = b->n[8], b9 = b->n[9];
+#ifdef VERIFY
+    VERIFY_CHECK(a->magnitude <= 8);
+    VERIFY_CHECK(b->magnitude <= 8);
+    secp256k1_fe_x4_verify(a);
+    secp256k1_fe_x4_verify(b);
+#endif
+    c[0] = MUL(a0, b0);
+    c[1] = ADD(MUL(a0, b1), MUL(a1, b0));
+    c[2] = ADD(MUL(a0, b2), ADD(MUL(a1, b1), MUL(a2, b0)));
+    c[3] = ADD(ADD(MUL(a0, b3), MUL(a1, b2)), ADD(MUL(a2, b1), MUL(a3, b0)));
+    c[4] = ADD(ADD(MUL(a0, b4), MUL(a1, b3)), ADD(MUL(a2, b2), ADD(MUL(a3, b1), MUL(a4, b0))));
+    c[5] = ADD(ADD(MUL(a0, b5), ADD(MUL(a1, b4), MUL(a2, b3))), ADD(MUL(a3, b2), ADD(MUL(a4, b1), MUL(a5, b0))));
+    c[6] = ADD(ADD(MUL(a0, b6), ADD(MUL(a1, b5), MUL(a2, b4))), ADD(ADD(MUL(a3, b3), MUL(a4, b2)), ADD(MUL(a5, b1), MUL(a6, b0))));
+    c[7] = ADD(ADD(ADD(MUL(a0, b7), MUL(a1, b6)), ADD(MUL(a2, b5), MUL(a3, b4))), ADD(ADD(MUL(a4, b3), MUL(a5, b2)), ADD(MUL(a6, b1), MUL(a7, b0))));
+    c[8] = ADD(ADD(ADD(MUL(a0, b8), MUL(a1, b7)), ADD(MUL(a2, b6), MUL(a3, b5))), ADD(ADD(MUL(a4, b4), MUL(a5, b3)), ADD(MUL(a6, b2), ADD(MUL(a7, b1), MUL(a8, b0)))));
+    c[9] = ADD(ADD(ADD(MUL(a0, b9), MUL(a1, b8)), ADD(MUL(a2, b7), ADD(MUL(a3, b6), MUL(a4, b5)))), ADD(ADD(MUL(a5, b4), MUL(a6, b3)), ADD(MUL(a7, b2), ADD(MUL(a8, b1), MUL(a9, b0)))));
+    c[10] = ADD(ADD(ADD(MUL(a1, b9), MUL(a2, b8)), ADD(MUL(a3, b7), MUL(a4, b6))), ADD(ADD(MUL(a5, b5), MUL(a6, b4)), ADD(MUL(a7, b3), ADD(MUL(a8, b2), MUL(a9, b1)))));
+    c[11] = ADD(ADD(ADD(MUL(a2, b9), MUL(a3, b8)), ADD(MUL(a4, b7), MUL(a5, b6))), ADD(ADD(MUL(a6, b5), MUL(a7, b4)), ADD(MUL(a8, b3), MUL(a9, b2))));
+    c[12] = ADD(ADD(MUL(a3, b9), ADD(MUL(a4, b8), MUL(a5, b7))), ADD(ADD(MUL(a6, b6), MUL(a7, b5)), ADD(MUL(a8, b4), MUL(a9, b3))));
+    c[13] = ADD(ADD(MUL(a4, b9), ADD(MUL(a5, b8), MUL(a6, b7))), ADD(MUL(a7, b6), ADD(MUL(a8, b5), MUL(a9, b4))));
+    c[14] = ADD(ADD(MUL(a5, b9), MUL(a6, b8)), ADD(MUL(a7, b7), ADD(MUL(a8, b6), MUL(a9, b5))));
+    c[15] = ADD(ADD(MUL(a6, b9), MUL(a7, b8)), ADD(MUL(a8, b7), MUL(a9, b6)));
+    c[16] = ADD(MUL(a7, b9), ADD(MUL(a8, b8), MUL(a9, b7)));
+    c[17] = ADD(MUL(a8, b9), MUL(a9, b8));
+    c[18] = MUL(a9, b9);
+    secp256k1_fe_x4_reduce(r->n, c);
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 0;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_sqr(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a) {
+    __m256i c[19];
+    const __m256i a0 = a->n[0], a1 = a->n[1], a2 = a->n[2], a3 = a->n[3], a4 = a->n[4],
+                  a5 = a->n[5], a6 = a->n[6], a7 = a->n[7], a8 = a->n[8], a9 = a->n[9];
+    /* d[i] = 2*a[i], for the products that appear twice in a column. */
+    const __m256i d0 = ADD(a0, a0), d1 = ADD(a1, a1), d2 = ADD(a2, a2), d3 = ADD(a3, a3), d4 = ADD(a4, a4),
+                  d5 = ADD(a5, a5), d6 = ADD(a6, a6), d7 = ADD(a7, a7), d8 = ADD(a8, a8);
+#ifdef VERIFY
+    VERIFY_CHECK(a->magnitude <= 8);
+    secp256k1_fe_x4_verify(a);
+#endif
+    c[0] = MUL(a0, a0);
+    c[1] = MUL(d0, a1);
+    c[2] = ADD(MUL(a1, a1), MUL(d0, a2));
+    c[3] = ADD(MUL(d0, a3), MUL(d1, a2));
+    c[4] = ADD(MUL(a2, a2), ADD(MUL(d0, a4), MUL(d1, a3)));
+    c[5] = ADD(MUL(d0, a5), ADD(MUL(d1, a4), MUL(d2, a3)));
+    c[6] = ADD(ADD(MUL(a3, a3), MUL(d0, a6)), ADD(MUL(d1, a5), MUL(d2, a4)));
+    c[7] = ADD(ADD(MUL(d0, a7), MUL(d1, a6)), ADD(MUL(d2, a5), MUL(d3, a4)));
+    c[8] = ADD(ADD(MUL(a4, a4), MUL(d0, a8)), ADD(MUL(d1, a7), ADD(MUL(d2, a6), MUL(d3, a5))));
+    c[9] = ADD(ADD(MUL(d0, a9), MUL(d1, a8)), ADD(MUL(d2, a7), ADD(MUL(d3, a6), MUL(d4, a5))));
+    c[10] = ADD(ADD(MUL(a5, a5), MUL(d1, a9)), ADD(MUL(d2, a8), ADD(MUL(d3, a7), MUL(d4, a6))));
+    c[11] = ADD(ADD(MUL(d2, a9), MUL(d3, a8)), ADD(MUL(d4, a7), MUL(d5, a6)));
+    c[12] = ADD(ADD(MUL(a6, a6), MUL(d3, a9)), ADD(MUL(d4, a8), MUL(d5, a7)));
+    c[13] = ADD(MUL(d4, a9), ADD(MUL(d5, a8), MUL(d6, a7)));
+    c[14] = ADD(MUL(a7, a7), ADD(MUL(d5, a9), MUL(d6, a8)));
+    c[15] = ADD(MUL(d6, a9), MUL(d7, a8));
+    c[16] = ADD(MUL(a8, a8), MUL(d7, a9));
+    c[17] = MUL(d8, a9);
+    c[18] = MUL(a9, a9);
+    secp256k1_fe_x4_reduce(r->n, c);
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 0;
+    secp256k1_fe_x4_verify(r);
+#endif
+}
+
+#undef MUL
+#undef ADD
+
+SECP256K1_TARGET_AVX2 static void secp256k1_fe_x4_cmov(secp256k1_fe_x4 *r, const secp256k1_fe_x4 *a, const __m256i *mask) {
+    int i;
+    for (i = 0; i < 10; i++) {
+        r->n[i] = _mm256_blendv_epi8(r->n[i], a->n[i], *mask);
+    }
+#ifdef VERIFY
+    if (a->magnitude > r->magnitude) {
+        r->magnitude = a->magnitude;
+    }
+    r->normalized &= a->normalized;
+#endif
+}
+
+#endif /* SECP256K1_FIELD_X4 */
+
+#endif /* SECP256K1_FIELD_X4_IMPL_H */
@@ -12,6 +12,13 @@
 #include "scalar_impl.h"
 #include "group_impl.h"
 #include "ecmult_gen_impl.h"
+#include "ecmult_impl.h"
+
+/* The verification tables are emitted for the largest window used by any
+ * configuration: pre_g for WINDOW_G 16 (whose first half is the table for
+ * WINDOW_G 15), and pre_g_128 for WINDOW_G 15, as used with the endomorphism. */
+#define PRE_G_WINDOW 16
+#define PRE_G_128_WINDOW 15
 
 static void default_error_callback_fn(const char* str, void* data) {
     (void)data;
@@ -24,6 +31,20 @@ static const secp256k1_callback default_error_callback = {
     NULL
 };
 
+static void print_table(FILE *fp, const char *name, const secp256k1_ge_storage *table, int n) {
+    int i;
+    fprintf(fp, "static const secp256k1_ge_storage %s[%d] = {\n", name, n);
+    for(i = 0; i != n; i++) {
+        fprintf(fp,"    SC(%uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu)", SECP256K1_GE_STORAGE_CONST_GET(table[i]));
+        if (i != n - 1) {
+            fprintf(fp,",\n");
+        } else {
+            fprintf(fp,"\n");
+        }
+    }
+    fprintf(fp,"};\n");
+}
+
 int main(int argc, char **argv) {
     secp256k1_ecmult_gen_context ctx;
     int inner;
@@ -43,21 +64,24 @@ int main(int argc, char **argv) {
     fprintf(fp, "#define _SECP256K1_ECMULT_STATIC_CONTEXT_\n");
     fprintf(fp, "#include \"src/group.h\"\n");
     fprintf(fp, "#define SC SECP256K1_GE_STORAGE_CONST\n");
-    fprintf(fp, "static const secp256k1_ge_storage secp256k1_ecmult_static_context[64][16] = {\n");
+    fprintf(fp, "#if ECMULT_GEN_PREC_N != %d || ECMULT_GEN_PREC_G != %d\n", ECMULT_GEN_PREC_N, ECMULT_GEN_PREC_G);
+    fprintf(fp, "   #error configuration mismatch, invalid ECMULT_GEN_PREC_N, ECMULT_GEN_PREC_G. Try deleting ecmult_static_context.h before the build.\n");
+    fprintf(fp, "#endif\n");
+    fprintf(fp, "static const secp256k1_ge_storage secp256k1_ecmult_static_context[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G] = {\n");
 
     secp256k1_ecmult_gen_context_init(&ctx);
     secp256k1_ecmult_gen_context_build(&ctx, &default_error_callback);
-    for(outer = 0; outer != 64; outer++) {
+    for(outer = 0; outer != ECMULT_GEN_PREC_N; outer++) {
         fprintf(fp,"{\n");
-        for(inner = 0; inner != 16; inner++) {
+        for(inner = 0; inner != ECMULT_GEN_PREC_G; inner++) {
             fprintf(fp,"    SC(%uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu)", SECP256K1_GE_STORAGE_CONST_GET((*ctx.prec)[outer][inner]));
-            if (inner != 15) {
+            if (inner != ECMULT_GEN_PREC_G - 1) {
                 fprintf(fp,",\n");
             } else {
                 fprintf(fp,"\n");
             }
         }
-        if (outer != 63) {
+        if (outer != ECMULT_GEN_PREC_N - 1) {
             fprintf(fp,"},\n");
         } else {
             fprintf(fp,"}\n");
@@ -69,6 +93,42 @@ int main(int argc, char **argv) {
     fprintf(fp, "#undef SC\n");
     fprintf(fp, "#endif\n");
     fclose(fp);
-    
+
+    /* Written after ecmult_static_context.h, which the build relies on to
+     * consider both files up to date. */
+    fp = fopen("src/ecmult_static_pre_g.h","w");
+    if (fp == NULL) {
+        fprintf(stderr, "Could not open src/ecmult_static_pre_g.h for writing!\n");
+        return -1;
+    }
+
+    fprintf(fp, "#ifndef _SECP256K1_ECMULT_STATIC_PRE_G_\n");
+    fprintf(fp, "#define _SECP256K1_ECMULT_STATIC_PRE_G_\n");
+    fprintf(fp, "#include \"src/group.h\"\n");
+    fprintf(fp, "#define SC SECP256K1_GE_STORAGE_CONST\n");
+    fprintf(fp, "#define ECMULT_STATIC_PRE_G_WINDOW %d\n", PRE_G_WINDOW);
+    fprintf(fp, "#define ECMULT_STATIC_PRE_G_128_WINDOW %d\n", PRE_G_128_WINDOW);
+    {
+        secp256k1_ge_storage *table = (secp256k1_ge_storage *)checked_malloc(&default_error_callback, sizeof(*table) * ECMULT_TABLE_SIZE(PRE_G_WINDOW));
+        secp256k1_gej gj;
+        int i;
+
+        secp256k1_gej_set_ge(&gj, &secp256k1_ge_const_g);
+        secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(PRE_G_WINDOW), table, &gj);
+        print_table(fp, "secp256k1_ecmult_static_pre_g", table, ECMULT_TABLE_SIZE(PRE_G_WINDOW));
+
+        for (i = 0; i < 128; i++) {
+            secp256k1_gej_double_var(&gj, &gj, NULL);
+        }
+        secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(PRE_G_128_WINDOW), table, &gj);
+        fprintf(fp, "#ifdef USE_ENDOMORPHISM\n");
+        print_table(fp, "secp256k1_ecmult_static_pre_g_128", table, ECMULT_TABLE_SIZE(PRE_G_128_WINDOW));
+        fprintf(fp, "#endif\n");
+        free(table);
+    }
+    fprintf(fp, "#undef SC\n");
+    fprintf(fp, "#endif\n");
+    fclose(fp);
+
     return 0;
 }
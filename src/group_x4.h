@@ -0,0 +1,56 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_GROUP_X4_H
+#define SECP256K1_GROUP_X4_H
+
+#include "group.h"
+#include "field_x4.h"
+
+#ifdef SECP256K1_FIELD_X4
+
+/* These operations only serve multiplication with the generator
+ * (secp256k1_ecmult_gen_batch), where all four lanes run the same constant-time
+ * sequence of additions. Verification does not use them: its Strauss and
+ * Pippenger loops skip zero digits, fill buckets with different numbers of
+ * points and add with the variable-time formulas, so four lanes would not stay
+ * in step, and four constant-time additions cost about as much as four
+ * secp256k1_gej_add_ge_var calls (see group_x4_add_affine and
+ * group_add_affine_var in bench_internal). */
+
+/** Four group elements in affine coordinates, none of them infinity. */
+typedef struct {
+    secp256k1_fe_x4 x;
+    secp256k1_fe_x4 y;
+} secp256k1_ge_x4;
+
+/** Four group elements in jacobian coordinates. infinity is all ones in the lanes
+ *  that hold the point at infinity, and zero in the others. */
+typedef struct {
+    secp256k1_fe_x4 x;
+    secp256k1_fe_x4 y;
+    secp256k1_fe_x4 z;
+    __m256i infinity;
+} secp256k1_gej_x4;
+
+/** Set r to the four points stored in a[0..3]. */
+SECP256K1_TARGET_AVX2 static void secp256k1_ge_x4_from_storage(secp256k1_ge_x4 *r, const secp256k1_ge_storage *a);
+
+/** Set r to the four points a[0..3]. */
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_set_gej(secp256k1_gej_x4 *r, const secp256k1_gej *a);
+
+/** Set r[0..3] to the four points in a. */
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_get_gej(secp256k1_gej *r, const secp256k1_gej_x4 *a);
+
+/** Set r = a + b lane by lane, like secp256k1_gej_add_ge, in constant time. */
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_add_ge(secp256k1_gej_x4 *r, const secp256k1_gej_x4 *a, const secp256k1_ge_x4 *b);
+
+/** Set r = 2*a lane by lane, like secp256k1_gej_double_var, in constant time. */
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_double(secp256k1_gej_x4 *r, const secp256k1_gej_x4 *a);
+
+#endif /* SECP256K1_FIELD_X4 */
+
+#endif /* SECP256K1_GROUP_X4_H */
@@ -0,0 +1,150 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_GROUP_X4_IMPL_H
+#define SECP256K1_GROUP_X4_IMPL_H
+
+#include "group_x4.h"
+#include "field_x4_impl.h"
+
+#ifdef SECP256K1_FIELD_X4
+
+SECP256K1_TARGET_AVX2 static void secp256k1_ge_x4_from_storage(secp256k1_ge_x4 *r, const secp256k1_ge_storage *a) {
+    secp256k1_fe_x4_set_storage(&r->x, &a[0].x, &a[1].x, &a[2].x, &a[3].x);
+    secp256k1_fe_x4_set_storage(&r->y, &a[0].y, &a[1].y, &a[2].y, &a[3].y);
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_set_gej(secp256k1_gej_x4 *r, const secp256k1_gej *a) {
+    secp256k1_fe f[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+        f[k] = a[k].x;
+    }
+    secp256k1_fe_x4_set_fe(&r->x, f);
+    for (k = 0; k < 4; k++) {
+        f[k] = a[k].y;
+    }
+    secp256k1_fe_x4_set_fe(&r->y, f);
+    for (k = 0; k < 4; k++) {
+        f[k] = a[k].z;
+    }
+    secp256k1_fe_x4_set_fe(&r->z, f);
+    r->infinity = _mm256_set_epi64x(-(int64_t)a[3].infinity, -(int64_t)a[2].infinity, -(int64_t)a[1].infinity, -(int64_t)a[0].infinity);
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_get_gej(secp256k1_gej *r, const secp256k1_gej_x4 *a) {
+    secp256k1_fe f[4];
+    int64_t inf[4];
+    int k;
+    secp256k1_fe_x4_get_fe(f, &a->x);
+    for (k = 0; k < 4; k++) {
+        r[k].x = f[k];
+    }
+    secp256k1_fe_x4_get_fe(f, &a->y);
+    for (k = 0; k < 4; k++) {
+        r[k].y = f[k];
+    }
+    secp256k1_fe_x4_get_fe(f, &a->z);
+    for (k = 0; k < 4; k++) {
+        r[k].z = f[k];
+    }
+    _mm256_storeu_si256((__m256i *)inf, a->infinity);
+    for (k = 0; k < 4; k++) {
+        r[k].infinity = (int)(inf[k] & 1);
+    }
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_add_ge(secp256k1_gej_x4 *r, const secp256k1_gej_x4 *a, const secp256k1_ge_x4 *b) {
+    /* The formula, and the handling of its degenerate cases, are those of
+     * secp256k1_gej_add_ge; see the explanation there. Magnitudes are the same
+     * as in that function. */
+    secp256k1_fe_x4 zz, u1, u2, s1, s2, t, tt, m, n, q, rr;
+    secp256k1_fe_x4 m_alt, rr_alt, fe_1;
+    __m256i degenerate, nondegenerate, zmask, infinity;
+
+    secp256k1_fe_x4_sqr(&zz, &a->z);                       /* z = Z1^2 */
+    u1 = a->x; secp256k1_fe_x4_normalize_weak(&u1);        /* u1 = U1 = X1*Z2^2 (1) */
+    secp256k1_fe_x4_mul(&u2, &b->x, &zz);                  /* u2 = U2 = X2*Z1^2 (1) */
+    s1 = a->y; secp256k1_fe_x4_normalize_weak(&s1);        /* s1 = S1 = Y1*Z2^3 (1) */
+    secp256k1_fe_x4_mul(&s2, &b->y, &zz);                  /* s2 = Y2*Z1^2 (1) */
+    secp256k1_fe_x4_mul(&s2, &s2, &a->z);                  /* s2 = S2 = Y2*Z1^3 (1) */
+    t = u1; secp256k1_fe_x4_add(&t, &u2);                  /* t = T = U1+U2 (2) */
+    m = s1; secp256k1_fe_x4_add(&m, &s2);                  /* m = M = S1+S2 (2) */
+    secp256k1_fe_x4_sqr(&rr, &t);                          /* rr = T^2 (1) */
+    secp256k1_fe_x4_negate(&m_alt, &u2, 1);                /* Malt = -X2*Z1^2 */
+    secp256k1_fe_x4_mul(&tt, &u1, &m_alt);                 /* tt = -U1*U2 (2) */
+    secp256k1_fe_x4_add(&rr, &tt);                         /* rr = R = T^2-U1*U2 (3) */
+    secp256k1_fe_x4_normalizes_to_zero(&degenerate, &m);
+    secp256k1_fe_x4_normalizes_to_zero(&zmask, &rr);
+    degenerate = _mm256_and_si256(degenerate, zmask);
+    nondegenerate = _mm256_xor_si256(degenerate, _mm256_set1_epi64x(-1));
+    rr_alt = s1;
+    secp256k1_fe_x4_mul_int(&rr_alt, 2);                   /* rr = Y1*Z2^3 - Y2*Z1^3 (2) */
+    secp256k1_fe_x4_add(&m_alt, &u1);                      /* Malt = X1*Z2^2 - X2*Z1^2 */
+
+    secp256k1_fe_x4_cmov(&rr_alt, &rr, &nondegenerate);
+    secp256k1_fe_x4_cmov(&m_alt, &m, &nondegenerate);
+    secp256k1_fe_x4_sqr(&n, &m_alt);                       /* n = Malt^2 (1) */
+    secp256k1_fe_x4_mul(&q, &n, &t);                       /* q = Q = T*Malt^2 (1) */
+    secp256k1_fe_x4_sqr(&n, &n);
+    secp256k1_fe_x4_cmov(&n, &m, &degenerate);             /* n = M^3 * Malt (2) */
+    secp256k1_fe_x4_sqr(&t, &rr_alt);                      /* t = Ralt^2 (1) */
+    secp256k1_fe_x4_mul(&r->z, &a->z, &m_alt);             /* r->z = Malt*Z (1) */
+    secp256k1_fe_x4_normalizes_to_zero(&zmask, &r->z);
+    infinity = _mm256_andnot_si256(a->infinity, zmask);
+    secp256k1_fe_x4_mul_int(&r->z, 2);                     /* r->z = Z3 = 2*Malt*Z (2) */
+    secp256k1_fe_x4_negate(&q, &q, 1);                     /* q = -Q (2) */
+    secp256k1_fe_x4_add(&t, &q);                           /* t = Ralt^2-Q (3) */
+    secp256k1_fe_x4_normalize_weak(&t);
+    r->x = t;                                              /* r->x = Ralt^2-Q (1) */
+    secp256k1_fe_x4_mul_int(&t, 2);                        /* t = 2*x3 (2) */
+    secp256k1_fe_x4_add(&t, &q);                           /* t = 2*x3 - Q: (4) */
+    secp256k1_fe_x4_mul(&t, &t, &rr_alt);                  /* t = Ralt*(2*x3 - Q) (1) */
+    secp256k1_fe_x4_add(&t, &n);                           /* t = Ralt*(2*x3 - Q) + M^3*Malt (3) */
+    secp256k1_fe_x4_negate(&r->y, &t, 3);                  /* r->y = Ralt*(Q - 2x3) - M^3*Malt (4) */
+    secp256k1_fe_x4_normalize_weak(&r->y);
+    secp256k1_fe_x4_mul_int(&r->x, 4);                     /* r->x = X3 = 4*(Ralt^2-Q) */
+    secp256k1_fe_x4_mul_int(&r->y, 4);                     /* r->y = Y3 = 4*Ralt*(Q - 2x3) - 4*M^3*Malt (4) */
+
+    /** In the lanes where a is infinity, replace r with (b->x, b->y, 1). */
+    secp256k1_fe_x4_set_int(&fe_1, 1);
+    secp256k1_fe_x4_cmov(&r->x, &b->x, &a->infinity);
+    secp256k1_fe_x4_cmov(&r->y, &b->y, &a->infinity);
+    secp256k1_fe_x4_cmov(&r->z, &fe_1, &a->infinity);
+    r->infinity = infinity;
+}
+
+SECP256K1_TARGET_AVX2 static void secp256k1_gej_x4_double(secp256k1_gej_x4 *r, const secp256k1_gej_x4 *a) {
+    /* As secp256k1_gej_double_var, computing every lane and carrying the
+     * infinity flags over. */
+    secp256k1_fe_x4 t1, t2, t3, t4;
+    r->infinity = a->infinity;
+
+    secp256k1_fe_x4_mul(&r->z, &a->z, &a->y);
+    secp256k1_fe_x4_mul_int(&r->z, 2);       /* Z' = 2*Y*Z (2) */
+    secp256k1_fe_x4_sqr(&t1, &a->x);
+    secp256k1_fe_x4_mul_int(&t1, 3);         /* T1 = 3*X^2 (3) */
+    secp256k1_fe_x4_sqr(&t2, &t1);           /* T2 = 9*X^4 (1) */
+    secp256k1_fe_x4_sqr(&t3, &a->y);
+    secp256k1_fe_x4_mul_int(&t3, 2);         /* T3 = 2*Y^2 (2) */
+    secp256k1_fe_x4_sqr(&t4, &t3);
+    secp256k1_fe_x4_mul_int(&t4, 2);         /* T4 = 8*Y^4 (2) */
+    secp256k1_fe_x4_mul(&t3, &t3, &a->x);    /* T3 = 2*X*Y^2 (1) */
+    r->x = t3;
+    secp256k1_fe_x4_mul_int(&r->x, 4);       /* X' = 8*X*Y^2 (4) */
+    secp256k1_fe_x4_negate(&r->x, &r->x, 4); /* X' = -8*X*Y^2 (5) */
+    secp256k1_fe_x4_add(&r->x, &t2);         /* X' = 9*X^4 - 8*X*Y^2 (6) */
+    secp256k1_fe_x4_negate(&t2, &t2, 1);     /* T2 = -9*X^4 (2) */
+    secp256k1_fe_x4_mul_int(&t3, 6);         /* T3 = 12*X*Y^2 (6) */
+    secp256k1_fe_x4_add(&t3, &t2);           /* T3 = 12*X*Y^2 - 9*X^4 (8) */
+    secp256k1_fe_x4_mul(&r->y, &t1, &t3);    /* Y' = 36*X^3*Y^2 - 27*X^6 (1) */
+    secp256k1_fe_x4_negate(&t2, &t4, 2);     /* T2 = -8*Y^4 (3) */
+    secp256k1_fe_x4_add(&r->y, &t2);         /* Y' = 36*X^3*Y^2 - 27*X^6 - 8*Y^4 (4) */
+}
+
+#endif /* SECP256K1_FIELD_X4 */
+
+#endif /* SECP256K1_GROUP_X4_IMPL_H */
@@ -8,6 +8,7 @@
 #define SECP256K1_HASH_IMPL_H
 
 #include "hash.h"
+#include "dispatch.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -46,7 +47,7 @@ static void secp256k1_sha256_initialize(secp256k1_sha256 *hash) {
 }
 
 /** Perform one SHA-256 transformation, processing 16 big endian 32-bit words. */
-static void secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
+static void secp256k1_sha256_transform_generic(uint32_t* s, const uint32_t* chunk) {
     uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
     uint32_t w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15;
 
@@ -128,6 +129,18 @@ static void secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
     s[7] += h;
 }
 
+#include "hash_shani_impl.h"
+
+/* On x86_64, the C and SHA extension versions are picked at runtime through the
+ * dispatch table. */
+static void secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
+#ifdef SECP256K1_DISPATCH_SHA256
+    SECP256K1_DISPATCH_GET(sha256_transform)(s, chunk);
+#else
+    secp256k1_sha256_transform_generic(s, chunk);
+#endif
+}
+
 static void secp256k1_sha256_write(secp256k1_sha256 *hash, const unsigned char *data, size_t len) {
     size_t bufsize = hash->bytes & 0x3F;
     hash->bytes += len;
@@ -0,0 +1,100 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_HASH_SHANI_IMPL_H
+#define SECP256K1_HASH_SHANI_IMPL_H
+
+#include "dispatch.h"
+
+#ifdef SECP256K1_DISPATCH_SHA256
+
+#include <immintrin.h>
+
+/* The SHA-256 transform with the x86 SHA extensions. SHA256RNDS2 performs two
+ * rounds on a state kept as (ABEF, CDGH), so the state is shuffled into that
+ * form on entry and back on exit. Only the transform is replaced: padding and
+ * buffering stay in secp256k1_sha256_write and secp256k1_sha256_finalize. */
+
+#define SECP256K1_TARGET_SHANI __attribute__((target("sha,sse4.1,ssse3")))
+
+/* Four rounds, with the message words in m and round constants k1:k0. */
+#define QUADROUND(m, k1, k0) do { \
+    __m128i msg = _mm_add_epi32((m), _mm_set_epi64x((k1), (k0))); \
+    s1 = _mm_sha256rnds2_epu32(s1, s0, msg); \
+    s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0e)); \
+} while(0)
+
+/* Message schedule: m0 gets the first half of the next words, m2 the second. */
+#define SHIFTA(m0, m1) (m0) = _mm_sha256msg1_epu32((m0), (m1))
+#define SHIFTC(m0, m1, m2) (m2) = _mm_sha256msg2_epu32(_mm_add_epi32((m2), _mm_alignr_epi8((m1), (m0), 4)), (m1))
+#define SHIFTB(m0, m1, m2) do { SHIFTC(m0, m1, m2); SHIFTA(m0, m1); } while(0)
+
+SECP256K1_TARGET_SHANI static void secp256k1_sha256_transform_shani(uint32_t* s, const uint32_t* chunk) {
+    /* Byte swaps every 32-bit word, as BE32 does. */
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i m0, m1, m2, m3, s0, s1, so0, so1, t1, t2;
+
+    /* Load the state as (ABEF, CDGH). */
+    t1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)s), 0xB1);
+    t2 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(s + 4)), 0x1B);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xF0);
+    so0 = s0;
+    so1 = s1;
+
+    m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)chunk), bswap);
+    QUADROUND(m0, 0xe9b5dba5b5c0fbcfULL, 0x71374491428a2f98ULL);
+    m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 4)), bswap);
+    QUADROUND(m1, 0xab1c5ed5923f82a4ULL, 0x59f111f13956c25bULL);
+    SHIFTA(m0, m1);
+    m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 8)), bswap);
+    QUADROUND(m2, 0x550c7dc3243185beULL, 0x12835b01d807aa98ULL);
+    SHIFTA(m1, m2);
+    m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 12)), bswap);
+    QUADROUND(m3, 0xc19bf1749bdc06a7ULL, 0x80deb1fe72be5d74ULL);
+    SHIFTB(m2, m3, m0);
+    QUADROUND(m0, 0x240ca1cc0fc19dc6ULL, 0xefbe4786e49b69c1ULL);
+    SHIFTB(m3, m0, m1);
+    QUADROUND(m1, 0x76f988da5cb0a9dcULL, 0x4a7484aa2de92c6fULL);
+    SHIFTB(m0, m1, m2);
+    QUADROUND(m2, 0xbf597fc7b00327c8ULL, 0xa831c66d983e5152ULL);
+    SHIFTB(m1, m2, m3);
+    QUADROUND(m3, 0x1429296706ca6351ULL, 0xd5a79147c6e00bf3ULL);
+    SHIFTB(m2, m3, m0);
+    QUADROUND(m0, 0x53380d134d2c6dfcULL, 0x2e1b213827b70a85ULL);
+    SHIFTB(m3, m0, m1);
+    QUADROUND(m1, 0x92722c8581c2c92eULL, 0x766a0abb650a7354ULL);
+    SHIFTB(m0, m1, m2);
+    QUADROUND(m2, 0xc76c51a3c24b8b70ULL, 0xa81a664ba2bfe8a1ULL);
+    SHIFTB(m1, m2, m3);
+    QUADROUND(m3, 0x106aa070f40e3585ULL, 0xd6990624d192e819ULL);
+    SHIFTB(m2, m3, m0);
+    QUADROUND(m0, 0x34b0bcb52748774cULL, 0x1e376c0819a4c116ULL);
+    SHIFTB(m3, m0, m1);
+    QUADROUND(m1, 0x682e6ff35b9cca4fULL, 0x4ed8aa4a391c0cb3ULL);
+    SHIFTC(m0, m1, m2);
+    QUADROUND(m2, 0x8cc7020884c87814ULL, 0x78a5636f748f82eeULL);
+    SHIFTC(m1, m2, m3);
+    QUADROUND(m3, 0xc67178f2bef9a3f7ULL, 0xa4506ceb90befffaULL);
+
+    s0 = _mm_add_epi32(s0, so0);
+    s1 = _mm_add_epi32(s1, so1);
+
+    /* Store the state back as (ABCD, EFGH). */
+    t1 = _mm_shuffle_epi32(s0, 0x1B);
+    t2 = _mm_shuffle_epi32(s1, 0xB1);
+    _mm_storeu_si128((__m128i*)s, _mm_blend_epi16(t1, t2, 0xF0));
+    _mm_storeu_si128((__m128i*)(s + 4), _mm_alignr_epi8(t2, t1, 0x08));
+}
+
+#undef QUADROUND
+#undef SHIFTA
+#undef SHIFTB
+#undef SHIFTC
+
+#endif /* SECP256K1_DISPATCH_SHA256 */
+
+#endif /* SECP256K1_HASH_SHANI_IMPL_H */
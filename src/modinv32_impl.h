@@ -0,0 +1,370 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODINV32_IMPL_H
+#define SECP256K1_MODINV32_IMPL_H
+
+#include "modinv32.h"
+
+#include "util.h"
+
+/* This file implements modular inversion based on the paper "Fast constant-time gcd computation and
+ * modular inversion" by Daniel J. Bernstein and Bo-Yin Yang, as modinv64_impl.h does with 62-bit
+ * limbs; see there for an overview. Here the divsteps are batched 30 at a time, for 32-bit words.
+ */
+
+/* Data type for transition matrices: t = [ u  v ]
+ *                                        [ q  r ] */
+typedef struct {
+    int32_t u, v, q, r;
+} secp256k1_modinv32_trans2x2;
+
+#ifdef VERIFY
+/* Return whether the signed30 number a is zero. */
+static int secp256k1_modinv32_is_zero_30(const secp256k1_modinv32_signed30 *a) {
+    int32_t c = 0;
+    int i;
+    for (i = 0; i < 9; ++i) {
+        c |= a->v[i];
+    }
+    return c == 0;
+}
+
+/* Return whether the signed30 number a, with limbs 0..7 in [0, 2^30), is 1 or -1. */
+static int secp256k1_modinv32_is_unit_30(const secp256k1_modinv32_signed30 *a) {
+    const int32_t M30 = (int32_t)(UINT32_MAX >> 2);
+    int32_t c = 0, m = M30;
+    int i;
+    for (i = 1; i < 8; ++i) {
+        c |= a->v[i];
+        m &= a->v[i];
+    }
+    return (a->v[0] == 1 && (c | a->v[8]) == 0) || (a->v[0] == M30 && m == M30 && a->v[8] == -1);
+}
+#endif
+
+/* Compute the transition matrix and zeta for 30 divsteps, where zeta = -(delta + 1/2) for the delta
+ * of the paper. The matrix is scaled by 2^30; 20 batches of 30 cover the 590 divsteps that 256-bit
+ * inputs need.
+ *
+ * Input:  zeta: initial zeta
+ *         f0:   bottom limb of initial f
+ *         g0:   bottom limb of initial g
+ * Output: t:    transition matrix
+ * Return: final zeta
+ */
+static int32_t secp256k1_modinv32_divsteps_30(int32_t zeta, uint32_t f0, uint32_t g0, secp256k1_modinv32_trans2x2 *t) {
+    /* u, v, q, r are the elements of the transition matrix being built up, starting with the
+     * identity. They are signed integers in range [-2^30, 2^30], represented as unsigned mod 2^32
+     * here so that left shifts are well-defined. */
+    uint32_t u = 1, v = 0, q = 0, r = 1;
+    uint32_t c1, c2, f = f0, g = g0, x, y, z;
+    int i;
+
+    for (i = 0; i < 30; ++i) {
+        VERIFY_CHECK((f & 1) == 1); /* f must always be odd */
+        VERIFY_CHECK((u * f0 + v * g0) == f << i);
+        VERIFY_CHECK((q * f0 + r * g0) == g << i);
+        /* Compute conditional masks for (zeta < 0) and for (g & 1). */
+        c1 = (uint32_t)(zeta >> 31);
+        c2 = -(g & 1);
+        /* Compute x, y, z, conditionally negated versions of f, u, v. */
+        x = (f ^ c1) - c1;
+        y = (u ^ c1) - c1;
+        z = (v ^ c1) - c1;
+        /* Conditionally add x, y, z to g, q, r. */
+        g += x & c2;
+        q += y & c2;
+        r += z & c2;
+        /* In what follows, c1 is a condition mask for (zeta < 0) and (g & 1). */
+        c1 &= c2;
+        /* Conditionally change zeta into -zeta-2 or zeta-1. */
+        zeta = (zeta ^ (int32_t)c1) - 1;
+        /* Conditionally add g, q, r to f, u, v. */
+        f += g & c1;
+        u += q & c1;
+        v += r & c1;
+        /* Shifts */
+        g >>= 1;
+        u <<= 1;
+        v <<= 1;
+        /* Bounds on zeta that follow from the bounds on iteration count (max 20*30 divsteps). */
+        VERIFY_CHECK(zeta >= -601 && zeta <= 601);
+    }
+    t->u = (int32_t)u;
+    t->v = (int32_t)v;
+    t->q = (int32_t)q;
+    t->r = (int32_t)r;
+    return zeta;
+}
+
+/* Compute the transition matrix and eta for 30 divsteps, where eta = -delta for the delta of the
+ * paper, in variable time; see secp256k1_modinv64_divsteps_62_var.
+ *
+ * Input:  eta: initial eta
+ *         f0:  bottom limb of initial f
+ *         g0:  bottom limb of initial g
+ * Output: t:   transition matrix
+ * Return: final eta
+ */
+static int32_t secp256k1_modinv32_divsteps_30_var(int32_t eta, uint32_t f0, uint32_t g0, secp256k1_modinv32_trans2x2 *t) {
+    /* Transition matrix; see comments in secp256k1_modinv32_divsteps_30. */
+    uint32_t u = 1, v = 0, q = 0, r = 1;
+    uint32_t f = f0, g = g0, m, w;
+    int i = 30, limit, zeros;
+
+    for (;;) {
+        /* Use a sentinel bit to count zeros only up to i. */
+        zeros = secp256k1_ctz32_var(g | (UINT32_MAX << i));
+        /* Perform zeros divsteps at once; they all just divide g by two. */
+        g >>= zeros;
+        u <<= zeros;
+        v <<= zeros;
+        eta -= zeros;
+        i -= zeros;
+        /* We're done once we've done 30 divsteps. */
+        if (i == 0) {
+            break;
+        }
+        VERIFY_CHECK((f & 1) == 1);
+        VERIFY_CHECK((g & 1) == 1);
+        VERIFY_CHECK((u * f0 + v * g0) == f << (30 - i));
+        VERIFY_CHECK((q * f0 + r * g0) == g << (30 - i));
+        /* Bounds on eta that follow from the bounds on iteration count (max 25*30 divsteps). */
+        VERIFY_CHECK(eta >= -751 && eta <= 751);
+        /* No more than i bits of g can be cancelled (we'd be done before that), and no more than
+         * eta+1 (the sign of eta flips after that). */
+        if (eta < 0) {
+            uint32_t tmp;
+            /* Negate eta and replace f, g with g, -f. */
+            eta = -eta;
+            tmp = f; f = g; g = -tmp;
+            tmp = u; u = q; q = -tmp;
+            tmp = v; v = r; r = -tmp;
+            limit = ((int)eta + 1) > i ? i : ((int)eta + 1);
+            VERIFY_CHECK(limit > 0 && limit <= 30);
+            /* m is a mask for the bottom min(limit, 6) bits. */
+            m = (UINT32_MAX >> (32 - limit)) & 63U;
+            /* Find the multiple of f to add to g to cancel those bits, using
+             * f^-1 == f * (2 - f^2) mod 2^6. */
+            w = (f * g * (f * f - 2)) & m;
+        } else {
+            /* eta tends to be smaller here, so cancel up to 4 bits only, using
+             * f^-1 == f + ((f + 1) & 4) * 2 mod 2^4. */
+            limit = ((int)eta + 1) > i ? i : ((int)eta + 1);
+            VERIFY_CHECK(limit > 0 && limit <= 30);
+            m = (UINT32_MAX >> (32 - limit)) & 15U;
+            w = f + (((f + 1) & 4) << 1);
+            w = (-w * g) & m;
+        }
+        g += f * w;
+        q += u * w;
+        r += v * w;
+        VERIFY_CHECK((g & m) == 0);
+    }
+    t->u = (int32_t)u;
+    t->v = (int32_t)v;
+    t->q = (int32_t)q;
+    t->r = (int32_t)r;
+    return eta;
+}
+
+/* Compute (t/2^30) * [d, e] mod modulus, where t is a transition matrix scaled by 2^30.
+ *
+ * On input and output, d and e are in range (-2*modulus, modulus). All output limbs will be in
+ * range (-2^30, 2^30).
+ */
+static void secp256k1_modinv32_update_de_30(secp256k1_modinv32_signed30 *d, secp256k1_modinv32_signed30 *e, const secp256k1_modinv32_trans2x2 *t, const secp256k1_modinv32_modinfo *modinfo) {
+    const uint32_t M30 = UINT32_MAX >> 2;
+    const int32_t u = t->u, v = t->v, q = t->q, r = t->r;
+    int32_t di, ei, md, me, sd, se;
+    int64_t cd, ce;
+    int i;
+    /* [md, me] start as zero; plus [u, q] if d is negative; plus [v, r] if e is negative. */
+    sd = d->v[8] >> 31;
+    se = e->v[8] >> 31;
+    md = (u & sd) + (v & se);
+    me = (q & sd) + (r & se);
+    /* Begin computing t*[d, e]. */
+    di = d->v[0];
+    ei = e->v[0];
+    cd = (int64_t)u * di + (int64_t)v * ei;
+    ce = (int64_t)q * di + (int64_t)r * ei;
+    /* Correct md, me so that t*[d, e] + modulus*[md, me] has 30 zero bottom bits. */
+    md -= (int32_t)((modinfo->modulus_inv30 * (uint32_t)cd + (uint32_t)md) & M30);
+    me -= (int32_t)((modinfo->modulus_inv30 * (uint32_t)ce + (uint32_t)me) & M30);
+    /* Update the beginning of computation for t*[d, e] + modulus*[md, me] now md, me are known. */
+    cd += (int64_t)modinfo->modulus.v[0] * md;
+    ce += (int64_t)modinfo->modulus.v[0] * me;
+    /* Verify that the low 30 bits of the computation are indeed zero, and then throw them away. */
+    VERIFY_CHECK(((uint32_t)cd & M30) == 0); cd >>= 30;
+    VERIFY_CHECK(((uint32_t)ce & M30) == 0); ce >>= 30;
+    /* Now iteratively compute limb i=1..8 of t*[d, e] + modulus*[md, me], and store them in output
+     * limb i-1 (shifting down by 30 bits). */
+    for (i = 1; i < 9; ++i) {
+        di = d->v[i];
+        ei = e->v[i];
+        cd += (int64_t)u * di + (int64_t)v * ei;
+        ce += (int64_t)q * di + (int64_t)r * ei;
+        cd += (int64_t)modinfo->modulus.v[i] * md;
+        ce += (int64_t)modinfo->modulus.v[i] * me;
+        d->v[i - 1] = (int32_t)((uint32_t)cd & M30); cd >>= 30;
+        e->v[i - 1] = (int32_t)((uint32_t)ce & M30); ce >>= 30;
+    }
+    /* What remains is limb 9 of t*[d, e] + modulus*[md, me]; store it as output limb 8. */
+    d->v[8] = (int32_t)cd;
+    e->v[8] = (int32_t)ce;
+}
+
+/* Compute (t/2^30) * [f, g], where t is a transition matrix scaled by 2^30, using only the bottom
+ * len limbs of f and g; the ones above must be their sign extension. */
+static void secp256k1_modinv32_update_fg_30(int len, secp256k1_modinv32_signed30 *f, secp256k1_modinv32_signed30 *g, const secp256k1_modinv32_trans2x2 *t) {
+    const uint32_t M30 = UINT32_MAX >> 2;
+    const int32_t u = t->u, v = t->v, q = t->q, r = t->r;
+    int32_t fi, gi;
+    int64_t cf, cg;
+    int i;
+    VERIFY_CHECK(len > 0);
+    /* Start computing t*[f, g]. */
+    fi = f->v[0];
+    gi = g->v[0];
+    cf = (int64_t)u * fi + (int64_t)v * gi;
+    cg = (int64_t)q * fi + (int64_t)r * gi;
+    /* Verify that the bottom 30 bits of the result are zero, and then throw them away. */
+    VERIFY_CHECK(((uint32_t)cf & M30) == 0); cf >>= 30;
+    VERIFY_CHECK(((uint32_t)cg & M30) == 0); cg >>= 30;
+    /* Now iteratively compute limb i=1..len-1 of t*[f, g], and store them in output limb i-1
+     * (shifting down by 30 bits). */
+    for (i = 1; i < len; ++i) {
+        fi = f->v[i];
+        gi = g->v[i];
+        cf += (int64_t)u * fi + (int64_t)v * gi;
+        cg += (int64_t)q * fi + (int64_t)r * gi;
+        f->v[i - 1] = (int32_t)((uint32_t)cf & M30); cf >>= 30;
+        g->v[i - 1] = (int32_t)((uint32_t)cg & M30); cg >>= 30;
+    }
+    /* What remains is limb len of t*[f, g]; store it as output limb len-1. */
+    f->v[len - 1] = (int32_t)cf;
+    g->v[len - 1] = (int32_t)cg;
+}
+
+/* Take as input a signed30 number in range (-2*modulus, modulus), and add a multiple of the modulus
+ * to it to bring it to range [0, modulus). If sign < 0, the input is also negated in the process.
+ * The input must have limbs in range (-2^30, 2^30). The output has limbs in range [0, 2^30). */
+static void secp256k1_modinv32_normalize_30(secp256k1_modinv32_signed30 *r, int32_t sign, const secp256k1_modinv32_modinfo *modinfo) {
+    const int32_t M30 = (int32_t)(UINT32_MAX >> 2);
+    int32_t cond_add, cond_negate;
+    int i;
+
+    /* In a first step, add the modulus if the input is negative, and then negate if requested.
+     * This brings r from range (-2*modulus, modulus) to range (-modulus, modulus). As all input
+     * limbs are in range (-2^30, 2^30), this cannot overflow an int32_t. The right shifts below
+     * are sign-extending. */
+    cond_add = r->v[8] >> 31;
+    cond_negate = sign >> 31;
+    for (i = 0; i < 9; ++i) {
+        r->v[i] += modinfo->modulus.v[i] & cond_add;
+        r->v[i] = (r->v[i] ^ cond_negate) - cond_negate;
+    }
+    /* Propagate the top bits, to bring limbs back to range (-2^30, 2^30). */
+    for (i = 0; i < 8; ++i) {
+        r->v[i + 1] += r->v[i] >> 30;
+        r->v[i] &= M30;
+    }
+
+    /* In a second step add the modulus again if the result is still negative, bringing
+     * r to range [0, modulus). */
+    cond_add = r->v[8] >> 31;
+    for (i = 0; i < 9; ++i) {
+        r->v[i] += modinfo->modulus.v[i] & cond_add;
+    }
+    /* And propagate again. */
+    for (i = 0; i < 8; ++i) {
+        r->v[i + 1] += r->v[i] >> 30;
+        r->v[i] &= M30;
+    }
+}
+
+static void secp256k1_modinv32(secp256k1_modinv32_signed30 *x, const secp256k1_modinv32_modinfo *modinfo) {
+    /* Start with d=0, e=1, f=modulus, g=x, zeta=-1. */
+    secp256k1_modinv32_signed30 d = {{0, 0, 0, 0, 0, 0, 0, 0, 0}};
+    secp256k1_modinv32_signed30 e = {{1, 0, 0, 0, 0, 0, 0, 0, 0}};
+    secp256k1_modinv32_signed30 f = modinfo->modulus;
+    secp256k1_modinv32_signed30 g = *x;
+    int i;
+    int32_t zeta = -1; /* zeta = -(delta+1/2); delta starts at 1/2. */
+
+    /* Do 20 iterations of 30 divsteps each = 600 divsteps. 590 suffices for 256-bit inputs. */
+    for (i = 0; i < 20; ++i) {
+        secp256k1_modinv32_trans2x2 t;
+        zeta = secp256k1_modinv32_divsteps_30(zeta, f.v[0], g.v[0], &t);
+        secp256k1_modinv32_update_de_30(&d, &e, &t, modinfo);
+        secp256k1_modinv32_update_fg_30(9, &f, &g, &t);
+    }
+
+    /* At this point g is 0, and (if x was not 0) f is +/-1, the GCD of modulus and x up to
+     * sign, and d is +/- the modular inverse. */
+#ifdef VERIFY
+    VERIFY_CHECK(secp256k1_modinv32_is_zero_30(&g));
+    VERIFY_CHECK(secp256k1_modinv32_is_unit_30(&f) || secp256k1_modinv32_is_zero_30(x));
+#endif
+
+    /* Optionally negate d, normalize to [0, modulus), and return it. */
+    secp256k1_modinv32_normalize_30(&d, f.v[8], modinfo);
+    *x = d;
+}
+
+static void secp256k1_modinv32_var(secp256k1_modinv32_signed30 *x, const secp256k1_modinv32_modinfo *modinfo) {
+    /* Start with d=0, e=1, f=modulus, g=x, eta=-1. */
+    secp256k1_modinv32_signed30 d = {{0, 0, 0, 0, 0, 0, 0, 0, 0}};
+    secp256k1_modinv32_signed30 e = {{1, 0, 0, 0, 0, 0, 0, 0, 0}};
+    secp256k1_modinv32_signed30 f = modinfo->modulus;
+    secp256k1_modinv32_signed30 g = *x;
+    int j, len = 9;
+    int32_t eta = -1; /* eta = -delta; delta is initially 1 */
+    int32_t cond, fn, gn;
+
+    /* Do iterations of 30 divsteps each until g=0. */
+    for (;;) {
+        secp256k1_modinv32_trans2x2 t;
+        eta = secp256k1_modinv32_divsteps_30_var(eta, f.v[0], g.v[0], &t);
+        secp256k1_modinv32_update_de_30(&d, &e, &t, modinfo);
+        secp256k1_modinv32_update_fg_30(len, &f, &g, &t);
+        /* If the bottom limb of g is zero, there is a chance that g=0. */
+        if (g.v[0] == 0) {
+            cond = 0;
+            /* Check if the other limbs are also 0. */
+            for (j = 1; j < len; ++j) {
+                cond |= g.v[j];
+            }
+            /* If so, we're done. */
+            if (cond == 0) {
+                break;
+            }
+        }
+
+        /* Determine if len>1 and limb (len-1) of both f and g is 0 or -1. */
+        fn = f.v[len - 1];
+        gn = g.v[len - 1];
+        cond = ((int32_t)len - 2) >> 31;
+        cond |= fn ^ (fn >> 31);
+        cond |= gn ^ (gn >> 31);
+        /* If so, reduce length, propagating the sign of f and g's top limb into the one below. */
+        if (cond == 0) {
+            f.v[len - 2] = (int32_t)((uint32_t)f.v[len - 2] | (uint32_t)fn << 30);
+            g.v[len - 2] = (int32_t)((uint32_t)g.v[len - 2] | (uint32_t)gn << 30);
+            --len;
+        }
+    }
+
+    /* At this point g is 0, and (if x was not 0) f is +/-1 and d is +/- the modular inverse. */
+
+    /* Optionally negate d, normalize to [0, modulus), and return it. */
+    secp256k1_modinv32_normalize_30(&d, f.v[len - 1], modinfo);
+    *x = d;
+}
+
+#endif /* SECP256K1_MODINV32_IMPL_H */
@@ -0,0 +1,379 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MULTI_MAIN_H
+#define SECP256K1_MODULE_MULTI_MAIN_H
+
+#include "include/secp256k1_multi.h"
+
+typedef struct {
+    const secp256k1_context *ctx;
+    const secp256k1_pubkey * const *pubkeys;
+    const unsigned char * const *scalars32;
+} secp256k1_ecmult_multi_data;
+
+static int secp256k1_ecmult_multi_callback_pubkeys(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_ecmult_multi_data *multi_data = (const secp256k1_ecmult_multi_data *) data;
+    const secp256k1_context *ctx = multi_data->ctx;
+    int overflow = 0;
+
+    secp256k1_scalar_set_b32(sc, multi_data->scalars32[idx], &overflow);
+    if (overflow) {
+        return 0;
+    }
+    return secp256k1_pubkey_load(ctx, pt, multi_data->pubkeys[idx]);
+}
+
+static int secp256k1_ecmult_multi_internal(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, const secp256k1_pubkey * const *pubkeys, const unsigned char * const *scalars32, size_t n, const secp256k1_ecmult_parallel *par) {
+    secp256k1_ecmult_multi_data data;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+    int overflow = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+    ARG_CHECK(n == 0 || scalars32 != NULL);
+
+    if (g_scalar32 != NULL) {
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+    data.ctx = ctx;
+    data.pubkeys = pubkeys;
+    data.scalars32 = scalars32;
+    if (!secp256k1_ecmult_multi_parallel_var(&ctx->ecmult_ctx, scratch, &rj, g_scalar32 != NULL ? &g_sc : NULL, secp256k1_ecmult_multi_callback_pubkeys, &data, n, par)) {
+        return 0;
+    }
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+int secp256k1_ecmult_multi(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, const secp256k1_pubkey * const *pubkeys, const unsigned char * const *scalars32, size_t n) {
+    return secp256k1_ecmult_multi_internal(ctx, scratch, result, g_scalar32, pubkeys, scalars32, n, NULL);
+}
+
+int secp256k1_ecmult_multi_parallel(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, const secp256k1_pubkey * const *pubkeys, const unsigned char * const *scalars32, size_t n, secp256k1_parallel_function parallel, void *parallel_data, size_t n_threads) {
+    secp256k1_ecmult_parallel par;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(parallel != NULL);
+    par.fn = parallel;
+    par.data = parallel_data;
+    par.n_threads = n_threads;
+    return secp256k1_ecmult_multi_internal(ctx, scratch, result, g_scalar32, pubkeys, scalars32, n, &par);
+}
+
+size_t secp256k1_ecmult_multi_scratch_size(size_t n) {
+    return secp256k1_ecmult_multi_parallel_scratch_size(n, 1);
+}
+
+size_t secp256k1_ecmult_multi_parallel_scratch_size(size_t n, size_t n_threads) {
+    if (n == 0) {
+        return 0;
+    }
+    if (n >= ECMULT_PIPPENGER_THRESHOLD) {
+        return secp256k1_pippenger_scratch_size_max_points(n, n_threads);
+    }
+    return secp256k1_strauss_scratch_size(n) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT;
+}
+
+typedef struct {
+    const secp256k1_context *ctx;
+    secp256k1_ecmult_multi_term_function terms;
+    void *terms_data;
+} secp256k1_ecmult_multi_stream_data;
+
+static int secp256k1_ecmult_multi_callback_terms(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_ecmult_multi_stream_data *stream_data = (const secp256k1_ecmult_multi_stream_data *) data;
+    secp256k1_pubkey pubkey;
+    unsigned char scalar32[32];
+    int overflow = 0;
+
+    if (!stream_data->terms(scalar32, &pubkey, idx, stream_data->terms_data)) {
+        return 0;
+    }
+    secp256k1_scalar_set_b32(sc, scalar32, &overflow);
+    if (overflow) {
+        return 0;
+    }
+    return secp256k1_pubkey_load(stream_data->ctx, pt, &pubkey);
+}
+
+int secp256k1_ecmult_multi_stream(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *result, const unsigned char *g_scalar32, secp256k1_ecmult_multi_term_function terms, void *terms_data, size_t n, secp256k1_parallel_function parallel, void *parallel_data, size_t n_threads) {
+    secp256k1_ecmult_multi_stream_data data;
+    secp256k1_ecmult_parallel par;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+    int overflow = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(terms != NULL);
+
+    if (g_scalar32 != NULL) {
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+    data.ctx = ctx;
+    data.terms = terms;
+    data.terms_data = terms_data;
+    par.fn = parallel;
+    par.data = parallel_data;
+    par.n_threads = parallel != NULL ? n_threads : 1;
+    if (!secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &rj, g_scalar32 != NULL ? &g_sc : NULL, secp256k1_ecmult_multi_callback_terms, &data, n, &par)) {
+        return 0;
+    }
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+struct secp256k1_fixed_base_table_struct {
+    secp256k1_ecmult_fixed_base fb;
+};
+
+secp256k1_fixed_base_table* secp256k1_fixed_base_table_create(const secp256k1_context* ctx, const secp256k1_pubkey *pubkey) {
+    secp256k1_fixed_base_table *ret;
+    secp256k1_ge p;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    if (!secp256k1_pubkey_load(ctx, &p, pubkey)) {
+        return NULL;
+    }
+    ret = (secp256k1_fixed_base_table*)checked_malloc(&ctx->error_callback, sizeof(secp256k1_fixed_base_table));
+    secp256k1_ecmult_fixed_base_init(&ret->fb);
+    secp256k1_ecmult_fixed_base_build(&ret->fb, &p, &ctx->error_callback);
+    return ret;
+}
+
+void secp256k1_fixed_base_table_destroy(secp256k1_fixed_base_table *table) {
+    if (table != NULL) {
+        secp256k1_ecmult_fixed_base_clear(&table->fb);
+        free(table);
+    }
+}
+
+int secp256k1_fixed_base_mul(const secp256k1_context* ctx, secp256k1_pubkey *result, const secp256k1_fixed_base_table *table, const unsigned char *scalar32, const unsigned char *g_scalar32) {
+    secp256k1_scalar sc;
+    secp256k1_scalar g_sc;
+    secp256k1_gej rj;
+    secp256k1_ge r;
+    int overflow = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(result != NULL);
+    memset(result, 0, sizeof(*result));
+    ARG_CHECK(table != NULL);
+    ARG_CHECK(scalar32 != NULL);
+    if (g_scalar32 != NULL) {
+        secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    }
+    ARG_CHECK(g_scalar32 == NULL || secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+
+    secp256k1_scalar_set_b32(&sc, scalar32, &overflow);
+    if (overflow) {
+        return 0;
+    }
+    if (g_scalar32 != NULL) {
+        secp256k1_scalar_set_b32(&g_sc, g_scalar32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+    }
+    secp256k1_ecmult_fixed(&ctx->ecmult_ctx, &table->fb, &rj, &sc, g_scalar32 != NULL ? &g_sc : NULL);
+    if (secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+    secp256k1_ge_set_gej_var(&r, &rj);
+    secp256k1_pubkey_save(result, &r);
+    return 1;
+}
+
+typedef struct {
+    secp256k1_ge pt;
+    secp256k1_scalar sc;
+} secp256k1_batch_term;
+
+struct secp256k1_batch_struct {
+    secp256k1_scratch *scratch;
+    /* Commits to the auxiliary randomness and all terms added so far. */
+    secp256k1_sha256 sha;
+    secp256k1_batch_term *terms;
+    size_t capacity;
+    size_t n_terms;
+    /* Weighted G scalar of the terms in the buffer. */
+    secp256k1_scalar g_sc;
+    /* Weighted sum of all terms that did not fit into the buffer. */
+    secp256k1_gej acc;
+    int failed;
+};
+
+static int secp256k1_batch_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_batch_term *term = &((const secp256k1_batch_term *) data)[idx];
+    *sc = term->sc;
+    *pt = term->pt;
+    return 1;
+}
+
+/* Adds the weighted terms in the buffer to acc and empties it. */
+static void secp256k1_batch_flush(const secp256k1_ecmult_context *ctx, secp256k1_batch *batch) {
+    secp256k1_gej r;
+
+    if (!secp256k1_ecmult_multi_var(ctx, batch->scratch, &r, &batch->g_sc, secp256k1_batch_callback, batch->terms, batch->n_terms)) {
+        /* The remaining scratch space is too small for even a single point;
+         * fall back to the algorithm that does not need any. */
+        secp256k1_ecmult_multi_var(ctx, NULL, &r, &batch->g_sc, secp256k1_batch_callback, batch->terms, batch->n_terms);
+    }
+    secp256k1_gej_add_var(&batch->acc, &batch->acc, &r, NULL);
+    batch->n_terms = 0;
+    secp256k1_scalar_set_int(&batch->g_sc, 0);
+}
+
+secp256k1_batch* secp256k1_batch_create(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, const unsigned char *aux_rand32) {
+    secp256k1_batch *batch;
+    size_t capacity;
+    static const unsigned char zero[32] = { 0 };
+
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+
+    /* Use at most half of the scratch space for the terms, leaving the rest
+     * for the multi-multiplication. */
+    capacity = secp256k1_scratch_max_allocation(scratch, 2) / 2;
+    if (capacity <= sizeof(secp256k1_batch)) {
+        return NULL;
+    }
+    capacity = (capacity - sizeof(secp256k1_batch)) / sizeof(secp256k1_batch_term);
+    if (capacity == 0 || !secp256k1_scratch_allocate_frame(scratch, sizeof(secp256k1_batch) + capacity * sizeof(secp256k1_batch_term), 2)) {
+        return NULL;
+    }
+    batch = (secp256k1_batch *) secp256k1_scratch_alloc(scratch, sizeof(secp256k1_batch));
+    batch->terms = (secp256k1_batch_term *) secp256k1_scratch_alloc(scratch, capacity * sizeof(secp256k1_batch_term));
+    VERIFY_CHECK(batch != NULL && batch->terms != NULL);
+    batch->scratch = scratch;
+    batch->capacity = capacity;
+    secp256k1_sha256_initialize(&batch->sha);
+    secp256k1_sha256_write(&batch->sha, aux_rand32 != NULL ? aux_rand32 : zero, 32);
+    batch->n_terms = 0;
+    secp256k1_scalar_set_int(&batch->g_sc, 0);
+    secp256k1_gej_set_infinity(&batch->acc);
+    batch->failed = 0;
+    return batch;
+}
+
+void secp256k1_batch_destroy(secp256k1_batch *batch) {
+    if (batch != NULL) {
+        secp256k1_scratch_deallocate_frame(batch->scratch);
+    }
+}
+
+int secp256k1_batch_add(const secp256k1_context* ctx, secp256k1_batch *batch, const unsigned char *g_scalar32, const secp256k1_pubkey * const *pubkeys, const unsigned char * const *scalars32, size_t n) {
+    static const unsigned char zero[32] = { 0 };
+    secp256k1_sha256 sha;
+    secp256k1_scalar weight;
+    secp256k1_scalar sc;
+    unsigned char buf[32];
+    size_t i;
+    int overflow = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(batch != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+    ARG_CHECK(n == 0 || scalars32 != NULL);
+
+    /* Commit to the equation, including its number of terms so that the
+     * boundaries between equations are unambiguous, before deriving its
+     * weight from everything added so far. */
+    for (i = 0; i < 8; i++) {
+        buf[i] = (unsigned char)((uint64_t)n >> (56 - 8 * i));
+    }
+    secp256k1_sha256_write(&batch->sha, buf, 8);
+    secp256k1_sha256_write(&batch->sha, g_scalar32 != NULL ? g_scalar32 : zero, 32);
+    for (i = 0; i < n; i++) {
+        secp256k1_sha256_write(&batch->sha, pubkeys[i]->data, sizeof(pubkeys[i]->data));
+        secp256k1_sha256_write(&batch->sha, scalars32[i], 32);
+    }
+    sha = batch->sha;
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(&weight, buf, NULL);
+    if (secp256k1_scalar_is_zero(&weight)) {
+        secp256k1_scalar_set_int(&weight, 1);
+    }
+
+    if (g_scalar32 != NULL) {
+        secp256k1_scalar_set_b32(&sc, g_scalar32, &overflow);
+        if (overflow) {
+            batch->failed = 1;
+            return 0;
+        }
+        secp256k1_scalar_mul(&sc, &sc, &weight);
+        secp256k1_scalar_add(&batch->g_sc, &batch->g_sc, &sc);
+    }
+    for (i = 0; i < n; i++) {
+        secp256k1_batch_term *term;
+
+        if (batch->n_terms == batch->capacity) {
+            secp256k1_batch_flush(&ctx->ecmult_ctx, batch);
+        }
+        term = &batch->terms[batch->n_terms];
+        secp256k1_scalar_set_b32(&term->sc, scalars32[i], &overflow);
+        if (overflow || !secp256k1_pubkey_load(ctx, &term->pt, pubkeys[i])) {
+            batch->failed = 1;
+            return 0;
+        }
+        secp256k1_scalar_mul(&term->sc, &term->sc, &weight);
+        batch->n_terms++;
+    }
+    return 1;
+}
+
+int secp256k1_batch_verify(const secp256k1_context* ctx, secp256k1_batch *batch) {
+    int ret;
+
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(batch != NULL);
+
+    if (!batch->failed) {
+        secp256k1_batch_flush(&ctx->ecmult_ctx, batch);
+    }
+    ret = !batch->failed && secp256k1_gej_is_infinity(&batch->acc);
+    batch->n_terms = 0;
+    secp256k1_scalar_set_int(&batch->g_sc, 0);
+    secp256k1_gej_set_infinity(&batch->acc);
+    batch->failed = 0;
+    return ret;
+}
+
+#endif /* SECP256K1_MODULE_MULTI_MAIN_H */
@@ -0,0 +1,582 @@
+/**********************************************************************
+ * Copyright (c) 2018 The libsecp256k1 developers                     *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MULTI_TESTS_H
+#define SECP256K1_MODULE_MULTI_TESTS_H
+
+void test_ecmult_multi_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(vrfy, 100000);
+    secp256k1_pubkey pubkey;
+    secp256k1_pubkey result;
+    const secp256k1_pubkey *pubkeys[1];
+    const unsigned char *scalars[1];
+    unsigned char one[32] = { 0 };
+    unsigned char overflow[32];
+    int32_t ecount = 0;
+
+    one[31] = 1;
+    memset(overflow, 0xff, sizeof(overflow));
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, one) == 1);
+    pubkeys[0] = &pubkey;
+    scalars[0] = one;
+
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, one, pubkeys, scalars, 1) == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, NULL, &result, one, pubkeys, scalars, 1) == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, NULL, pubkeys, scalars, 1) == 1);
+    CHECK(memcmp(&result, &pubkey, sizeof(pubkey)) == 0);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, one, NULL, NULL, 0) == 1);
+    CHECK(memcmp(&result, &pubkey, sizeof(pubkey)) == 0);
+    CHECK(ecount == 0);
+    /* The empty sum is the point at infinity */
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, NULL, NULL, NULL, 0) == 0);
+    CHECK(ecount == 0);
+    /* Overflowing scalars are rejected */
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, overflow, pubkeys, scalars, 1) == 0);
+    scalars[0] = overflow;
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, NULL, pubkeys, scalars, 1) == 0);
+    scalars[0] = one;
+    CHECK(ecount == 0);
+
+    CHECK(secp256k1_ecmult_multi(none, scratch, &result, one, pubkeys, scalars, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, NULL, one, pubkeys, scalars, 1) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, one, NULL, scalars, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecmult_multi(vrfy, scratch, &result, one, pubkeys, NULL, 1) == 0);
+    CHECK(ecount == 4);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_context_destroy(none);
+    secp256k1_context_destroy(vrfy);
+}
+
+/* Compare secp256k1_ecmult_multi against tweak_mul and combine */
+void test_ecmult_multi_pubkeys(size_t n, secp256k1_scratch_space *scratch) {
+    secp256k1_pubkey *pubkeys = (secp256k1_pubkey *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey) * (n + 1));
+    secp256k1_pubkey *products = (secp256k1_pubkey *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey) * (n + 1));
+    unsigned char *scalars = (unsigned char *)checked_malloc(&ctx->error_callback, 32 * (n + 1));
+    const secp256k1_pubkey **pubkey_ptrs = (const secp256k1_pubkey **)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey *) * (n + 1));
+    const secp256k1_pubkey **product_ptrs = (const secp256k1_pubkey **)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey *) * (n + 1));
+    const unsigned char **scalar_ptrs = (const unsigned char **)checked_malloc(&ctx->error_callback, sizeof(unsigned char *) * (n + 1));
+    secp256k1_pubkey expected;
+    secp256k1_pubkey result;
+    unsigned char one[32] = { 0 };
+    size_t i;
+
+    one[31] = 1;
+    for (i = 0; i <= n; i++) {
+        secp256k1_scalar s;
+        unsigned char key[32];
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(key, &s);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], key) == 1);
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(&scalars[32 * i], &s);
+        products[i] = pubkeys[i];
+        CHECK(secp256k1_ec_pubkey_tweak_mul(ctx, &products[i], &scalars[32 * i]) == 1);
+        pubkey_ptrs[i] = &pubkeys[i];
+        product_ptrs[i] = &products[i];
+        scalar_ptrs[i] = &scalars[32 * i];
+    }
+    /* The last scalar is used for the generator. */
+    CHECK(secp256k1_ec_pubkey_create(ctx, &products[n], &scalars[32 * n]) == 1);
+
+    CHECK(secp256k1_ec_pubkey_combine(ctx, &expected, product_ptrs, n + 1) == 1);
+    CHECK(secp256k1_ecmult_multi(ctx, scratch, &result, &scalars[32 * n], pubkey_ptrs, scalar_ptrs, n) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    if (n > 0) {
+        CHECK(secp256k1_ec_pubkey_combine(ctx, &expected, product_ptrs, n) == 1);
+        CHECK(secp256k1_ecmult_multi(ctx, scratch, &result, NULL, pubkey_ptrs, scalar_ptrs, n) == 1);
+        CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    }
+
+    /* Adding P with scalar -1 cancels P with scalar 1 */
+    if (n >= 2) {
+        secp256k1_scalar minus_one;
+        unsigned char minus_one32[32];
+        secp256k1_scalar_set_int(&minus_one, 1);
+        secp256k1_scalar_negate(&minus_one, &minus_one);
+        secp256k1_scalar_get_b32(minus_one32, &minus_one);
+        pubkey_ptrs[1] = pubkey_ptrs[0];
+        scalar_ptrs[0] = one;
+        scalar_ptrs[1] = minus_one32;
+        CHECK(secp256k1_ecmult_multi(ctx, scratch, &result, NULL, pubkey_ptrs, scalar_ptrs, 2) == 0);
+    }
+
+    free(pubkeys);
+    free(products);
+    free(scalars);
+    free(pubkey_ptrs);
+    free(product_ptrs);
+    free(scalar_ptrs);
+}
+
+void test_ecmult_multi_scratch_size(void) {
+    size_t n;
+    size_t n_threads = 2 + secp256k1_rand_int(8);
+    CHECK(secp256k1_ecmult_multi_scratch_size(0) == 0);
+    CHECK(secp256k1_ecmult_multi_parallel_scratch_size(0, n_threads) == 0);
+    for (n = 1; n <= 2 * ECMULT_PIPPENGER_THRESHOLD; n += 1 + secp256k1_rand_int(16)) {
+        secp256k1_scratch *scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_ecmult_multi_scratch_size(n));
+        secp256k1_scratch *par_scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_ecmult_multi_parallel_scratch_size(n, n_threads));
+        if (n >= ECMULT_PIPPENGER_THRESHOLD) {
+            CHECK(secp256k1_pippenger_max_points(scratch, 1) >= n);
+            CHECK(secp256k1_pippenger_max_points(par_scratch, n_threads) >= n);
+        } else {
+            CHECK(secp256k1_strauss_max_points(scratch) >= n);
+            CHECK(secp256k1_strauss_max_points(par_scratch) >= n);
+        }
+        secp256k1_scratch_destroy(scratch);
+        secp256k1_scratch_destroy(par_scratch);
+    }
+}
+
+/* Runs the tasks serially, in reverse order. */
+static int test_parallel_reverse(void (*task)(void *task_data, size_t i), void *task_data, size_t n_tasks, void *data) {
+    size_t *n_calls = (size_t *) data;
+    (*n_calls)++;
+    while (n_tasks > 0) {
+        n_tasks--;
+        task(task_data, n_tasks);
+    }
+    return 1;
+}
+
+static int test_parallel_fail(void (*task)(void *task_data, size_t i), void *task_data, size_t n_tasks, void *data) {
+    (void)task;
+    (void)task_data;
+    (void)n_tasks;
+    (void)data;
+    return 0;
+}
+
+void test_ecmult_multi_parallel(void) {
+    const size_t n = 2 * ECMULT_PIPPENGER_THRESHOLD;
+    size_t n_threads = 2 + secp256k1_rand_int(8);
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_parallel_scratch_size(n, n_threads));
+    secp256k1_pubkey *pubkeys = (secp256k1_pubkey *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey) * n);
+    unsigned char *scalars = (unsigned char *)checked_malloc(&ctx->error_callback, 32 * n);
+    const secp256k1_pubkey **pubkey_ptrs = (const secp256k1_pubkey **)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey *) * n);
+    const unsigned char **scalar_ptrs = (const unsigned char **)checked_malloc(&ctx->error_callback, sizeof(unsigned char *) * n);
+    secp256k1_pubkey expected;
+    secp256k1_pubkey result;
+    unsigned char g_scalar[32];
+    size_t n_calls = 0;
+    int32_t ecount = 0;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar s;
+        unsigned char key[32];
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(key, &s);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], key) == 1);
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(&scalars[32 * i], &s);
+        pubkey_ptrs[i] = &pubkeys[i];
+        scalar_ptrs[i] = &scalars[32 * i];
+    }
+    secp256k1_rand256(g_scalar);
+
+    CHECK(secp256k1_ecmult_multi(ctx, NULL, &expected, g_scalar, pubkey_ptrs, scalar_ptrs, n) == 1);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch, &result, g_scalar, pubkey_ptrs, scalar_ptrs, n, test_parallel_reverse, &n_calls, n_threads) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    /* The whole input fits into a single batch */
+    CHECK(n_calls == 1);
+    /* A scratch space for fewer threads still works, possibly in several batches */
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch, &result, g_scalar, pubkey_ptrs, scalar_ptrs, n, test_parallel_reverse, &n_calls, 2 * n_threads) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    /* A single thread does not use the callback */
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch, &result, g_scalar, pubkey_ptrs, scalar_ptrs, n, test_parallel_fail, NULL, 1) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch, &result, g_scalar, pubkey_ptrs, scalar_ptrs, n, test_parallel_fail, NULL, n_threads) == 0);
+
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecmult_multi_parallel(ctx, scratch, &result, g_scalar, pubkey_ptrs, scalar_ptrs, n, NULL, NULL, n_threads) == 0);
+    CHECK(ecount == 1);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    free(pubkeys);
+    free(scalars);
+    free(pubkey_ptrs);
+    free(scalar_ptrs);
+}
+
+typedef struct {
+    const secp256k1_pubkey *pubkeys;
+    const unsigned char *scalars;
+    size_t fail_idx;
+} test_stream_data;
+
+static int test_stream_terms(unsigned char *scalar32, secp256k1_pubkey *pubkey, size_t idx, void *data) {
+    const test_stream_data *stream_data = (const test_stream_data *) data;
+    if (idx == stream_data->fail_idx) {
+        return 0;
+    }
+    memcpy(scalar32, &stream_data->scalars[32 * idx], 32);
+    *pubkey = stream_data->pubkeys[idx];
+    return 1;
+}
+
+void test_ecmult_multi_stream_api(void) {
+    const size_t n = 2 * ECMULT_PIPPENGER_THRESHOLD;
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    /* Too small to hold all points at once */
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 200000);
+    secp256k1_scratch_space *tiny_scratch = secp256k1_scratch_space_create(ctx, 1000);
+    secp256k1_pubkey *pubkeys = (secp256k1_pubkey *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey) * n);
+    unsigned char *scalars = (unsigned char *)checked_malloc(&ctx->error_callback, 32 * n);
+    const secp256k1_pubkey **pubkey_ptrs = (const secp256k1_pubkey **)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey *) * n);
+    const unsigned char **scalar_ptrs = (const unsigned char **)checked_malloc(&ctx->error_callback, sizeof(unsigned char *) * n);
+    test_stream_data data;
+    secp256k1_pubkey expected;
+    secp256k1_pubkey result;
+    unsigned char g_scalar[32];
+    unsigned char overflow[32];
+    secp256k1_scalar s;
+    size_t n_calls = 0;
+    int32_t ecount = 0;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        unsigned char key[32];
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(key, &s);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], key) == 1);
+        random_scalar_order(&s);
+        secp256k1_scalar_get_b32(&scalars[32 * i], &s);
+        pubkey_ptrs[i] = &pubkeys[i];
+        scalar_ptrs[i] = &scalars[32 * i];
+    }
+    random_scalar_order(&s);
+    secp256k1_scalar_get_b32(g_scalar, &s);
+    memset(overflow, 0xff, sizeof(overflow));
+    data.pubkeys = pubkeys;
+    data.scalars = scalars;
+    data.fail_idx = n;
+
+    CHECK(secp256k1_ecmult_multi(ctx, NULL, &expected, g_scalar, pubkey_ptrs, scalar_ptrs, n) == 1);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, test_stream_terms, &data, n, test_parallel_reverse, &n_calls, 3) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    CHECK(n_calls > 1);
+    CHECK(secp256k1_ecmult_multi(ctx, NULL, &expected, NULL, pubkey_ptrs, scalar_ptrs, n) == 1);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, NULL, test_stream_terms, &data, n, NULL, NULL, 0) == 1);
+    CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+
+    /* Failures */
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, NULL, test_stream_terms, &data, 0, NULL, NULL, 0) == 0);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, overflow, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, tiny_scratch, &result, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, test_stream_terms, &data, n, test_parallel_fail, NULL, 3) == 0);
+    data.fail_idx = n - 1;
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, test_stream_terms, &data, n, test_parallel_reverse, &n_calls, 3) == 0);
+    data.fail_idx = n;
+    memcpy(&scalars[32 * (n / 2)], overflow, 32);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecmult_multi_stream(none, scratch, &result, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecmult_multi_stream(none, scratch, NULL, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+    CHECK(ecount == 2);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, NULL, &result, g_scalar, test_stream_terms, &data, n, NULL, NULL, 0) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecmult_multi_stream(ctx, scratch, &result, g_scalar, NULL, &data, n, NULL, NULL, 0) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(tiny_scratch);
+    secp256k1_context_destroy(none);
+    free(pubkeys);
+    free(scalars);
+    free(pubkey_ptrs);
+    free(scalar_ptrs);
+}
+
+void test_fixed_base_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_fixed_base_table *table;
+    secp256k1_pubkey pubkey;
+    secp256k1_pubkey result;
+    unsigned char one[32] = { 0 };
+    unsigned char overflow[32];
+    int32_t ecount = 0;
+
+    one[31] = 1;
+    memset(overflow, 0xff, sizeof(overflow));
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, one) == 1);
+
+    CHECK(secp256k1_fixed_base_table_create(none, NULL) == NULL);
+    CHECK(ecount == 1);
+    /* The table can be created and used without precomputed contexts */
+    table = secp256k1_fixed_base_table_create(none, &pubkey);
+    CHECK(table != NULL);
+    CHECK(secp256k1_fixed_base_mul(none, &result, table, one, NULL) == 1);
+    CHECK(memcmp(&result, &pubkey, sizeof(pubkey)) == 0);
+    CHECK(ecount == 1);
+    /* but adding a multiple of G needs a verification context */
+    CHECK(secp256k1_fixed_base_mul(none, &result, table, one, one) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_fixed_base_mul(none, NULL, table, one, NULL) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_fixed_base_mul(none, &result, NULL, one, NULL) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_fixed_base_mul(none, &result, table, NULL, NULL) == 0);
+    CHECK(ecount == 5);
+
+    CHECK(secp256k1_fixed_base_mul(ctx, &result, table, overflow, one) == 0);
+    CHECK(secp256k1_fixed_base_mul(ctx, &result, table, one, overflow) == 0);
+    CHECK(ecount == 5);
+
+    secp256k1_fixed_base_table_destroy(table);
+    secp256k1_fixed_base_table_destroy(NULL);
+    secp256k1_context_destroy(none);
+}
+
+/* Compare secp256k1_fixed_base_mul against secp256k1_ecmult_multi */
+void test_fixed_base_mul(void) {
+    secp256k1_fixed_base_table *table;
+    secp256k1_pubkey pubkey;
+    secp256k1_pubkey expected;
+    secp256k1_pubkey result;
+    const secp256k1_pubkey *pubkey_ptrs[1];
+    const unsigned char *scalar_ptrs[1];
+    unsigned char key[32];
+    unsigned char scalar[32];
+    unsigned char g_scalar[32];
+    unsigned char zero[32] = { 0 };
+    secp256k1_scalar s;
+    int i;
+
+    random_scalar_order(&s);
+    secp256k1_scalar_get_b32(key, &s);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, key) == 1);
+    table = secp256k1_fixed_base_table_create(ctx, &pubkey);
+    CHECK(table != NULL);
+    pubkey_ptrs[0] = &pubkey;
+    scalar_ptrs[0] = scalar;
+
+    for (i = 0; i < 16; i++) {
+        random_scalar_order_test(&s);
+        secp256k1_scalar_get_b32(scalar, &s);
+        random_scalar_order_test(&s);
+        secp256k1_scalar_get_b32(g_scalar, &s);
+
+        CHECK(secp256k1_ecmult_multi(ctx, NULL, &expected, g_scalar, pubkey_ptrs, scalar_ptrs, 1) == 1);
+        CHECK(secp256k1_fixed_base_mul(ctx, &result, table, scalar, g_scalar) == 1);
+        CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+        CHECK(secp256k1_ecmult_multi(ctx, NULL, &expected, NULL, pubkey_ptrs, scalar_ptrs, 1) == 1);
+        CHECK(secp256k1_fixed_base_mul(ctx, &result, table, scalar, NULL) == 1);
+        CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &expected, g_scalar) == 1);
+        CHECK(secp256k1_fixed_base_mul(ctx, &result, table, zero, g_scalar) == 1);
+        CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+    }
+    secp256k1_fixed_base_table_destroy(table);
+
+    /* With P = G, (-key)*P + key*G is the point at infinity */
+    memset(g_scalar, 0, sizeof(g_scalar));
+    g_scalar[31] = 1;
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, g_scalar) == 1);
+    table = secp256k1_fixed_base_table_create(ctx, &pubkey);
+    CHECK(table != NULL);
+    secp256k1_scalar_set_b32(&s, key, NULL);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_scalar_get_b32(scalar, &s);
+    CHECK(secp256k1_fixed_base_mul(ctx, &result, table, scalar, key) == 0);
+    CHECK(secp256k1_fixed_base_mul(ctx, &result, table, zero, NULL) == 0);
+    secp256k1_fixed_base_table_destroy(table);
+}
+
+void test_batch_api(void) {
+    secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 10000);
+    secp256k1_scratch_space *tiny_scratch = secp256k1_scratch_space_create(ctx, 100);
+    secp256k1_batch *batch;
+    secp256k1_pubkey pubkey;
+    const secp256k1_pubkey *pubkeys[1];
+    const unsigned char *scalars[1];
+    unsigned char one[32] = { 0 };
+    unsigned char minus_one[32];
+    unsigned char overflow[32];
+    secp256k1_scalar s;
+    int32_t ecount = 0;
+
+    one[31] = 1;
+    secp256k1_scalar_set_int(&s, 1);
+    secp256k1_scalar_negate(&s, &s);
+    secp256k1_scalar_get_b32(minus_one, &s);
+    memset(overflow, 0xff, sizeof(overflow));
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, one) == 1);
+    pubkeys[0] = &pubkey;
+    scalars[0] = minus_one;
+
+    CHECK(secp256k1_batch_create(none, scratch, NULL) == NULL);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_batch_create(ctx, NULL, NULL) == NULL);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_batch_create(ctx, tiny_scratch, NULL) == NULL);
+    CHECK(ecount == 2);
+
+    batch = secp256k1_batch_create(ctx, scratch, one);
+    CHECK(batch != NULL);
+    /* An empty batch verifies */
+    CHECK(secp256k1_batch_verify(ctx, batch) == 1);
+    /* G - G = 0 */
+    CHECK(secp256k1_batch_add(ctx, batch, one, pubkeys, scalars, 1) == 1);
+    CHECK(secp256k1_batch_add(ctx, batch, NULL, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_batch_verify(ctx, batch) == 1);
+    /* G = 0 does not hold */
+    CHECK(secp256k1_batch_add(ctx, batch, one, NULL, NULL, 0) == 1);
+    CHECK(secp256k1_batch_verify(ctx, batch) == 0);
+    /* Overflowing scalars make the batch fail */
+    CHECK(secp256k1_batch_add(ctx, batch, overflow, pubkeys, scalars, 1) == 0);
+    CHECK(secp256k1_batch_verify(ctx, batch) == 0);
+    scalars[0] = overflow;
+    CHECK(secp256k1_batch_add(ctx, batch, one, pubkeys, scalars, 1) == 0);
+    CHECK(secp256k1_batch_verify(ctx, batch) == 0);
+    scalars[0] = minus_one;
+    CHECK(ecount == 2);
+
+    CHECK(secp256k1_batch_add(none, batch, one, pubkeys, scalars, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_batch_add(ctx, NULL, one, pubkeys, scalars, 1) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_batch_add(ctx, batch, one, NULL, scalars, 1) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_batch_add(ctx, batch, one, pubkeys, NULL, 1) == 0);
+    CHECK(ecount == 6);
+    CHECK(secp256k1_batch_verify(none, batch) == 0);
+    CHECK(ecount == 7);
+    CHECK(secp256k1_batch_verify(ctx, NULL) == 0);
+    CHECK(ecount == 8);
+    /* After a failed verification the batch can be reused */
+    CHECK(secp256k1_batch_add(ctx, batch, one, pubkeys, scalars, 1) == 1);
+    CHECK(secp256k1_batch_verify(ctx, batch) == 1);
+    secp256k1_batch_destroy(batch);
+    secp256k1_batch_destroy(NULL);
+
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(tiny_scratch);
+    secp256k1_context_destroy(none);
+}
+
+/* Adds n_eqs random equations with up to max_terms terms each to a batch and
+ * checks that it verifies, and that it fails if any single scalar is changed. */
+void test_batch_equations(secp256k1_scratch_space *scratch, size_t n_eqs, size_t max_terms) {
+    size_t total = n_eqs * max_terms;
+    secp256k1_pubkey *pubkeys = (secp256k1_pubkey *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey) * total);
+    unsigned char *scalars = (unsigned char *)checked_malloc(&ctx->error_callback, 32 * total);
+    unsigned char *g_scalars = (unsigned char *)checked_malloc(&ctx->error_callback, 32 * n_eqs);
+    const secp256k1_pubkey **pubkey_ptrs = (const secp256k1_pubkey **)checked_malloc(&ctx->error_callback, sizeof(secp256k1_pubkey *) * total);
+    const unsigned char **scalar_ptrs = (const unsigned char **)checked_malloc(&ctx->error_callback, sizeof(unsigned char *) * total);
+    size_t *n_terms = (size_t *)checked_malloc(&ctx->error_callback, sizeof(size_t) * n_eqs);
+    secp256k1_batch *batch;
+    unsigned char aux_rand[32];
+    size_t bad_eq = secp256k1_rand_int(n_eqs);
+    size_t bad_term;
+    size_t i, j;
+
+    secp256k1_rand256(aux_rand);
+    for (i = 0; i < n_eqs; i++) {
+        /* With P_j = x_j*G, sum(a_j*P_j) + b*G = 0 for b = -sum(a_j*x_j) */
+        secp256k1_scalar b;
+        n_terms[i] = secp256k1_rand_int(max_terms + 1);
+        secp256k1_scalar_set_int(&b, 0);
+        for (j = 0; j < n_terms[i]; j++) {
+            size_t k = i * max_terms + j;
+            secp256k1_scalar x, a;
+            unsigned char x32[32];
+            random_scalar_order(&x);
+            secp256k1_scalar_get_b32(x32, &x);
+            CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[k], x32) == 1);
+            random_scalar_order(&a);
+            secp256k1_scalar_get_b32(&scalars[32 * k], &a);
+            secp256k1_scalar_mul(&x, &x, &a);
+            secp256k1_scalar_add(&b, &b, &x);
+            pubkey_ptrs[k] = &pubkeys[k];
+            scalar_ptrs[k] = &scalars[32 * k];
+        }
+        secp256k1_scalar_negate(&b, &b);
+        secp256k1_scalar_get_b32(&g_scalars[32 * i], &b);
+    }
+
+    batch = secp256k1_batch_create(ctx, scratch, aux_rand);
+    CHECK(batch != NULL);
+    for (i = 0; i < n_eqs; i++) {
+        CHECK(secp256k1_batch_add(ctx, batch, &g_scalars[32 * i], &pubkey_ptrs[i * max_terms], &scalar_ptrs[i * max_terms], n_terms[i]) == 1);
+    }
+    CHECK(secp256k1_batch_verify(ctx, batch) == 1);
+
+    /* Break one equation, either in its G scalar or in one of its terms. */
+    bad_term = secp256k1_rand_int(n_terms[bad_eq] + 1);
+    if (bad_term == n_terms[bad_eq]) {
+        g_scalars[32 * bad_eq + 31] ^= 1;
+    } else {
+        scalars[32 * (bad_eq * max_terms + bad_term) + 31] ^= 1;
+    }
+    for (i = 0; i < n_eqs; i++) {
+        CHECK(secp256k1_batch_add(ctx, batch, &g_scalars[32 * i], &pubkey_ptrs[i * max_terms], &scalar_ptrs[i * max_terms], n_terms[i]) == 1);
+    }
+    CHECK(secp256k1_batch_verify(ctx, batch) == 0);
+    secp256k1_batch_destroy(batch);
+
+    free(pubkeys);
+    free(scalars);
+    free(g_scalars);
+    free(pubkey_ptrs);
+    free(scalar_ptrs);
+    free(n_terms);
+}
+
+void run_multi_tests(void) {
+    int i;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, secp256k1_ecmult_multi_scratch_size(3));
+
+    test_ecmult_multi_api();
+    test_ecmult_multi_scratch_size();
+    test_ecmult_multi_parallel();
+    test_ecmult_multi_stream_api();
+    test_fixed_base_api();
+    test_batch_api();
+    for (i = 0; i < count; i++) {
+        size_t n = secp256k1_rand_int(16);
+        test_ecmult_multi_pubkeys(n, scratch);
+        test_ecmult_multi_pubkeys(n, small_scratch);
+        test_ecmult_multi_pubkeys(n, NULL);
+    }
+    for (i = 0; i < (count + 15) / 16; i++) {
+        test_fixed_base_mul();
+    }
+    for (i = 0; i < count; i++) {
+        size_t n_eqs = 1 + secp256k1_rand_int(8);
+        size_t max_terms = 1 + secp256k1_rand_int(8);
+        test_batch_equations(scratch, n_eqs, max_terms);
+        test_batch_equations(small_scratch, n_eqs, max_terms);
+    }
+    test_ecmult_multi_pubkeys(2 * ECMULT_PIPPENGER_THRESHOLD, scratch);
+    test_ecmult_multi_pubkeys(2 * ECMULT_PIPPENGER_THRESHOLD, small_scratch);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(small_scratch);
+}
+
+#endif /* SECP256K1_MODULE_MULTI_TESTS_H */
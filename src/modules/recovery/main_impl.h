@@ -84,19 +84,13 @@ int secp256k1_ecdsa_recoverable_signature_convert(const secp256k1_context* ctx,
     return 1;
 }
 
-static int secp256k1_ecdsa_sig_recover(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar* sigs, secp256k1_ge *pubkey, const secp256k1_scalar *message, int recid) {
+/** Reconstruct the nonce point R of a signature from its r value and recovery id.
+ *  Returns 0 if no curve point with that x coordinate and y parity exists. */
+static int secp256k1_ecdsa_sig_recover_r(secp256k1_ge *x, const secp256k1_scalar *sigr, int recid) {
     unsigned char brx[32];
     secp256k1_fe fx;
-    secp256k1_ge x;
-    secp256k1_gej xj;
-    secp256k1_scalar rn, u1, u2;
-    secp256k1_gej qj;
     int r;
 
-    if (secp256k1_scalar_is_zero(sigr) || secp256k1_scalar_is_zero(sigs)) {
-        return 0;
-    }
-
     secp256k1_scalar_get_b32(brx, sigr);
     r = secp256k1_fe_set_b32(&fx, brx);
     (void)r;
@@ -107,7 +101,20 @@ static int secp256k1_ecdsa_sig_recover(const secp256k1_ecmult_context *ctx, cons
         }
         secp256k1_fe_add(&fx, &secp256k1_ecdsa_const_order_as_fe);
     }
-    if (!secp256k1_ge_set_xo_var(&x, &fx, recid & 1)) {
+    return secp256k1_ge_set_xo_var(x, &fx, recid & 1);
+}
+
+static int secp256k1_ecdsa_sig_recover(const secp256k1_ecmult_context *ctx, const secp256k1_scalar *sigr, const secp256k1_scalar* sigs, secp256k1_ge *pubkey, const secp256k1_scalar *message, int recid) {
+    secp256k1_ge x;
+    secp256k1_gej xj;
+    secp256k1_scalar rn, u1, u2;
+    secp256k1_gej qj;
+
+    if (secp256k1_scalar_is_zero(sigr) || secp256k1_scalar_is_zero(sigs)) {
+        return 0;
+    }
+
+    if (!secp256k1_ecdsa_sig_recover_r(&x, sigr, recid)) {
         return 0;
     }
     secp256k1_gej_set_ge(&xj, &x);
@@ -127,6 +134,7 @@ int secp256k1_ecdsa_sign_recoverable(const secp256k1_context* ctx, secp256k1_ecd
     int ret = 0;
     int overflow = 0;
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
     ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
     ARG_CHECK(msg32 != NULL);
     ARG_CHECK(signature != NULL);
@@ -173,6 +181,7 @@ int secp256k1_ecdsa_recover(const secp256k1_context* ctx, secp256k1_pubkey *pubk
     secp256k1_scalar m;
     int recid;
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
     ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
     ARG_CHECK(msg32 != NULL);
     ARG_CHECK(signature != NULL);
@@ -190,4 +199,265 @@ int secp256k1_ecdsa_recover(const secp256k1_context* ctx, secp256k1_pubkey *pubk
     }
 }
 
+/* A signature prepared for batch verification. A valid signature satisfies
+ * s*R = m*G + r*P; every entry stores that equation multiplied by a random
+ * weight a, so that a set of entries can be checked at once by verifying that
+ * sum(a*m)*G + sum(a*r*P - a*s*R) is the point at infinity. */
+typedef struct {
+    secp256k1_ge pubkey;
+    secp256k1_ge rpoint;
+    secp256k1_scalar pubkey_sc; /* a*r */
+    secp256k1_scalar rpoint_sc; /* -a*s */
+    secp256k1_scalar g_sc;      /* a*m */
+    size_t idx;
+} secp256k1_ecdsa_batch_entry;
+
+static int secp256k1_ecdsa_verify_batch_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *data) {
+    const secp256k1_ecdsa_batch_entry *entry = &((const secp256k1_ecdsa_batch_entry *) data)[idx / 2];
+    if (idx & 1) {
+        *sc = entry->rpoint_sc;
+        *pt = entry->rpoint;
+    } else {
+        *sc = entry->pubkey_sc;
+        *pt = entry->pubkey;
+    }
+    return 1;
+}
+
+/* Checks the randomized sum of all n entries with a single multi-multiplication. */
+static int secp256k1_ecdsa_verify_batch_check(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, const secp256k1_ecdsa_batch_entry *entries, size_t n) {
+    secp256k1_scalar g_sc;
+    secp256k1_gej r;
+    size_t i;
+
+    secp256k1_scalar_set_int(&g_sc, 0);
+    for (i = 0; i < n; i++) {
+        secp256k1_scalar_add(&g_sc, &g_sc, &entries[i].g_sc);
+    }
+    if (!secp256k1_ecmult_multi_var(ctx, scratch, &r, &g_sc, secp256k1_ecdsa_verify_batch_callback, (void *) entries, 2 * n)) {
+        /* The remaining scratch space is too small for even a single point;
+         * fall back to the algorithm that does not need any. */
+        secp256k1_ecmult_multi_var(ctx, NULL, &r, &g_sc, secp256k1_ecdsa_verify_batch_callback, (void *) entries, 2 * n);
+    }
+    return secp256k1_gej_is_infinity(&r);
+}
+
+/* Verifies the n entries and, if results is not NULL, bisects a failing set
+ * until every invalid entry is identified. If known_invalid is set the caller
+ * has already established that the set as a whole does not verify. */
+static int secp256k1_ecdsa_verify_batch_bisect(const secp256k1_ecmult_context *ctx, secp256k1_scratch *scratch, int *results, const secp256k1_ecdsa_batch_entry *entries, size_t n, int known_invalid) {
+    size_t i;
+    int left_ok;
+    int right_ok;
+
+    if (!known_invalid && secp256k1_ecdsa_verify_batch_check(ctx, scratch, entries, n)) {
+        if (results != NULL) {
+            for (i = 0; i < n; i++) {
+                results[entries[i].idx] = 1;
+            }
+        }
+        return 1;
+    }
+    if (results == NULL) {
+        return 0;
+    }
+    if (n == 1) {
+        results[entries[0].idx] = 0;
+        return 0;
+    }
+    /* If the left half verifies, the failure must be in the right half, so
+     * there is no need to check the right half as a whole. */
+    left_ok = secp256k1_ecdsa_verify_batch_bisect(ctx, scratch, results, entries, n / 2, 0);
+    right_ok = secp256k1_ecdsa_verify_batch_bisect(ctx, scratch, results, entries + n / 2, n - n / 2, left_ok);
+    (void)right_ok;
+    VERIFY_CHECK(!(left_ok && right_ok));
+    return 0;
+}
+
+int secp256k1_ecdsa_verify_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, int *results, const secp256k1_ecdsa_recoverable_signature * const *sigs, const unsigned char * const *msgs32, const secp256k1_pubkey * const *pubkeys, size_t n) {
+    secp256k1_ecdsa_batch_entry *entries;
+    size_t chunk;
+    size_t offset;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(n == 0 || sigs != NULL);
+    ARG_CHECK(n == 0 || msgs32 != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+
+    /* Use at most half of the scratch space for the entries, leaving the rest
+     * for the multi-multiplication. */
+    chunk = secp256k1_scratch_max_allocation(scratch, 1) / 2 / sizeof(secp256k1_ecdsa_batch_entry);
+    if (n > 0 && chunk == 0) {
+        if (results != NULL) {
+            memset(results, 0, n * sizeof(*results));
+        }
+        return 0;
+    }
+
+    for (offset = 0; offset < n; offset += chunk) {
+        size_t n_chunk = n - offset < chunk ? n - offset : chunk;
+        size_t n_entries = 0;
+        size_t i;
+        unsigned char seed[32];
+        secp256k1_sha256 sha;
+        secp256k1_rfc6979_hmac_sha256 rng;
+
+        if (!secp256k1_scratch_allocate_frame(scratch, n_chunk * sizeof(secp256k1_ecdsa_batch_entry), 1)) {
+            return 0;
+        }
+        entries = (secp256k1_ecdsa_batch_entry *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_ecdsa_batch_entry));
+
+        /* The random weights are derived from a hash of all inputs in the
+         * chunk, so they cannot be predicted by whoever chose the signatures. */
+        secp256k1_sha256_initialize(&sha);
+        for (i = offset; i < offset + n_chunk; i++) {
+            secp256k1_sha256_write(&sha, sigs[i]->data, sizeof(sigs[i]->data));
+            secp256k1_sha256_write(&sha, msgs32[i], 32);
+            secp256k1_sha256_write(&sha, pubkeys[i]->data, sizeof(pubkeys[i]->data));
+        }
+        secp256k1_sha256_finalize(&sha, seed);
+        secp256k1_rfc6979_hmac_sha256_initialize(&rng, seed, 32);
+
+        for (i = offset; i < offset + n_chunk; i++) {
+            secp256k1_ecdsa_batch_entry *entry = &entries[n_entries];
+            secp256k1_scalar r, s, m, a;
+            unsigned char a32[32];
+            int recid;
+
+            secp256k1_rfc6979_hmac_sha256_generate(&rng, a32, 32);
+            secp256k1_scalar_set_b32(&a, a32, NULL);
+            secp256k1_ecdsa_recoverable_signature_load(ctx, &r, &s, &recid, sigs[i]);
+            VERIFY_CHECK(recid >= 0 && recid < 4);  /* should have been caught in parse_compact */
+            secp256k1_scalar_set_b32(&m, msgs32[i], NULL);
+            if (secp256k1_scalar_is_zero(&r) || secp256k1_scalar_is_zero(&s) || secp256k1_scalar_is_high(&s) ||
+                secp256k1_scalar_is_zero(&a) ||
+                !secp256k1_pubkey_load(ctx, &entry->pubkey, pubkeys[i]) ||
+                !secp256k1_ecdsa_sig_recover_r(&entry->rpoint, &r, recid)) {
+                if (results != NULL) {
+                    results[i] = 0;
+                }
+                ret = 0;
+                continue;
+            }
+            secp256k1_scalar_mul(&entry->pubkey_sc, &a, &r);
+            secp256k1_scalar_mul(&entry->rpoint_sc, &a, &s);
+            secp256k1_scalar_negate(&entry->rpoint_sc, &entry->rpoint_sc);
+            secp256k1_scalar_mul(&entry->g_sc, &a, &m);
+            entry->idx = i;
+            n_entries++;
+        }
+        secp256k1_rfc6979_hmac_sha256_finalize(&rng);
+
+        if (ret || results != NULL) {
+            if (n_entries > 0 && !secp256k1_ecdsa_verify_batch_bisect(&ctx->ecmult_ctx, scratch, results, entries, n_entries, 0)) {
+                ret = 0;
+            }
+        }
+        secp256k1_scratch_deallocate_frame(scratch);
+        if (!ret && results == NULL) {
+            break;
+        }
+    }
+    return ret;
+}
+
+/* Scratch space used per signature by batch recovery: r, s, m and the inverse
+ * of r, the nonce point R, the recovered point and the signature index. The
+ * values are kept in separate arrays so that the scalar and field inversions
+ * can each be done once per chunk with Montgomery's trick. */
+#define SECP256K1_ECDSA_RECOVER_BATCH_ENTRY_SIZE (4 * sizeof(secp256k1_scalar) + sizeof(secp256k1_ge) + sizeof(secp256k1_gej) + sizeof(size_t))
+#define SECP256K1_ECDSA_RECOVER_BATCH_OBJECTS 7
+
+int secp256k1_ecdsa_recover_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, int *results, secp256k1_pubkey *pubkeys, const secp256k1_ecdsa_recoverable_signature * const *sigs, const unsigned char * const *msgs32, size_t n) {
+    size_t chunk;
+    size_t offset;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+    ARG_CHECK(n == 0 || sigs != NULL);
+    ARG_CHECK(n == 0 || msgs32 != NULL);
+
+    chunk = secp256k1_scratch_max_allocation(scratch, SECP256K1_ECDSA_RECOVER_BATCH_OBJECTS) / SECP256K1_ECDSA_RECOVER_BATCH_ENTRY_SIZE;
+    if (n > 0 && chunk == 0) {
+        memset(pubkeys, 0, n * sizeof(*pubkeys));
+        if (results != NULL) {
+            memset(results, 0, n * sizeof(*results));
+        }
+        return 0;
+    }
+
+    for (offset = 0; offset < n; offset += chunk) {
+        size_t n_chunk = n - offset < chunk ? n - offset : chunk;
+        size_t n_entries = 0;
+        size_t i;
+        secp256k1_scalar *r, *rinv, *s, *m;
+        secp256k1_ge *pt;
+        secp256k1_gej *qj;
+        size_t *idx;
+
+        if (!secp256k1_scratch_allocate_frame(scratch, n_chunk * SECP256K1_ECDSA_RECOVER_BATCH_ENTRY_SIZE, SECP256K1_ECDSA_RECOVER_BATCH_OBJECTS)) {
+            return 0;
+        }
+        r = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        rinv = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        s = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        m = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        pt = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_ge));
+        qj = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_gej));
+        idx = (size_t *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(size_t));
+
+        for (i = offset; i < offset + n_chunk; i++) {
+            int recid;
+            secp256k1_ecdsa_recoverable_signature_load(ctx, &r[n_entries], &s[n_entries], &recid, sigs[i]);
+            VERIFY_CHECK(recid >= 0 && recid < 4);  /* should have been caught in parse_compact */
+            if (secp256k1_scalar_is_zero(&r[n_entries]) || secp256k1_scalar_is_zero(&s[n_entries]) ||
+                !secp256k1_ecdsa_sig_recover_r(&pt[n_entries], &r[n_entries], recid)) {
+                memset(&pubkeys[i], 0, sizeof(pubkeys[i]));
+                if (results != NULL) {
+                    results[i] = 0;
+                }
+                ret = 0;
+                continue;
+            }
+            secp256k1_scalar_set_b32(&m[n_entries], msgs32[i], NULL);
+            idx[n_entries] = i;
+            n_entries++;
+        }
+
+        /* Q = r^-1*s*R - r^-1*m*G, as in secp256k1_ecdsa_sig_recover. */
+        secp256k1_scalar_inverse_all_var(rinv, r, n_entries);
+        for (i = 0; i < n_entries; i++) {
+            secp256k1_gej rj;
+            secp256k1_scalar u1, u2;
+            secp256k1_gej_set_ge(&rj, &pt[i]);
+            secp256k1_scalar_mul(&u1, &rinv[i], &m[i]);
+            secp256k1_scalar_negate(&u1, &u1);
+            secp256k1_scalar_mul(&u2, &rinv[i], &s[i]);
+            secp256k1_ecmult(&ctx->ecmult_ctx, &qj[i], &rj, &u2, &u1);
+        }
+        secp256k1_ge_set_all_gej_var(pt, qj, n_entries);
+
+        for (i = 0; i < n_entries; i++) {
+            int ok = !secp256k1_ge_is_infinity(&pt[i]);
+            if (ok) {
+                secp256k1_pubkey_save(&pubkeys[idx[i]], &pt[i]);
+            } else {
+                memset(&pubkeys[idx[i]], 0, sizeof(pubkeys[idx[i]]));
+                ret = 0;
+            }
+            if (results != NULL) {
+                results[idx[i]] = ok;
+            }
+        }
+        secp256k1_scratch_deallocate_frame(scratch);
+    }
+    return ret;
+}
+
 #endif /* SECP256K1_MODULE_RECOVERY_MAIN_H */
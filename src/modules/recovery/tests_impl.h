@@ -379,6 +379,173 @@ void test_ecdsa_recovery_edge_cases(void) {
     }
 }
 
+void test_ecdsa_verify_batch(void) {
+    enum { N_SIGS = 40 };
+    secp256k1_ecdsa_recoverable_signature sigs[N_SIGS];
+    secp256k1_pubkey pubkeys[N_SIGS];
+    unsigned char msgs[N_SIGS][32];
+    const secp256k1_ecdsa_recoverable_signature *sig_ptrs[N_SIGS];
+    const unsigned char *msg_ptrs[N_SIGS];
+    const secp256k1_pubkey *pubkey_ptrs[N_SIGS];
+    int results[N_SIGS];
+    int expected[N_SIGS];
+    int all_valid = 1;
+    int32_t ecount = 0;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, 5 * 2 * sizeof(secp256k1_ecdsa_batch_entry) + ALIGNMENT);
+    int i;
+
+    for (i = 0; i < N_SIGS; i++) {
+        unsigned char privkey[32];
+        secp256k1_scalar key, msg;
+        random_scalar_order_test(&key);
+        random_scalar_order_test(&msg);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_scalar_get_b32(msgs[i], &msg);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkeys[i], privkey) == 1);
+        CHECK(secp256k1_ecdsa_sign_recoverable(ctx, &sigs[i], msgs[i], privkey, NULL, NULL) == 1);
+        sig_ptrs[i] = &sigs[i];
+        msg_ptrs[i] = msgs[i];
+        pubkey_ptrs[i] = &pubkeys[i];
+    }
+
+    /* All signatures are valid. */
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, results, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == 1);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(results[i] == 1);
+    }
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, NULL, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, small_scratch, results, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, NULL, NULL, NULL, NULL, 0) == 1);
+
+    /* Damage some of them; the batch must flag exactly those. */
+    for (i = 0; i < N_SIGS; i++) {
+        secp256k1_ecdsa_signature sig;
+        int recid;
+        unsigned char sig64[64];
+        switch (secp256k1_rand_int(8)) {
+        case 0:
+            msgs[i][secp256k1_rand_int(32)] ^= 1 + secp256k1_rand_int(255);
+            break;
+        case 1:
+            /* Flip the parity of R. The converted signature still verifies,
+             * but the recovery id no longer matches. */
+            CHECK(secp256k1_ecdsa_recoverable_signature_serialize_compact(ctx, sig64, &recid, &sigs[i]) == 1);
+            CHECK(secp256k1_ecdsa_recoverable_signature_parse_compact(ctx, &sigs[i], sig64, recid ^ 1) == 1);
+            CHECK(secp256k1_ecdsa_recoverable_signature_convert(ctx, &sig, &sigs[i]) == 1);
+            CHECK(secp256k1_ecdsa_verify(ctx, &sig, msgs[i], &pubkeys[i]) == 1);
+            expected[i] = 0;
+            all_valid = 0;
+            continue;
+        }
+        CHECK(secp256k1_ecdsa_recoverable_signature_convert(ctx, &sig, &sigs[i]) == 1);
+        expected[i] = secp256k1_ecdsa_verify(ctx, &sig, msgs[i], &pubkeys[i]);
+        all_valid &= expected[i];
+    }
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, results, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == all_valid);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(results[i] == expected[i]);
+    }
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, NULL, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == all_valid);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, small_scratch, results, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == all_valid);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(results[i] == expected[i]);
+    }
+
+    /* Illegal arguments */
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, NULL, results, sig_ptrs, msg_ptrs, pubkey_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, results, NULL, msg_ptrs, pubkey_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, results, sig_ptrs, NULL, pubkey_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_verify_batch(ctx, scratch, results, sig_ptrs, msg_ptrs, NULL, N_SIGS) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(small_scratch);
+}
+
+void test_ecdsa_recover_batch(void) {
+    enum { N_SIGS = 40 };
+    secp256k1_ecdsa_recoverable_signature sigs[N_SIGS];
+    secp256k1_pubkey pubkeys[N_SIGS];
+    secp256k1_pubkey expected[N_SIGS];
+    unsigned char msgs[N_SIGS][32];
+    const secp256k1_ecdsa_recoverable_signature *sig_ptrs[N_SIGS];
+    const unsigned char *msg_ptrs[N_SIGS];
+    int results[N_SIGS];
+    int expected_results[N_SIGS];
+    int all_valid = 1;
+    int32_t ecount = 0;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, 3 * SECP256K1_ECDSA_RECOVER_BATCH_ENTRY_SIZE + SECP256K1_ECDSA_RECOVER_BATCH_OBJECTS * ALIGNMENT);
+    secp256k1_scratch_space *tiny_scratch = secp256k1_scratch_space_create(ctx, 1);
+    int i;
+
+    for (i = 0; i < N_SIGS; i++) {
+        unsigned char privkey[32];
+        secp256k1_scalar key, msg;
+        random_scalar_order_test(&key);
+        random_scalar_order_test(&msg);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_scalar_get_b32(msgs[i], &msg);
+        if (secp256k1_rand_int(4) == 0) {
+            /* A random signature, which may or may not have a public key. */
+            unsigned char sig64[64];
+            secp256k1_scalar r, s;
+            random_scalar_order_test(&r);
+            random_scalar_order_test(&s);
+            secp256k1_scalar_get_b32(sig64, &r);
+            secp256k1_scalar_get_b32(sig64 + 32, &s);
+            CHECK(secp256k1_ecdsa_recoverable_signature_parse_compact(ctx, &sigs[i], sig64, secp256k1_rand_int(4)) == 1);
+        } else {
+            CHECK(secp256k1_ecdsa_sign_recoverable(ctx, &sigs[i], msgs[i], privkey, NULL, NULL) == 1);
+        }
+        expected_results[i] = secp256k1_ecdsa_recover(ctx, &expected[i], &sigs[i], msgs[i]);
+        all_valid &= expected_results[i];
+        sig_ptrs[i] = &sigs[i];
+        msg_ptrs[i] = msgs[i];
+    }
+
+    /* The batch must agree with recovering one signature at a time. */
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, scratch, results, pubkeys, sig_ptrs, msg_ptrs, N_SIGS) == all_valid);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(results[i] == expected_results[i]);
+        CHECK(memcmp(&pubkeys[i], &expected[i], sizeof(pubkeys[i])) == 0);
+    }
+    memset(pubkeys, 0xff, sizeof(pubkeys));
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, small_scratch, NULL, pubkeys, sig_ptrs, msg_ptrs, N_SIGS) == all_valid);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(memcmp(&pubkeys[i], &expected[i], sizeof(pubkeys[i])) == 0);
+    }
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, scratch, NULL, NULL, NULL, NULL, 0) == 1);
+
+    /* A scratch space that cannot hold a single signature fails every entry. */
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, tiny_scratch, results, pubkeys, sig_ptrs, msg_ptrs, N_SIGS) == 0);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(results[i] == 0);
+    }
+
+    /* Illegal arguments */
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, NULL, results, pubkeys, sig_ptrs, msg_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, scratch, results, NULL, sig_ptrs, msg_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, scratch, results, pubkeys, NULL, msg_ptrs, N_SIGS) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_recover_batch(ctx, scratch, results, pubkeys, sig_ptrs, NULL, N_SIGS) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(small_scratch);
+    secp256k1_scratch_space_destroy(tiny_scratch);
+}
+
 void run_recovery_tests(void) {
     int i;
     for (i = 0; i < count; i++) {
@@ -388,6 +555,12 @@ void run_recovery_tests(void) {
         test_ecdsa_recovery_end_to_end();
     }
     test_ecdsa_recovery_edge_cases();
+    for (i = 0; i < count / 4 + 1; i++) {
+        test_ecdsa_verify_batch();
+    }
+    for (i = 0; i < count / 4 + 1; i++) {
+        test_ecdsa_recover_batch();
+    }
 }
 
 #endif /* SECP256K1_MODULE_RECOVERY_TESTS_H */
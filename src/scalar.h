@@ -63,6 +63,14 @@ static void secp256k1_scalar_inverse(secp256k1_scalar *r, const secp256k1_scalar
 /** Compute the inverse of a scalar (modulo the group order), without constant-time guarantee. */
 static void secp256k1_scalar_inverse_var(secp256k1_scalar *r, const secp256k1_scalar *a);
 
+/** Compute the inverses of len nonzero scalars using a single inversion (Montgomery's trick).
+ *  Constant time in the values of the scalars. r and a must not overlap. */
+static void secp256k1_scalar_inverse_all(secp256k1_scalar *r, const secp256k1_scalar *a, size_t len);
+
+/** Compute the inverses of len nonzero scalars using a single inversion (Montgomery's trick),
+ *  without constant-time guarantee. r and a must not overlap. */
+static void secp256k1_scalar_inverse_all_var(secp256k1_scalar *r, const secp256k1_scalar *a, size_t len);
+
 /** Compute the complement of a scalar (modulo the group order). */
 static void secp256k1_scalar_negate(secp256k1_scalar *r, const secp256k1_scalar *a);
 
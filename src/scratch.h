@@ -22,6 +22,10 @@ typedef struct secp256k1_scratch_space_struct {
 
 static secp256k1_scratch* secp256k1_scratch_create(const secp256k1_callback* error_callback, size_t max_size);
 
+/** Initializes a scratch space object in caller-provided memory, e.g. to hand
+ *  out parts of the budget of another scratch space */
+static void secp256k1_scratch_init(secp256k1_scratch* scratch, const secp256k1_callback* error_callback, size_t max_size);
+
 static void secp256k1_scratch_destroy(secp256k1_scratch* scratch);
 
 /** Attempts to allocate a new stack frame with `n` available bytes. Returns 1 on success, 0 on failure */
@@ -15,12 +15,16 @@
  * TODO: Determine this at configure time. */
 #define ALIGNMENT 16
 
+static void secp256k1_scratch_init(secp256k1_scratch* scratch, const secp256k1_callback* error_callback, size_t max_size) {
+    memset(scratch, 0, sizeof(*scratch));
+    scratch->max_size = max_size;
+    scratch->error_callback = error_callback;
+}
+
 static secp256k1_scratch* secp256k1_scratch_create(const secp256k1_callback* error_callback, size_t max_size) {
     secp256k1_scratch* ret = (secp256k1_scratch*)checked_malloc(error_callback, sizeof(*ret));
     if (ret != NULL) {
-        memset(ret, 0, sizeof(*ret));
-        ret->max_size = max_size;
-        ret->error_callback = error_callback;
+        secp256k1_scratch_init(ret, error_callback, max_size);
     }
     return ret;
 }
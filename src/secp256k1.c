@@ -18,6 +18,12 @@
 #include "eckey_impl.h"
 #include "hash_impl.h"
 #include "scratch_impl.h"
+#include "dispatch_impl.h"
+
+#if defined(SECP256K1_HAVE_ATOMICS) && (defined(__unix__) || defined(__APPLE__))
+#include <sched.h>
+#define SECP256K1_HAVE_SCHED_YIELD
+#endif
 
 #define ARG_CHECK(cond) do { \
     if (EXPECT(!(cond), 0)) { \
@@ -54,20 +60,101 @@ struct secp256k1_context_struct {
     secp256k1_ecmult_gen_context ecmult_gen_ctx;
     secp256k1_callback illegal_callback;
     secp256k1_callback error_callback;
+    int borrowed_tables; /* the tables belong to the caller and must not be freed */
+    int lazy_gen;        /* SECP256K1_LAZY_* state of ecmult_gen_ctx */
+    int lazy_ecmult;     /* SECP256K1_LAZY_* state of ecmult_ctx */
 };
 
+struct secp256k1_signing_session_struct {
+    /* Shares the signing table of the context it was created from, with its
+     * own blinding. */
+    secp256k1_ecmult_gen_context ecmult_gen_ctx;
+};
+
+/* A part of a context that was created with SECP256K1_CONTEXT_LAZY goes from
+ * PENDING to BUILDING when a thread starts building its tables, and from
+ * BUILDING to DONE once they are written. The tables are only read after
+ * observing DONE, which is stored with release semantics. */
+#define SECP256K1_LAZY_DONE 0 /* built, or not requested */
+#define SECP256K1_LAZY_PENDING 1
+#define SECP256K1_LAZY_BUILDING 2
+
 static const secp256k1_context secp256k1_context_no_precomp_ = {
     { 0 },
     { 0 },
     { default_illegal_callback_fn, 0 },
-    { default_error_callback_fn, 0 }
+    { default_error_callback_fn, 0 },
+    0,
+    SECP256K1_LAZY_DONE,
+    SECP256K1_LAZY_DONE
 };
 const secp256k1_context *secp256k1_context_no_precomp = &secp256k1_context_no_precomp_;
 
+/* Wait until no thread is building the part of a context with the given lazy
+ * state, and return SECP256K1_LAZY_DONE or SECP256K1_LAZY_PENDING. Building
+ * the larger tables takes milliseconds, so after a short spin the waiting
+ * thread gives up its CPU between checks. */
+static int secp256k1_context_lazy_state(const int *state) {
+#ifdef SECP256K1_HAVE_ATOMICS
+    int ret;
+    int spins = 0;
+    while ((ret = secp256k1_atomic_load(state)) == SECP256K1_LAZY_BUILDING) {
+        /* Another thread is building the tables. */
+#ifdef SECP256K1_HAVE_SCHED_YIELD
+        if (spins >= 64) {
+            sched_yield();
+            continue;
+        }
+#endif
+        secp256k1_spin_pause();
+        spins++;
+    }
+    return ret;
+#else
+    return *state;
+#endif
+}
+
+/* Build the tables of the parts in flags (SECP256K1_FLAGS_BIT_CONTEXT_*) that
+ * are still pending. May be called concurrently on the same context. */
+static void secp256k1_context_build_lazy(const secp256k1_context* ctx, unsigned int flags) {
+#ifdef SECP256K1_HAVE_ATOMICS
+    /* Only the thread that wins the transition to BUILDING writes the tables,
+     * so casting away const does not race with other writers. */
+    secp256k1_context *mut = (secp256k1_context *)ctx;
+    if ((flags & SECP256K1_FLAGS_BIT_CONTEXT_SIGN) && secp256k1_atomic_load(&ctx->lazy_gen) != SECP256K1_LAZY_DONE) {
+        if (secp256k1_atomic_cas(&mut->lazy_gen, SECP256K1_LAZY_PENDING, SECP256K1_LAZY_BUILDING)) {
+            secp256k1_ecmult_gen_context_build(&mut->ecmult_gen_ctx, &ctx->error_callback);
+            secp256k1_atomic_store(&mut->lazy_gen, SECP256K1_LAZY_DONE);
+        } else {
+            secp256k1_context_lazy_state(&ctx->lazy_gen);
+        }
+    }
+    if ((flags & SECP256K1_FLAGS_BIT_CONTEXT_VERIFY) && secp256k1_atomic_load(&ctx->lazy_ecmult) != SECP256K1_LAZY_DONE) {
+        if (secp256k1_atomic_cas(&mut->lazy_ecmult, SECP256K1_LAZY_PENDING, SECP256K1_LAZY_BUILDING)) {
+            secp256k1_ecmult_context_build(&mut->ecmult_ctx, &ctx->error_callback);
+            secp256k1_atomic_store(&mut->lazy_ecmult, SECP256K1_LAZY_DONE);
+        } else {
+            secp256k1_context_lazy_state(&ctx->lazy_ecmult);
+        }
+    }
+#else
+    (void)ctx;
+    (void)flags;
+#endif
+}
+
 secp256k1_context* secp256k1_context_create(unsigned int flags) {
     secp256k1_context* ret = (secp256k1_context*)checked_malloc(&default_error_callback, sizeof(secp256k1_context));
+    int lazy = 0;
     ret->illegal_callback = default_illegal_callback;
     ret->error_callback = default_error_callback;
+    ret->borrowed_tables = 0;
+    ret->lazy_gen = SECP256K1_LAZY_DONE;
+    ret->lazy_ecmult = SECP256K1_LAZY_DONE;
+#ifdef SECP256K1_HAVE_ATOMICS
+    lazy = (flags & SECP256K1_FLAGS_BIT_CONTEXT_LAZY) != 0;
+#endif
 
     if (EXPECT((flags & SECP256K1_FLAGS_TYPE_MASK) != SECP256K1_FLAGS_TYPE_CONTEXT, 0)) {
             secp256k1_callback_call(&ret->illegal_callback,
@@ -76,14 +163,23 @@ secp256k1_context* secp256k1_context_create(unsigned int flags) {
             return NULL;
     }
 
+    secp256k1_dispatch_init();
     secp256k1_ecmult_context_init(&ret->ecmult_ctx);
     secp256k1_ecmult_gen_context_init(&ret->ecmult_gen_ctx);
 
     if (flags & SECP256K1_FLAGS_BIT_CONTEXT_SIGN) {
-        secp256k1_ecmult_gen_context_build(&ret->ecmult_gen_ctx, &ret->error_callback);
+        if (lazy) {
+            ret->lazy_gen = SECP256K1_LAZY_PENDING;
+        } else {
+            secp256k1_ecmult_gen_context_build(&ret->ecmult_gen_ctx, &ret->error_callback);
+        }
     }
     if (flags & SECP256K1_FLAGS_BIT_CONTEXT_VERIFY) {
-        secp256k1_ecmult_context_build(&ret->ecmult_ctx, &ret->error_callback);
+        if (lazy) {
+            ret->lazy_ecmult = SECP256K1_LAZY_PENDING;
+        } else {
+            secp256k1_ecmult_context_build(&ret->ecmult_ctx, &ret->error_callback);
+        }
     }
 
     return ret;
@@ -93,14 +189,37 @@ secp256k1_context* secp256k1_context_clone(const secp256k1_context* ctx) {
     secp256k1_context* ret = (secp256k1_context*)checked_malloc(&ctx->error_callback, sizeof(secp256k1_context));
     ret->illegal_callback = ctx->illegal_callback;
     ret->error_callback = ctx->error_callback;
-    secp256k1_ecmult_context_clone(&ret->ecmult_ctx, &ctx->ecmult_ctx, &ctx->error_callback);
-    secp256k1_ecmult_gen_context_clone(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx, &ctx->error_callback);
+    ret->borrowed_tables = ctx->borrowed_tables;
+    /* Pending parts stay pending in the clone, and their tables are not read
+     * as another thread may be building them. */
+    ret->lazy_gen = secp256k1_context_lazy_state(&ctx->lazy_gen);
+    ret->lazy_ecmult = secp256k1_context_lazy_state(&ctx->lazy_ecmult);
+    if (ctx->borrowed_tables) {
+        /* Borrowed tables are read in place by every clone. */
+        ret->ecmult_ctx = ctx->ecmult_ctx;
+        ret->ecmult_gen_ctx = ctx->ecmult_gen_ctx;
+    } else {
+        if (ret->lazy_ecmult == SECP256K1_LAZY_PENDING) {
+            secp256k1_ecmult_context_init(&ret->ecmult_ctx);
+        } else {
+            secp256k1_ecmult_context_clone(&ret->ecmult_ctx, &ctx->ecmult_ctx, &ctx->error_callback);
+        }
+        if (ret->lazy_gen == SECP256K1_LAZY_PENDING) {
+            secp256k1_ecmult_gen_context_init(&ret->ecmult_gen_ctx);
+        } else {
+            secp256k1_ecmult_gen_context_clone(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx, &ctx->error_callback);
+        }
+    }
     return ret;
 }
 
 void secp256k1_context_destroy(secp256k1_context* ctx) {
     CHECK(ctx != secp256k1_context_no_precomp);
     if (ctx != NULL) {
+        if (ctx->borrowed_tables) {
+            secp256k1_ecmult_context_init(&ctx->ecmult_ctx);
+            ctx->ecmult_gen_ctx.prec = NULL;
+        }
         secp256k1_ecmult_context_clear(&ctx->ecmult_ctx);
         secp256k1_ecmult_gen_context_clear(&ctx->ecmult_gen_ctx);
 
@@ -108,6 +227,230 @@ void secp256k1_context_destroy(secp256k1_context* ctx) {
     }
 }
 
+/* Serialized tables start with a header of SECP256K1_TABLES_HEADER_SIZE bytes,
+ * holding native 32-bit words at the following offsets followed by zeros,
+ * followed by the signing table (if present) and the verification tables (if
+ * present). The header size keeps the tables aligned. */
+#define SECP256K1_TABLES_HEADER_SIZE 64
+#define SECP256K1_TABLES_MAGIC_OFFSET 0 /* "secp256k" */
+#define SECP256K1_TABLES_VERSION_OFFSET 8
+#define SECP256K1_TABLES_BYTE_ORDER_OFFSET 12 /* 0x01020304 */
+#define SECP256K1_TABLES_ENTRY_SIZE_OFFSET 16
+#define SECP256K1_TABLES_FLAGS_OFFSET 20 /* SECP256K1_FLAGS_BIT_CONTEXT_* */
+#define SECP256K1_TABLES_WINDOW_G_OFFSET 24
+#define SECP256K1_TABLES_ENDOMORPHISM_OFFSET 28 /* 1 if used, 2 if also for signing */
+#define SECP256K1_TABLES_GEN_PREC_BITS_OFFSET 32
+#define SECP256K1_TABLES_LENGTH_OFFSET 36 /* of the tables after the header */
+#define SECP256K1_TABLES_CHECKSUM_OFFSET 40 /* two words, see secp256k1_tables_checksum_update */
+#define SECP256K1_TABLES_RESERVED_OFFSET 48
+#define SECP256K1_TABLES_VERSION 1
+#if defined(USE_ECMULT_GEN_GLV)
+#define SECP256K1_TABLES_ENDOMORPHISM 2
+#elif defined(USE_ENDOMORPHISM)
+#define SECP256K1_TABLES_ENDOMORPHISM 1
+#else
+#define SECP256K1_TABLES_ENDOMORPHISM 0
+#endif
+
+static const unsigned char secp256k1_tables_magic[8] = {'s', 'e', 'c', 'p', '2', '5', '6', 'k'};
+
+static size_t secp256k1_tables_gen_size(void) {
+    return sizeof(secp256k1_ge_storage) * ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_G;
+}
+
+static size_t secp256k1_tables_ecmult_size(void) {
+#ifdef USE_ENDOMORPHISM
+    return 2 * sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
+#else
+    return sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
+#endif
+}
+
+static void secp256k1_tables_write32(unsigned char *header, size_t offset, uint32_t v) {
+    memcpy(header + offset, &v, sizeof(v));
+}
+
+static uint32_t secp256k1_tables_read32(const unsigned char *header, size_t offset) {
+    uint32_t v;
+    memcpy(&v, header + offset, sizeof(v));
+    return v;
+}
+
+/** A Fletcher-style checksum over the native 32-bit words of the tables. It
+ *  is only meant to catch truncated or damaged files, and runs at memory
+ *  speed. Start with acc = {1, 0}, add the tables in order with
+ *  secp256k1_tables_checksum_update and get the two header words with
+ *  secp256k1_tables_checksum_finalize. */
+static void secp256k1_tables_checksum_update(uint64_t *acc, const secp256k1_ge_storage *table, size_t len) {
+    const uint32_t *words = (const uint32_t *)table;
+    uint64_t a = acc[0], b = acc[1];
+    size_t i;
+    VERIFY_CHECK(len % sizeof(secp256k1_ge_storage) == 0);
+    for (i = 0; i < len / 4; i++) {
+        a += words[i];
+        b += a;
+    }
+    acc[0] = a;
+    acc[1] = b;
+}
+
+static void secp256k1_tables_checksum_finalize(uint32_t *sum, const uint64_t *acc) {
+    sum[0] = (uint32_t)(acc[0] ^ (acc[0] >> 32));
+    sum[1] = (uint32_t)(acc[1] ^ (acc[1] >> 32));
+}
+
+size_t secp256k1_context_tables_size(const secp256k1_context* ctx) {
+    size_t ret = SECP256K1_TABLES_HEADER_SIZE;
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN | SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
+    if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx)) {
+        ret += secp256k1_tables_gen_size();
+    }
+    if (secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx)) {
+        ret += secp256k1_tables_ecmult_size();
+    }
+    return ret;
+}
+
+int secp256k1_context_tables_serialize(const secp256k1_context* ctx, unsigned char *output, size_t outputlen) {
+    size_t len;
+    unsigned char *tables;
+    uint32_t flags = 0;
+    uint64_t acc[2] = {1, 0};
+    uint32_t sum[2];
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(output != NULL);
+    len = secp256k1_context_tables_size(ctx);
+    if (outputlen < len) {
+        return 0;
+    }
+
+    /* The checksum is computed over the context's own (aligned) tables, as
+     * output need not be aligned. */
+    tables = output + SECP256K1_TABLES_HEADER_SIZE;
+    if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx)) {
+        memcpy(tables, ctx->ecmult_gen_ctx.prec, secp256k1_tables_gen_size());
+        secp256k1_tables_checksum_update(acc, &(*ctx->ecmult_gen_ctx.prec)[0][0], secp256k1_tables_gen_size());
+        tables += secp256k1_tables_gen_size();
+        flags |= SECP256K1_FLAGS_BIT_CONTEXT_SIGN;
+    }
+    if (secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx)) {
+        size_t size = sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G);
+        memcpy(tables, ctx->ecmult_ctx.pre_g, size);
+        secp256k1_tables_checksum_update(acc, *ctx->ecmult_ctx.pre_g, size);
+#ifdef USE_ENDOMORPHISM
+        memcpy(tables + size, ctx->ecmult_ctx.pre_g_128, size);
+        secp256k1_tables_checksum_update(acc, *ctx->ecmult_ctx.pre_g_128, size);
+#endif
+        flags |= SECP256K1_FLAGS_BIT_CONTEXT_VERIFY;
+    }
+    secp256k1_tables_checksum_finalize(sum, acc);
+
+    memset(output, 0, SECP256K1_TABLES_HEADER_SIZE);
+    memcpy(output + SECP256K1_TABLES_MAGIC_OFFSET, secp256k1_tables_magic, sizeof(secp256k1_tables_magic));
+    secp256k1_tables_write32(output, SECP256K1_TABLES_VERSION_OFFSET, SECP256K1_TABLES_VERSION);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_BYTE_ORDER_OFFSET, 0x01020304);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_ENTRY_SIZE_OFFSET, sizeof(secp256k1_ge_storage));
+    secp256k1_tables_write32(output, SECP256K1_TABLES_FLAGS_OFFSET, flags);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_WINDOW_G_OFFSET, WINDOW_G);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_ENDOMORPHISM_OFFSET, SECP256K1_TABLES_ENDOMORPHISM);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_GEN_PREC_BITS_OFFSET, ECMULT_GEN_PREC_BITS);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_LENGTH_OFFSET, len - SECP256K1_TABLES_HEADER_SIZE);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_CHECKSUM_OFFSET, sum[0]);
+    secp256k1_tables_write32(output, SECP256K1_TABLES_CHECKSUM_OFFSET + 4, sum[1]);
+    return 1;
+}
+
+/* Returns the flags of the parts contained in tables, or 0 if the header does
+ * not match this library or the checksum is wrong. */
+static uint32_t secp256k1_tables_check(const unsigned char *tables, size_t tableslen) {
+    uint32_t flags, len, sum[2];
+    uint64_t acc[2] = {1, 0};
+    static const unsigned char zeros[SECP256K1_TABLES_HEADER_SIZE - SECP256K1_TABLES_RESERVED_OFFSET] = {0};
+    if (tableslen < SECP256K1_TABLES_HEADER_SIZE ||
+        memcmp(tables + SECP256K1_TABLES_MAGIC_OFFSET, secp256k1_tables_magic, sizeof(secp256k1_tables_magic)) != 0 ||
+        memcmp(tables + SECP256K1_TABLES_RESERVED_OFFSET, zeros, sizeof(zeros)) != 0 ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_VERSION_OFFSET) != SECP256K1_TABLES_VERSION ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_BYTE_ORDER_OFFSET) != 0x01020304 ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_ENTRY_SIZE_OFFSET) != sizeof(secp256k1_ge_storage) ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_WINDOW_G_OFFSET) != WINDOW_G ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_ENDOMORPHISM_OFFSET) != SECP256K1_TABLES_ENDOMORPHISM ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_GEN_PREC_BITS_OFFSET) != ECMULT_GEN_PREC_BITS) {
+        return 0;
+    }
+    flags = secp256k1_tables_read32(tables, SECP256K1_TABLES_FLAGS_OFFSET);
+    if ((flags & ~(uint32_t)(SECP256K1_FLAGS_BIT_CONTEXT_SIGN | SECP256K1_FLAGS_BIT_CONTEXT_VERIFY)) != 0) {
+        return 0;
+    }
+    len = 0;
+    if (flags & SECP256K1_FLAGS_BIT_CONTEXT_SIGN) {
+        len += secp256k1_tables_gen_size();
+    }
+    if (flags & SECP256K1_FLAGS_BIT_CONTEXT_VERIFY) {
+        len += secp256k1_tables_ecmult_size();
+    }
+    if (secp256k1_tables_read32(tables, SECP256K1_TABLES_LENGTH_OFFSET) != len ||
+        tableslen - SECP256K1_TABLES_HEADER_SIZE < len) {
+        return 0;
+    }
+    secp256k1_tables_checksum_update(acc, (const secp256k1_ge_storage *)(tables + SECP256K1_TABLES_HEADER_SIZE), len);
+    secp256k1_tables_checksum_finalize(sum, acc);
+    if (secp256k1_tables_read32(tables, SECP256K1_TABLES_CHECKSUM_OFFSET) != sum[0] ||
+        secp256k1_tables_read32(tables, SECP256K1_TABLES_CHECKSUM_OFFSET + 4) != sum[1]) {
+        return 0;
+    }
+    return flags;
+}
+
+secp256k1_context* secp256k1_context_create_from_tables(unsigned int flags, const unsigned char *tables, size_t tableslen) {
+    secp256k1_context* ret;
+    const unsigned char *p;
+    uint32_t contained;
+
+    if (EXPECT((flags & SECP256K1_FLAGS_TYPE_MASK) != SECP256K1_FLAGS_TYPE_CONTEXT, 0) ||
+        EXPECT(tables == NULL, 0) || EXPECT(((uintptr_t)tables & 15) != 0, 0)) {
+        secp256k1_callback_call(&default_illegal_callback, "Invalid flags or tables");
+        return NULL;
+    }
+    contained = secp256k1_tables_check(tables, tableslen);
+    if (contained == 0 || (flags & (SECP256K1_FLAGS_BIT_CONTEXT_SIGN | SECP256K1_FLAGS_BIT_CONTEXT_VERIFY) & ~contained) != 0) {
+        return NULL;
+    }
+
+    p = tables + SECP256K1_TABLES_HEADER_SIZE;
+    ret = (secp256k1_context*)checked_malloc(&default_error_callback, sizeof(secp256k1_context));
+    ret->illegal_callback = default_illegal_callback;
+    ret->error_callback = default_error_callback;
+    ret->borrowed_tables = 1;
+    ret->lazy_gen = SECP256K1_LAZY_DONE;
+    ret->lazy_ecmult = SECP256K1_LAZY_DONE;
+    secp256k1_dispatch_init();
+    secp256k1_ecmult_context_init(&ret->ecmult_ctx);
+    secp256k1_ecmult_gen_context_init(&ret->ecmult_gen_ctx);
+
+    if (contained & SECP256K1_FLAGS_BIT_CONTEXT_SIGN) {
+        if (flags & SECP256K1_FLAGS_BIT_CONTEXT_SIGN) {
+            ret->ecmult_gen_ctx.prec = (secp256k1_ge_storage (*)[ECMULT_GEN_PREC_N][ECMULT_GEN_PREC_G])p;
+            secp256k1_ecmult_gen_blind(&ret->ecmult_gen_ctx, NULL);
+        }
+        p += secp256k1_tables_gen_size();
+    }
+    if (flags & SECP256K1_FLAGS_BIT_CONTEXT_VERIFY) {
+        secp256k1_ge g;
+        ret->ecmult_ctx.pre_g = (secp256k1_ge_storage (*)[])p;
+#ifdef USE_ENDOMORPHISM
+        ret->ecmult_ctx.pre_g_128 = (secp256k1_ge_storage (*)[])(p + sizeof(secp256k1_ge_storage) * ECMULT_TABLE_SIZE(WINDOW_G));
+#endif
+        /* The first entry is G itself, which catches a different field representation. */
+        secp256k1_ge_from_storage(&g, &(*ret->ecmult_ctx.pre_g)[0]);
+        if (!secp256k1_fe_equal_var(&g.x, &secp256k1_ge_const_g.x) || !secp256k1_fe_equal_var(&g.y, &secp256k1_ge_const_g.y)) {
+            secp256k1_context_destroy(ret);
+            return NULL;
+        }
+    }
+    return ret;
+}
+
 void secp256k1_context_set_illegal_callback(secp256k1_context* ctx, void (*fun)(const char* message, void* data), const void* data) {
     CHECK(ctx != secp256k1_context_no_precomp);
     if (fun == NULL) {
@@ -316,6 +659,7 @@ int secp256k1_ecdsa_verify(const secp256k1_context* ctx, const secp256k1_ecdsa_s
     secp256k1_scalar r, s;
     secp256k1_scalar m;
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
     ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
     ARG_CHECK(msg32 != NULL);
     ARG_CHECK(sig != NULL);
@@ -366,16 +710,11 @@ static int nonce_function_rfc6979(unsigned char *nonce32, const unsigned char *m
 const secp256k1_nonce_function secp256k1_nonce_function_rfc6979 = nonce_function_rfc6979;
 const secp256k1_nonce_function secp256k1_nonce_function_default = nonce_function_rfc6979;
 
-int secp256k1_ecdsa_sign(const secp256k1_context* ctx, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const unsigned char *seckey, secp256k1_nonce_function noncefp, const void* noncedata) {
+static int secp256k1_ecdsa_sign_inner(const secp256k1_ecmult_gen_context* gen_ctx, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const unsigned char *seckey, secp256k1_nonce_function noncefp, const void* noncedata) {
     secp256k1_scalar r, s;
     secp256k1_scalar sec, non, msg;
     int ret = 0;
     int overflow = 0;
-    VERIFY_CHECK(ctx != NULL);
-    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
-    ARG_CHECK(msg32 != NULL);
-    ARG_CHECK(signature != NULL);
-    ARG_CHECK(seckey != NULL);
     if (noncefp == NULL) {
         noncefp = secp256k1_nonce_function_default;
     }
@@ -393,7 +732,7 @@ int secp256k1_ecdsa_sign(const secp256k1_context* ctx, secp256k1_ecdsa_signature
             }
             secp256k1_scalar_set_b32(&non, nonce32, &overflow);
             if (!overflow && !secp256k1_scalar_is_zero(&non)) {
-                if (secp256k1_ecdsa_sig_sign(&ctx->ecmult_gen_ctx, &r, &s, &sec, &msg, &non, NULL)) {
+                if (secp256k1_ecdsa_sig_sign(gen_ctx, &r, &s, &sec, &msg, &non, NULL)) {
                     break;
                 }
             }
@@ -412,6 +751,132 @@ int secp256k1_ecdsa_sign(const secp256k1_context* ctx, secp256k1_ecdsa_signature
     return ret;
 }
 
+int secp256k1_ecdsa_sign(const secp256k1_context* ctx, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const unsigned char *seckey, secp256k1_nonce_function noncefp, const void* noncedata) {
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(signature != NULL);
+    ARG_CHECK(seckey != NULL);
+    return secp256k1_ecdsa_sign_inner(&ctx->ecmult_gen_ctx, signature, msg32, seckey, noncefp, noncedata);
+}
+
+int secp256k1_ecdsa_sign_with_session(const secp256k1_context* ctx, secp256k1_signing_session *session, secp256k1_ecdsa_signature *signature, const unsigned char *msg32, const unsigned char *seckey, secp256k1_nonce_function noncefp, const void* noncedata) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(session != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(signature != NULL);
+    ARG_CHECK(seckey != NULL);
+    return secp256k1_ecdsa_sign_inner(&session->ecmult_gen_ctx, signature, msg32, seckey, noncefp, noncedata);
+}
+
+/* Scratch space used per signature by batch signing: the secret key, message,
+ * nonce and nonce inverse, the nonce point in jacobian and affine coordinates,
+ * and the signature index. */
+#define SECP256K1_ECDSA_SIGN_BATCH_ENTRY_SIZE (4 * sizeof(secp256k1_scalar) + sizeof(secp256k1_gej) + sizeof(secp256k1_ge) + sizeof(size_t))
+#define SECP256K1_ECDSA_SIGN_BATCH_OBJECTS 7
+
+int secp256k1_ecdsa_sign_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_ecdsa_signature *signatures, const unsigned char * const *msgs32, const unsigned char * const *seckeys, size_t n, secp256k1_nonce_function noncefp, const void* noncedata) {
+    size_t chunk;
+    size_t offset;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(n == 0 || signatures != NULL);
+    ARG_CHECK(n == 0 || msgs32 != NULL);
+    ARG_CHECK(n == 0 || seckeys != NULL);
+    if (noncefp == NULL) {
+        noncefp = secp256k1_nonce_function_default;
+    }
+
+    chunk = secp256k1_scratch_max_allocation(scratch, SECP256K1_ECDSA_SIGN_BATCH_OBJECTS) / SECP256K1_ECDSA_SIGN_BATCH_ENTRY_SIZE;
+    if (n > 0 && chunk == 0) {
+        memset(signatures, 0, n * sizeof(*signatures));
+        return 0;
+    }
+
+    for (offset = 0; offset < n; offset += chunk) {
+        size_t n_chunk = n - offset < chunk ? n - offset : chunk;
+        size_t n_entries = 0;
+        size_t i;
+        secp256k1_scalar *sec, *msg, *non, *noninv;
+        secp256k1_gej *rj;
+        secp256k1_ge *r;
+        size_t *idx;
+
+        if (!secp256k1_scratch_allocate_frame(scratch, n_chunk * SECP256K1_ECDSA_SIGN_BATCH_ENTRY_SIZE, SECP256K1_ECDSA_SIGN_BATCH_OBJECTS)) {
+            return 0;
+        }
+        sec = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        msg = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        non = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        noninv = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        rj = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_gej));
+        r = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_ge));
+        idx = (size_t *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(size_t));
+
+        /* Derive the first valid nonce of every signature, exactly as
+         * secp256k1_ecdsa_sign does. */
+        for (i = offset; i < offset + n_chunk; i++) {
+            unsigned char nonce32[32];
+            unsigned int count = 0;
+            int overflow = 0;
+            int ok;
+            secp256k1_scalar_set_b32(&sec[n_entries], seckeys[i], &overflow);
+            ok = !overflow && !secp256k1_scalar_is_zero(&sec[n_entries]);
+            while (ok) {
+                ok = noncefp(nonce32, msgs32[i], seckeys[i], NULL, (void*)noncedata, count);
+                if (!ok) {
+                    break;
+                }
+                secp256k1_scalar_set_b32(&non[n_entries], nonce32, &overflow);
+                if (!overflow && !secp256k1_scalar_is_zero(&non[n_entries])) {
+                    break;
+                }
+                count++;
+            }
+            memset(nonce32, 0, 32);
+            if (!ok) {
+                memset(&signatures[i], 0, sizeof(signatures[i]));
+                ret = 0;
+                continue;
+            }
+            secp256k1_scalar_set_b32(&msg[n_entries], msgs32[i], NULL);
+            idx[n_entries] = i;
+            n_entries++;
+        }
+
+        /* Compute all nonce points R = k*G with the blinded generator
+         * multiplication, then convert them to affine coordinates and invert
+         * the nonces with one constant-time inversion each. */
+        secp256k1_ecmult_gen_batch(&ctx->ecmult_gen_ctx, rj, non, n_entries);
+        secp256k1_ge_set_all_gej(r, rj, n_entries);
+        secp256k1_scalar_inverse_all(noninv, non, n_entries);
+
+        for (i = 0; i < n_entries; i++) {
+            secp256k1_scalar sigr, sigs;
+            if (secp256k1_ecdsa_sig_sign_finish(&sigr, &sigs, &r[i], &sec[i], &msg[i], &noninv[i], NULL)) {
+                secp256k1_ecdsa_signature_save(&signatures[idx[i]], &sigr, &sigs);
+            } else {
+                /* The first nonce gave s = 0, which is cryptographically
+                 * unreachable; let the single-signature path find the next. */
+                ret &= secp256k1_ecdsa_sign(ctx, &signatures[idx[i]], msgs32[idx[i]], seckeys[idx[i]], noncefp, noncedata);
+            }
+        }
+
+        memset(sec, 0, n_chunk * sizeof(secp256k1_scalar));
+        memset(msg, 0, n_chunk * sizeof(secp256k1_scalar));
+        memset(non, 0, n_chunk * sizeof(secp256k1_scalar));
+        memset(noninv, 0, n_chunk * sizeof(secp256k1_scalar));
+        memset(rj, 0, n_chunk * sizeof(secp256k1_gej));
+        memset(r, 0, n_chunk * sizeof(secp256k1_ge));
+        secp256k1_scratch_deallocate_frame(scratch);
+    }
+    return ret;
+}
+
 int secp256k1_ec_seckey_verify(const secp256k1_context* ctx, const unsigned char *seckey) {
     secp256k1_scalar sec;
     int ret;
@@ -425,22 +890,17 @@ int secp256k1_ec_seckey_verify(const secp256k1_context* ctx, const unsigned char
     return ret;
 }
 
-int secp256k1_ec_pubkey_create(const secp256k1_context* ctx, secp256k1_pubkey *pubkey, const unsigned char *seckey) {
+static int secp256k1_ec_pubkey_create_inner(const secp256k1_ecmult_gen_context* gen_ctx, secp256k1_pubkey *pubkey, const unsigned char *seckey) {
     secp256k1_gej pj;
     secp256k1_ge p;
     secp256k1_scalar sec;
     int overflow;
     int ret = 0;
-    VERIFY_CHECK(ctx != NULL);
-    ARG_CHECK(pubkey != NULL);
-    memset(pubkey, 0, sizeof(*pubkey));
-    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
-    ARG_CHECK(seckey != NULL);
 
     secp256k1_scalar_set_b32(&sec, seckey, &overflow);
     ret = (!overflow) & (!secp256k1_scalar_is_zero(&sec));
     if (ret) {
-        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &sec);
+        secp256k1_ecmult_gen(gen_ctx, &pj, &sec);
         secp256k1_ge_set_gej(&p, &pj);
         secp256k1_pubkey_save(pubkey, &p);
     }
@@ -448,6 +908,92 @@ int secp256k1_ec_pubkey_create(const secp256k1_context* ctx, secp256k1_pubkey *p
     return ret;
 }
 
+int secp256k1_ec_pubkey_create(const secp256k1_context* ctx, secp256k1_pubkey *pubkey, const unsigned char *seckey) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey != NULL);
+    memset(pubkey, 0, sizeof(*pubkey));
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(seckey != NULL);
+    return secp256k1_ec_pubkey_create_inner(&ctx->ecmult_gen_ctx, pubkey, seckey);
+}
+
+int secp256k1_ec_pubkey_create_with_session(const secp256k1_context* ctx, secp256k1_signing_session *session, secp256k1_pubkey *pubkey, const unsigned char *seckey) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(pubkey != NULL);
+    memset(pubkey, 0, sizeof(*pubkey));
+    ARG_CHECK(session != NULL);
+    ARG_CHECK(seckey != NULL);
+    return secp256k1_ec_pubkey_create_inner(&session->ecmult_gen_ctx, pubkey, seckey);
+}
+
+/* Scratch space used per key by batch public key creation: the secret key, the
+ * public key in jacobian and affine coordinates and its index. */
+#define SECP256K1_EC_PUBKEY_CREATE_BATCH_ENTRY_SIZE (sizeof(secp256k1_scalar) + sizeof(secp256k1_gej) + sizeof(secp256k1_ge) + sizeof(size_t))
+#define SECP256K1_EC_PUBKEY_CREATE_BATCH_OBJECTS 4
+
+int secp256k1_ec_pubkey_create_batch(const secp256k1_context* ctx, secp256k1_scratch_space *scratch, secp256k1_pubkey *pubkeys, const unsigned char * const *seckeys, size_t n) {
+    size_t chunk;
+    size_t offset;
+    int ret = 1;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+    if (n > 0) {
+        memset(pubkeys, 0, n * sizeof(*pubkeys));
+    }
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(n == 0 || seckeys != NULL);
+
+    chunk = secp256k1_scratch_max_allocation(scratch, SECP256K1_EC_PUBKEY_CREATE_BATCH_OBJECTS) / SECP256K1_EC_PUBKEY_CREATE_BATCH_ENTRY_SIZE;
+    if (n > 0 && chunk == 0) {
+        return 0;
+    }
+
+    for (offset = 0; offset < n; offset += chunk) {
+        size_t n_chunk = n - offset < chunk ? n - offset : chunk;
+        size_t n_entries = 0;
+        size_t i;
+        secp256k1_scalar *sec;
+        secp256k1_gej *pj;
+        secp256k1_ge *p;
+        size_t *idx;
+
+        if (!secp256k1_scratch_allocate_frame(scratch, n_chunk * SECP256K1_EC_PUBKEY_CREATE_BATCH_ENTRY_SIZE, SECP256K1_EC_PUBKEY_CREATE_BATCH_OBJECTS)) {
+            return 0;
+        }
+        sec = (secp256k1_scalar *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_scalar));
+        pj = (secp256k1_gej *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_gej));
+        p = (secp256k1_ge *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(secp256k1_ge));
+        idx = (size_t *) secp256k1_scratch_alloc(scratch, n_chunk * sizeof(size_t));
+
+        for (i = offset; i < offset + n_chunk; i++) {
+            int overflow;
+            secp256k1_scalar_set_b32(&sec[n_entries], seckeys[i], &overflow);
+            if (overflow || secp256k1_scalar_is_zero(&sec[n_entries])) {
+                ret = 0;
+            } else {
+                idx[n_entries] = i;
+                n_entries++;
+            }
+        }
+        secp256k1_ecmult_gen_batch(&ctx->ecmult_gen_ctx, pj, sec, n_entries);
+
+        /* Convert all results to affine coordinates with a single
+         * constant-time inversion. */
+        secp256k1_ge_set_all_gej(p, pj, n_entries);
+        for (i = 0; i < n_entries; i++) {
+            secp256k1_pubkey_save(&pubkeys[idx[i]], &p[i]);
+        }
+
+        memset(sec, 0, n_chunk * sizeof(secp256k1_scalar));
+        memset(pj, 0, n_chunk * sizeof(secp256k1_gej));
+        secp256k1_scratch_deallocate_frame(scratch);
+    }
+    return ret;
+}
+
 int secp256k1_ec_privkey_negate(const secp256k1_context* ctx, unsigned char *seckey) {
     secp256k1_scalar sec;
     VERIFY_CHECK(ctx != NULL);
@@ -504,6 +1050,7 @@ int secp256k1_ec_pubkey_tweak_add(const secp256k1_context* ctx, secp256k1_pubkey
     int ret = 0;
     int overflow = 0;
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
     ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
     ARG_CHECK(pubkey != NULL);
     ARG_CHECK(tweak != NULL);
@@ -550,6 +1097,7 @@ int secp256k1_ec_pubkey_tweak_mul(const secp256k1_context* ctx, secp256k1_pubkey
     int ret = 0;
     int overflow = 0;
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_VERIFY);
     ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
     ARG_CHECK(pubkey != NULL);
     ARG_CHECK(tweak != NULL);
@@ -568,8 +1116,38 @@ int secp256k1_ec_pubkey_tweak_mul(const secp256k1_context* ctx, secp256k1_pubkey
     return ret;
 }
 
+secp256k1_signing_session* secp256k1_signing_session_create(const secp256k1_context* ctx, const unsigned char *seed32) {
+    secp256k1_signing_session* ret;
+    VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ret = (secp256k1_signing_session*)checked_malloc(&ctx->error_callback, sizeof(secp256k1_signing_session));
+    if (ret == NULL) {
+        return NULL;
+    }
+    secp256k1_ecmult_gen_context_clone(&ret->ecmult_gen_ctx, &ctx->ecmult_gen_ctx, &ctx->error_callback);
+    if (seed32 != NULL) {
+        secp256k1_ecmult_gen_blind(&ret->ecmult_gen_ctx, seed32);
+    }
+    return ret;
+}
+
+void secp256k1_signing_session_destroy(secp256k1_signing_session* session) {
+    if (session != NULL) {
+        secp256k1_ecmult_gen_context_clear(&session->ecmult_gen_ctx);
+        free(session);
+    }
+}
+
+int secp256k1_signing_session_randomize(secp256k1_signing_session* session, const unsigned char *seed32) {
+    VERIFY_CHECK(session != NULL);
+    secp256k1_ecmult_gen_blind(&session->ecmult_gen_ctx, seed32);
+    return 1;
+}
+
 int secp256k1_context_randomize(secp256k1_context* ctx, const unsigned char *seed32) {
     VERIFY_CHECK(ctx != NULL);
+    secp256k1_context_build_lazy(ctx, SECP256K1_FLAGS_BIT_CONTEXT_SIGN);
     if (secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx)) {
         secp256k1_ecmult_gen_blind(&ctx->ecmult_gen_ctx, seed32);
     }
@@ -607,3 +1185,7 @@ int secp256k1_ec_pubkey_combine(const secp256k1_context* ctx, secp256k1_pubkey *
 #ifdef ENABLE_MODULE_RECOVERY
 # include "modules/recovery/main_impl.h"
 #endif
+
+#ifdef ENABLE_MODULE_MULTI
+# include "modules/multi/main_impl.h"
+#endif
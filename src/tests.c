@@ -18,6 +18,11 @@
 #include "include/secp256k1.h"
 #include "testrand_impl.h"
 
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+/* Not used by the library; only compared against the MULQ version. */
+#include "field_5x52_asm_mulx_impl.h"
+#endif
+
 #ifdef ENABLE_OPENSSL_TESTS
 #include "openssl/bn.h"
 #include "openssl/ec.h"
@@ -171,6 +176,22 @@ void run_context_tests(void) {
         ctx_tmp = sign; sign = secp256k1_context_clone(sign); secp256k1_context_destroy(ctx_tmp);
         ctx_tmp = vrfy; vrfy = secp256k1_context_clone(vrfy); secp256k1_context_destroy(ctx_tmp);
         ctx_tmp = both; both = secp256k1_context_clone(both); secp256k1_context_destroy(ctx_tmp);
+
+#if defined(USE_ECMULT_STATIC_PRECOMPUTATION) || defined(SECP256K1_HAVE_ATOMICS)
+        /* Clones share the tables. */
+        ctx_tmp = secp256k1_context_clone(both);
+        CHECK(ctx_tmp->ecmult_ctx.pre_g == both->ecmult_ctx.pre_g);
+        CHECK(ctx_tmp->ecmult_gen_ctx.prec == both->ecmult_gen_ctx.prec);
+        if (both->ecmult_ctx.refs != NULL) {
+            CHECK(*both->ecmult_ctx.refs == 2);
+            CHECK(*both->ecmult_gen_ctx.refs == 2);
+        }
+        secp256k1_context_destroy(ctx_tmp);
+        if (both->ecmult_ctx.refs != NULL) {
+            CHECK(*both->ecmult_ctx.refs == 1);
+            CHECK(*both->ecmult_gen_ctx.refs == 1);
+        }
+#endif
     }
 
     /* Verify that the error callback makes it across the clone. */
@@ -255,6 +276,189 @@ void run_context_tests(void) {
     secp256k1_context_destroy(NULL);
 }
 
+void run_context_tables_tests(void) {
+    secp256k1_context *both = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context *loaded;
+    secp256k1_context *clone;
+    secp256k1_pubkey pubkey, pubkey2;
+    secp256k1_ecdsa_signature sig, sig2;
+    unsigned char seckey[32], msg[32];
+    unsigned char *tables;
+    size_t len, vrfy_len, pos;
+    int32_t ecount = 0;
+
+    len = secp256k1_context_tables_size(both);
+    vrfy_len = secp256k1_context_tables_size(vrfy);
+    CHECK(vrfy_len < len);
+    CHECK(secp256k1_context_tables_size(secp256k1_context_no_precomp) < vrfy_len);
+    tables = (unsigned char *)checked_malloc(&both->error_callback, len);
+    secp256k1_context_set_illegal_callback(both, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_context_tables_serialize(both, NULL, len) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_context_tables_serialize(both, tables, len - 1) == 0);
+    CHECK(secp256k1_context_tables_serialize(both, tables, len) == 1);
+
+    /* A context using the tables signs and verifies like the original, and so do its clones. */
+    loaded = secp256k1_context_create_from_tables(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY, tables, len);
+    CHECK(loaded != NULL);
+    clone = secp256k1_context_clone(loaded);
+    secp256k1_context_destroy(loaded);
+    do {
+        secp256k1_rand256_test(seckey);
+    } while (!secp256k1_ec_seckey_verify(both, seckey));
+    secp256k1_rand256_test(msg);
+    CHECK(secp256k1_ec_pubkey_create(both, &pubkey, seckey) == 1);
+    CHECK(secp256k1_ec_pubkey_create(clone, &pubkey2, seckey) == 1);
+    CHECK(memcmp(&pubkey, &pubkey2, sizeof(pubkey)) == 0);
+    CHECK(secp256k1_ecdsa_sign(both, &sig, msg, seckey, NULL, NULL) == 1);
+    CHECK(secp256k1_context_randomize(clone, msg) == 1);
+    CHECK(secp256k1_ecdsa_sign(clone, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(memcmp(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ecdsa_verify(clone, &sig, msg, &pubkey) == 1);
+    CHECK(secp256k1_context_tables_size(clone) == len);
+    secp256k1_context_destroy(clone);
+
+    /* Only the requested parts are used, and they must be present. */
+    loaded = secp256k1_context_create_from_tables(SECP256K1_CONTEXT_VERIFY, tables, len);
+    CHECK(loaded != NULL);
+    CHECK(secp256k1_context_tables_size(loaded) == vrfy_len);
+    CHECK(secp256k1_ecdsa_verify(loaded, &sig, msg, &pubkey) == 1);
+    secp256k1_context_destroy(loaded);
+    CHECK(secp256k1_context_tables_serialize(vrfy, tables, vrfy_len) == 1);
+    CHECK(secp256k1_context_create_from_tables(SECP256K1_CONTEXT_SIGN, tables, vrfy_len) == NULL);
+    loaded = secp256k1_context_create_from_tables(SECP256K1_CONTEXT_VERIFY, tables, vrfy_len);
+    CHECK(loaded != NULL);
+    CHECK(secp256k1_ecdsa_verify(loaded, &sig, msg, &pubkey) == 1);
+    secp256k1_context_destroy(loaded);
+
+    /* Truncated or damaged tables are rejected. */
+    CHECK(secp256k1_context_create_from_tables(SECP256K1_CONTEXT_VERIFY, tables, vrfy_len - 1) == NULL);
+    CHECK(secp256k1_context_create_from_tables(SECP256K1_CONTEXT_VERIFY, tables, 10) == NULL);
+    pos = secp256k1_rand_int(vrfy_len);
+    tables[pos] ^= 1 << secp256k1_rand_int(8);
+    CHECK(secp256k1_context_create_from_tables(SECP256K1_CONTEXT_VERIFY, tables, vrfy_len) == NULL);
+
+    free(tables);
+    secp256k1_context_destroy(vrfy);
+    secp256k1_context_destroy(both);
+}
+
+void run_context_lazy_tests(void) {
+    secp256k1_context *lazy = secp256k1_context_create(SECP256K1_CONTEXT_LAZY | SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+    secp256k1_context *lazy_sign = secp256k1_context_create(SECP256K1_CONTEXT_LAZY | SECP256K1_CONTEXT_SIGN);
+    secp256k1_context *clone;
+    secp256k1_pubkey pubkey;
+    secp256k1_ecdsa_signature sig, sig2;
+    unsigned char seckey[32], msg[32];
+    int32_t ecount = 0;
+
+    do {
+        secp256k1_rand256_test(seckey);
+    } while (!secp256k1_ec_seckey_verify(ctx, seckey));
+    secp256k1_rand256_test(msg);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, seckey) == 1);
+    CHECK(secp256k1_ecdsa_sign(ctx, &sig, msg, seckey, NULL, NULL) == 1);
+
+#ifdef SECP256K1_HAVE_ATOMICS
+    CHECK(!secp256k1_ecmult_context_is_built(&lazy->ecmult_ctx));
+    CHECK(!secp256k1_ecmult_gen_context_is_built(&lazy->ecmult_gen_ctx));
+#endif
+    /* Verifying only builds the verification tables. */
+    CHECK(secp256k1_ecdsa_verify(lazy, &sig, msg, &pubkey) == 1);
+    CHECK(secp256k1_ecmult_context_is_built(&lazy->ecmult_ctx));
+#ifdef SECP256K1_HAVE_ATOMICS
+    CHECK(!secp256k1_ecmult_gen_context_is_built(&lazy->ecmult_gen_ctx));
+#endif
+
+    /* A clone keeps the pending parts pending and builds them on its own. */
+    clone = secp256k1_context_clone(lazy);
+    CHECK(secp256k1_ecmult_context_is_built(&clone->ecmult_ctx));
+#ifdef SECP256K1_HAVE_ATOMICS
+    CHECK(!secp256k1_ecmult_gen_context_is_built(&clone->ecmult_gen_ctx));
+#endif
+    CHECK(secp256k1_ecdsa_sign(clone, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(memcmp(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ecmult_gen_context_is_built(&clone->ecmult_gen_ctx));
+#ifdef SECP256K1_HAVE_ATOMICS
+    CHECK(!secp256k1_ecmult_gen_context_is_built(&lazy->ecmult_gen_ctx));
+#endif
+    secp256k1_context_destroy(clone);
+
+    /* Randomization builds the signing tables. */
+    CHECK(secp256k1_context_randomize(lazy, msg) == 1);
+    CHECK(secp256k1_ecmult_gen_context_is_built(&lazy->ecmult_gen_ctx));
+    CHECK(secp256k1_ecdsa_sign(lazy, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(memcmp(&sig, &sig2, sizeof(sig)) == 0);
+
+    /* Parts that were not requested are never built. */
+    secp256k1_context_set_illegal_callback(lazy_sign, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_verify(lazy_sign, &sig, msg, &pubkey) == 0);
+    CHECK(ecount == 1);
+    CHECK(!secp256k1_ecmult_context_is_built(&lazy_sign->ecmult_ctx));
+    CHECK(secp256k1_ec_pubkey_create(lazy_sign, &pubkey, seckey) == 1);
+    CHECK(ecount == 1);
+
+    secp256k1_context_destroy(lazy_sign);
+    secp256k1_context_destroy(lazy);
+}
+
+void run_signing_session_tests(void) {
+    secp256k1_context *sign = secp256k1_context_clone(ctx);
+    secp256k1_context *vrfy = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    secp256k1_signing_session *session, *session2;
+    secp256k1_pubkey pubkey, pubkey2;
+    secp256k1_ecdsa_signature sig, sig2;
+    unsigned char seckey[32], msg[32], seed[32];
+    int32_t ecount = 0;
+
+    do {
+        secp256k1_rand256_test(seckey);
+    } while (!secp256k1_ec_seckey_verify(ctx, seckey));
+    secp256k1_rand256_test(msg);
+    secp256k1_rand256(seed);
+    CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey, seckey) == 1);
+    CHECK(secp256k1_ecdsa_sign(ctx, &sig, msg, seckey, NULL, NULL) == 1);
+
+    secp256k1_context_set_illegal_callback(vrfy, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_signing_session_create(vrfy, seed) == NULL);
+    CHECK(ecount == 1);
+
+    /* Sessions have their own blinding but produce the same results, even
+     * after the context they were created from is destroyed. */
+    session = secp256k1_signing_session_create(sign, seed);
+    session2 = secp256k1_signing_session_create(sign, NULL);
+    CHECK(session != NULL && session2 != NULL);
+    CHECK(!secp256k1_scalar_eq(&session->ecmult_gen_ctx.blind, &session2->ecmult_gen_ctx.blind));
+    CHECK(secp256k1_scalar_eq(&session2->ecmult_gen_ctx.blind, &sign->ecmult_gen_ctx.blind));
+    secp256k1_context_destroy(sign);
+    CHECK(secp256k1_ecdsa_sign_with_session(vrfy, session, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(memcmp(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ec_pubkey_create_with_session(vrfy, session2, &pubkey2, seckey) == 1);
+    CHECK(memcmp(&pubkey, &pubkey2, sizeof(pubkey)) == 0);
+    CHECK(secp256k1_signing_session_randomize(session, NULL) == 1);
+    CHECK(secp256k1_signing_session_randomize(session2, seed) == 1);
+    CHECK(secp256k1_ecdsa_sign_with_session(vrfy, session2, &sig2, msg, seckey, NULL, NULL) == 1);
+    CHECK(memcmp(&sig, &sig2, sizeof(sig)) == 0);
+    CHECK(secp256k1_ec_pubkey_create_with_session(vrfy, session, &pubkey2, seckey) == 1);
+    CHECK(memcmp(&pubkey, &pubkey2, sizeof(pubkey)) == 0);
+
+    /* Invalid inputs. */
+    memset(seed, 0, sizeof(seed));
+    CHECK(secp256k1_ec_pubkey_create_with_session(vrfy, session, &pubkey2, seed) == 0);
+    CHECK(secp256k1_ecdsa_sign_with_session(vrfy, session, &sig2, msg, seed, NULL, NULL) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_sign_with_session(vrfy, NULL, &sig2, msg, seckey, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ec_pubkey_create_with_session(vrfy, NULL, &pubkey2, seckey) == 0);
+    CHECK(ecount == 3);
+
+    secp256k1_signing_session_destroy(session);
+    secp256k1_signing_session_destroy(session2);
+    secp256k1_signing_session_destroy(NULL);
+    secp256k1_context_destroy(vrfy);
+}
+
 void run_scratch_tests(void) {
     int32_t ecount = 0;
     secp256k1_context *none = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
@@ -983,6 +1187,30 @@ void run_scalar_tests(void) {
         CHECK(secp256k1_scalar_is_zero(&o));
     }
 
+    {
+        /* Batch inversion should agree with inverting one scalar at a time. */
+        secp256k1_scalar x[16], xi[16], t;
+        size_t j, len;
+        secp256k1_scalar_inverse_all_var(xi, x, 0);
+        secp256k1_scalar_inverse_all(xi, x, 0);
+        for (i = 0; i < count; i++) {
+            len = secp256k1_rand_int(15) + 1;
+            for (j = 0; j < len; j++) {
+                random_scalar_order(&x[j]);
+            }
+            secp256k1_scalar_inverse_all_var(xi, x, len);
+            for (j = 0; j < len; j++) {
+                secp256k1_scalar_inverse_var(&t, &x[j]);
+                CHECK(secp256k1_scalar_eq(&t, &xi[j]));
+            }
+            secp256k1_scalar_inverse_all(xi, x, len);
+            for (j = 0; j < len; j++) {
+                secp256k1_scalar_inverse(&t, &x[j]);
+                CHECK(secp256k1_scalar_eq(&t, &xi[j]));
+            }
+        }
+    }
+
 #ifndef USE_NUM_NONE
     {
         /* A scalar with value of the curve order should be 0. */
@@ -1020,9 +1248,7 @@ void run_scalar_tests(void) {
         secp256k1_scalar one;
         secp256k1_scalar r1;
         secp256k1_scalar r2;
-#if defined(USE_SCALAR_INV_NUM)
         secp256k1_scalar zzv;
-#endif
         int overflow;
         unsigned char chal[33][2][32] = {
             {{0xff, 0xff, 0x03, 0x07, 0x00, 0x00, 0x00, 0x00,
@@ -1572,10 +1798,8 @@ void run_scalar_tests(void) {
             if (!secp256k1_scalar_is_zero(&y)) {
                 secp256k1_scalar_inverse(&zz, &y);
                 CHECK(!secp256k1_scalar_check_overflow(&zz));
-#if defined(USE_SCALAR_INV_NUM)
                 secp256k1_scalar_inverse_var(&zzv, &y);
                 CHECK(secp256k1_scalar_eq(&zzv, &zz));
-#endif
                 secp256k1_scalar_mul(&z, &z, &zz);
                 CHECK(!secp256k1_scalar_check_overflow(&z));
                 CHECK(secp256k1_scalar_eq(&x, &z));
@@ -1762,6 +1986,62 @@ void run_field_misc(void) {
     }
 }
 
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+void test_field_inner_5x52(const uint64_t *a, const uint64_t *b) {
+    uint64_t r1[5], r2[5];
+    secp256k1_fe_mul_inner_mulq(r1, a, b);
+    secp256k1_fe_sqr_inner_mulq(r2, a);
+#ifdef HAVE___INT128
+    {
+        uint64_t t[5];
+        secp256k1_fe_mul_inner_int128(t, a, b);
+        CHECK(memcmp(t, r1, sizeof(t)) == 0);
+        secp256k1_fe_sqr_inner_int128(t, a);
+        CHECK(memcmp(t, r2, sizeof(t)) == 0);
+    }
+#endif
+    if (secp256k1_cpu_features() & SECP256K1_CPU_BMI2_ADX) {
+        uint64_t t[5];
+        secp256k1_fe_mul_inner_mulx(t, a, b);
+        CHECK(memcmp(t, r1, sizeof(t)) == 0);
+        secp256k1_fe_sqr_inner_mulx(t, a);
+        CHECK(memcmp(t, r2, sizeof(t)) == 0);
+        /* The output may overwrite the input. */
+        memcpy(t, a, sizeof(t));
+        secp256k1_fe_mul_inner_mulx(t, t, b);
+        CHECK(memcmp(t, r1, sizeof(t)) == 0);
+        memcpy(t, a, sizeof(t));
+        secp256k1_fe_sqr_inner_mulx(t, t);
+        CHECK(memcmp(t, r2, sizeof(t)) == 0);
+    }
+}
+
+/* Compare the MULQ, MULX and (when available) int128 versions of the inner
+ * multiplication on inputs up to the largest allowed magnitude, 8. */
+void run_field_inner_5x52(void) {
+    uint64_t a[5], b[5];
+    int i, j;
+    for (j = 0; j < 4; j++) {
+        a[j] = 0xFFFFFFFFFFFFFULL * 16;
+        b[j] = 0xFFFFFFFFFFFFFULL * 16;
+    }
+    a[4] = b[4] = 0x0FFFFFFFFFFFFULL * 16;
+    test_field_inner_5x52(a, b);
+    for (i = 0; i < 100 * count; i++) {
+        for (j = 0; j < 5; j++) {
+            a[j] = (((uint64_t)secp256k1_rand32() << 32) | secp256k1_rand32()) >> (j == 4 ? 12 : 8);
+            b[j] = (((uint64_t)secp256k1_rand32() << 32) | secp256k1_rand32()) >> (j == 4 ? 12 : 8);
+        }
+        if (i & 1) {
+            /* Random limbs rarely come close to the bounds on their own. */
+            a[secp256k1_rand_int(5)] = 0;
+            b[secp256k1_rand_int(4)] = 0xFFFFFFFFFFFFFULL * 16;
+        }
+        test_field_inner_5x52(a, b);
+    }
+}
+#endif
+
 void run_field_inv(void) {
     secp256k1_fe x, xi, xii;
     int i;
@@ -1808,6 +2088,89 @@ void run_field_inv_all_var(void) {
     }
 }
 
+void test_inverse_scalar(const secp256k1_scalar *x) {
+    secp256k1_scalar l, r, t;
+
+    secp256k1_scalar_inverse(&l, x);
+    secp256k1_scalar_inverse_var(&r, x);
+    CHECK(secp256k1_scalar_eq(&l, &r));
+    CHECK(!secp256k1_scalar_check_overflow(&l));
+    if (secp256k1_scalar_is_zero(x)) {
+        CHECK(secp256k1_scalar_is_zero(&l));
+        return;
+    }
+    secp256k1_scalar_mul(&t, x, &l);
+    CHECK(secp256k1_scalar_is_one(&t));
+    secp256k1_scalar_inverse(&t, &l);
+    CHECK(secp256k1_scalar_eq(&t, x));
+}
+
+void test_inverse_field(const secp256k1_fe *x) {
+    secp256k1_fe l, r, t = *x;
+
+    secp256k1_fe_inv(&l, x);
+    secp256k1_fe_inv_var(&r, x);
+    CHECK(check_fe_equal(&l, &r));
+    if (secp256k1_fe_normalizes_to_zero_var(&t)) {
+        CHECK(secp256k1_fe_normalizes_to_zero_var(&l));
+        return;
+    }
+    CHECK(check_fe_inverse(x, &l));
+    secp256k1_fe_inv_var(&t, &l);
+    CHECK(check_fe_equal(&t, x));
+}
+
+void run_inverse_tests(void) {
+    /* Values whose signed-digit forms exercise the carry and sign handling
+     * at limb boundaries: 0, 1, 2, -1 and -2, and powers of two near them. */
+    static const secp256k1_fe fe_cases[] = {
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 0),
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 2),
+        SECP256K1_FE_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                           0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL, 0xFFFFFC2EUL),
+        SECP256K1_FE_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                           0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL, 0xFFFFFC2DUL),
+        SECP256K1_FE_CONST(0x80000000UL, 0, 0, 0, 0, 0, 0, 0),
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 1, 0),
+        SECP256K1_FE_CONST(0x7FFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                           0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0x7FFFFE18UL)
+    };
+    static const secp256k1_scalar scalar_cases[] = {
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 0),
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 0, 2),
+        SECP256K1_SCALAR_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL,
+                               0xBAAEDCE6UL, 0xAF48A03BUL, 0xBFD25E8CUL, 0xD0364140UL),
+        SECP256K1_SCALAR_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL,
+                               0xBAAEDCE6UL, 0xAF48A03BUL, 0xBFD25E8CUL, 0xD036413FUL),
+        SECP256K1_SCALAR_CONST(0x80000000UL, 0, 0, 0, 0, 0, 0, 0),
+        SECP256K1_SCALAR_CONST(0, 0, 0, 0, 0, 0, 1, 0),
+        SECP256K1_SCALAR_CONST(0x7FFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                               0x5D576E73UL, 0x57A4501DUL, 0xDFE92F46UL, 0x681B20A0UL)
+    };
+    size_t i;
+    int j;
+
+    for (i = 0; i < sizeof(fe_cases) / sizeof(fe_cases[0]); i++) {
+        test_inverse_field(&fe_cases[i]);
+    }
+    for (i = 0; i < sizeof(scalar_cases) / sizeof(scalar_cases[0]); i++) {
+        test_inverse_scalar(&scalar_cases[i]);
+    }
+    for (j = 0; j < 100 * count; j++) {
+        secp256k1_fe fe;
+        secp256k1_scalar s;
+        /* Inputs with runs of set and cleared bits, and non-normalized ones. */
+        random_fe_test(&fe);
+        test_inverse_field(&fe);
+        secp256k1_fe_mul_int(&fe, 3);
+        test_inverse_field(&fe);
+        random_scalar_order_test(&s);
+        test_inverse_scalar(&s);
+    }
+}
+
 void run_sqr(void) {
     secp256k1_fe x, s;
 
@@ -2113,6 +2476,11 @@ void test_ge(void) {
             secp256k1_gej_rescale(&gej[i], &s);
             ge_equals_gej(&ge_set_all[i], &gej[i]);
         }
+        /* The constant-time version does not support infinity, which is only gej[0]. */
+        secp256k1_ge_set_all_gej(ge_set_all + 1, gej + 1, 4 * runs);
+        for (i = 1; i < 4 * runs + 1; i++) {
+            ge_equals_gej(&ge_set_all[i], &gej[i]);
+        }
         free(ge_set_all);
         free(zr);
     }
@@ -2320,6 +2688,206 @@ void run_group_decompress(void) {
 
 /***** ECMULT TESTS *****/
 
+#ifdef SECP256K1_FIELD_X4
+void check_fe_x4_equal(const secp256k1_fe_x4 *a, const secp256k1_fe *b) {
+    secp256k1_fe t[4];
+    int k;
+    secp256k1_fe_x4_get_fe(t, a);
+    for (k = 0; k < 4; k++) {
+        CHECK(check_fe_equal(&t[k], &b[k]));
+    }
+}
+
+SECP256K1_TARGET_AVX2 void test_field_x4(const secp256k1_fe *a_in, const secp256k1_fe *b_in) {
+    secp256k1_fe a[4], b[4], r[4];
+    secp256k1_fe_x4 ax, bx, rx;
+    __m256i mask;
+    int64_t lanes[4];
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        a[k] = a_in[k];
+        b[k] = b_in[k];
+    }
+    secp256k1_fe_x4_set_fe(&ax, a);
+    secp256k1_fe_x4_set_fe(&bx, b);
+    check_fe_x4_equal(&ax, a);
+
+    /* Bring both inputs to magnitude 8, the largest that mul and sqr accept;
+     * negating with m = 7 makes every limb close to its bound. */
+    secp256k1_fe_x4_negate(&ax, &ax, 1);
+    secp256k1_fe_x4_mul_int(&ax, 4);
+    secp256k1_fe_x4_negate(&bx, &bx, 7);
+    for (k = 0; k < 4; k++) {
+        secp256k1_fe_negate(&a[k], &a[k], 1);
+        secp256k1_fe_mul_int(&a[k], 4);
+        secp256k1_fe_negate(&b[k], &b[k], 7);
+    }
+    check_fe_x4_equal(&ax, a);
+    check_fe_x4_equal(&bx, b);
+
+    secp256k1_fe_x4_mul(&rx, &ax, &bx);
+    for (k = 0; k < 4; k++) {
+        secp256k1_fe_mul(&r[k], &a[k], &b[k]);
+    }
+    check_fe_x4_equal(&rx, r);
+
+    secp256k1_fe_x4_sqr(&rx, &bx);
+    for (k = 0; k < 4; k++) {
+        secp256k1_fe_sqr(&r[k], &b[k]);
+    }
+    check_fe_x4_equal(&rx, r);
+
+    rx = ax;
+    secp256k1_fe_x4_add(&rx, &bx);
+    secp256k1_fe_x4_normalize_weak(&rx);
+    for (k = 0; k < 4; k++) {
+        r[k] = a[k];
+        secp256k1_fe_add(&r[k], &b[k]);
+    }
+    check_fe_x4_equal(&rx, r);
+
+    secp256k1_fe_x4_normalizes_to_zero(&mask, &ax);
+    _mm256_storeu_si256((__m256i *)lanes, mask);
+    for (k = 0; k < 4; k++) {
+        CHECK(lanes[k] == -(int64_t)secp256k1_fe_normalizes_to_zero(&a[k]));
+    }
+    /* a - a has raw values that are multiples of p, and normalizes to zero. */
+    secp256k1_fe_x4_negate(&rx, &ax, 8);
+    secp256k1_fe_x4_add(&rx, &ax);
+    secp256k1_fe_x4_normalizes_to_zero(&mask, &rx);
+    _mm256_storeu_si256((__m256i *)lanes, mask);
+    for (k = 0; k < 4; k++) {
+        CHECK(lanes[k] == -1);
+    }
+
+    mask = _mm256_set_epi64x(0, -1, -1, 0);
+    rx = ax;
+    secp256k1_fe_x4_cmov(&rx, &bx, &mask);
+    r[0] = a[0];
+    r[1] = b[1];
+    r[2] = b[2];
+    r[3] = a[3];
+    check_fe_x4_equal(&rx, r);
+}
+
+void run_field_x4_tests(void) {
+    static const secp256k1_fe edge[4] = {
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 0),
+        SECP256K1_FE_CONST(0, 0, 0, 0, 0, 0, 0, 1),
+        SECP256K1_FE_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                           0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFEUL, 0xFFFFFC2EUL),
+        SECP256K1_FE_CONST(0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL, 0xFFFFFFFFUL,
+                           0, 0, 0, 0)
+    };
+    secp256k1_fe a[4], b[4];
+    int i, k;
+    if (!(secp256k1_cpu_features() & SECP256K1_CPU_AVX2)) {
+        return;
+    }
+    test_field_x4(edge, edge);
+    for (i = 0; i < 10 * count; i++) {
+        for (k = 0; k < 4; k++) {
+            random_fe_test(&a[k]);
+            random_fe_test(&b[k]);
+        }
+        a[i & 3] = edge[(i >> 2) & 3];
+        test_field_x4(a, b);
+    }
+}
+
+void test_group_x4(const secp256k1_gej *a, const secp256k1_ge *b) {
+    secp256k1_ge_storage bs[4];
+    secp256k1_gej_x4 ax, rx;
+    secp256k1_ge_x4 bx;
+    secp256k1_gej r[4], e[4];
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        secp256k1_ge_to_storage(&bs[k], &b[k]);
+    }
+    secp256k1_ge_x4_from_storage(&bx, bs);
+    secp256k1_gej_x4_set_gej(&ax, a);
+
+    /* Add b a few times, so that outputs are fed back as inputs. */
+    rx = ax;
+    for (k = 0; k < 4; k++) {
+        e[k] = a[k];
+    }
+    for (k = 0; k < 3; k++) {
+        int l;
+        secp256k1_gej_x4_add_ge(&rx, &rx, &bx);
+        for (l = 0; l < 4; l++) {
+            secp256k1_gej_add_ge(&e[l], &e[l], &b[l]);
+        }
+        secp256k1_gej_x4_get_gej(r, &rx);
+        for (l = 0; l < 4; l++) {
+            CHECK(gej_xyz_equals_gej(&r[l], &e[l]));
+        }
+    }
+
+    secp256k1_gej_x4_double(&rx, &ax);
+    secp256k1_gej_x4_double(&rx, &rx);
+    secp256k1_gej_x4_get_gej(r, &rx);
+    for (k = 0; k < 4; k++) {
+        secp256k1_gej_double_var(&e[k], &a[k], NULL);
+        secp256k1_gej_double_var(&e[k], &e[k], NULL);
+        CHECK(gej_xyz_equals_gej(&r[k], &e[k]));
+    }
+}
+
+void run_group_x4_tests(void) {
+    static const secp256k1_fe beta = SECP256K1_FE_CONST(
+        0x7ae96a2bUL, 0x657c0710UL, 0x6e64479eUL, 0xac3434e9UL,
+        0x9cf04975UL, 0x12f58995UL, 0xc1396c28UL, 0x719501eeUL
+    );
+    secp256k1_gej a[4];
+    secp256k1_ge b[4];
+    int i, k;
+    if (!(secp256k1_cpu_features() & SECP256K1_CPU_AVX2)) {
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        secp256k1_ge t;
+        for (k = 0; k < 4; k++) {
+            random_group_element_test(&b[k]);
+            random_group_element_test(&t);
+            random_group_element_jacobian_test(&a[k], &t);
+        }
+        test_group_x4(a, b);
+
+        /* The cases secp256k1_gej_add_ge treats specially, one per lane: a is
+         * infinity, a == b, a == -b, and a == -(beta * b.x, b.y), where y1 == -y2
+         * with x1 != x2. */
+        secp256k1_gej_set_infinity(&a[0]);
+        random_group_element_jacobian_test(&a[1], &b[1]);
+        secp256k1_ge_neg(&t, &b[2]);
+        random_group_element_jacobian_test(&a[2], &t);
+        secp256k1_fe_mul(&t.x, &b[3].x, &beta);
+        secp256k1_fe_negate(&t.y, &b[3].y, 1);
+        t.infinity = 0;
+        random_group_element_jacobian_test(&a[3], &t);
+        test_group_x4(a, b);
+    }
+}
+
+#endif
+
+void run_ecmult_gen_batch_tests(void) {
+    secp256k1_scalar s[7];
+    secp256k1_gej r[7], e;
+    size_t n, i;
+    for (n = 0; n <= 7; n++) {
+        for (i = 0; i < 7; i++) {
+            random_scalar_order_test(&s[i]);
+        }
+        secp256k1_ecmult_gen_batch(&ctx->ecmult_gen_ctx, r, s, n);
+        for (i = 0; i < n; i++) {
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &e, &s[i]);
+            CHECK(gej_xyz_equals_gej(&r[i], &e));
+        }
+    }
+}
 void run_ecmult_chain(void) {
     /* random starting point A (on the curve) */
     secp256k1_gej a = SECP256K1_GEJ_CONST(
@@ -2564,6 +3132,50 @@ static int ecmult_multi_false_callback(secp256k1_scalar *sc, secp256k1_ge *pt, s
     return 0;
 }
 
+/* Runs the tasks one after another in reverse order, so that results which
+ * depend on the order the tasks are run in show up as failures. */
+static int ecmult_multi_parallel_reverse(secp256k1_ecmult_parallel_task *task, void *task_data, size_t n_tasks, void *data) {
+    if (data != NULL) {
+        /* Count the calls */
+        (*(size_t *) data)++;
+    }
+    while (n_tasks > 0) {
+        n_tasks--;
+        task(task_data, n_tasks);
+    }
+    return 1;
+}
+
+static int ecmult_multi_parallel_false(secp256k1_ecmult_parallel_task *task, void *task_data, size_t n_tasks, void *data) {
+    (void)task;
+    (void)task_data;
+    (void)n_tasks;
+    (void)data;
+    return 0;
+}
+
+static size_t ecmult_multi_n_threads;
+
+/* Wrapper for secp256k1_ecmult_multi_func interface running pippenger with
+ * ecmult_multi_n_threads tasks */
+static int ecmult_multi_pippenger_batch_parallel(const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    secp256k1_ecmult_parallel par;
+    par.fn = ecmult_multi_parallel_reverse;
+    par.data = NULL;
+    par.n_threads = ecmult_multi_n_threads;
+    return secp256k1_ecmult_pippenger_batch(actx, scratch, r, inp_g_sc, cb, cbdata, n, 0, &par);
+}
+
+/* Wrapper for secp256k1_ecmult_multi_func interface running the streaming
+ * algorithm with ecmult_multi_n_threads tasks */
+static int ecmult_multi_stream(const secp256k1_ecmult_context *actx, secp256k1_scratch *scratch, secp256k1_gej *r, const secp256k1_scalar *inp_g_sc, secp256k1_ecmult_multi_callback cb, void *cbdata, size_t n) {
+    secp256k1_ecmult_parallel par;
+    par.fn = ecmult_multi_parallel_reverse;
+    par.data = NULL;
+    par.n_threads = ecmult_multi_n_threads;
+    return secp256k1_ecmult_multi_stream_var(actx, scratch, r, inp_g_sc, cb, cbdata, n, &par);
+}
+
 void test_ecmult_multi(secp256k1_scratch *scratch, secp256k1_ecmult_multi_func ecmult_multi) {
     int ncount;
     secp256k1_scalar szero;
@@ -2814,12 +3426,14 @@ void test_secp256k1_pippenger_bucket_window_inv(void) {
 
     CHECK(secp256k1_pippenger_bucket_window_inv(0) == 0);
     for(i = 1; i <= PIPPENGER_MAX_BUCKET_WINDOW; i++) {
-#ifdef USE_ENDOMORPHISM
-        /* Bucket_window of 8 is not used with endo */
-        if (i == 8) {
-            continue;
+        if (i > 1) {
+            CHECK(secp256k1_pippenger_bucket_window_inv(i) >= secp256k1_pippenger_bucket_window_inv(i - 1));
+            /* A bucket_window that is never optimal (such as 8 with endo)
+             * has the same limit as the previous one */
+            if (secp256k1_pippenger_bucket_window_inv(i) == secp256k1_pippenger_bucket_window_inv(i - 1)) {
+                continue;
+            }
         }
-#endif
         CHECK(secp256k1_pippenger_bucket_window(secp256k1_pippenger_bucket_window_inv(i)) == i);
         if (i != PIPPENGER_MAX_BUCKET_WINDOW) {
             CHECK(secp256k1_pippenger_bucket_window(secp256k1_pippenger_bucket_window_inv(i)+1) > i);
@@ -2827,13 +3441,106 @@ void test_secp256k1_pippenger_bucket_window_inv(void) {
     }
 }
 
+/* Test adding up buckets in affine coordinates with repeated and negated points */
+void test_ecmult_pippenger_affine_reduce(void) {
+    secp256k1_ge pool[4];
+    secp256k1_ge points[32];
+    secp256k1_fe fe[3 * 16];
+    size_t offset[4];
+    size_t n_in_bucket[4];
+    secp256k1_gej expected[4];
+    struct secp256k1_pippenger_buckets buckets;
+    size_t n = 0;
+    size_t j, k;
+
+    random_group_element_test(&pool[0]);
+    secp256k1_ge_neg(&pool[1], &pool[0]);
+    random_group_element_test(&pool[2]);
+    pool[3] = pool[2];
+    for (j = 0; j < 4; j++) {
+        offset[j] = n;
+        n_in_bucket[j] = secp256k1_rand_int(9);
+        secp256k1_gej_set_infinity(&expected[j]);
+        for (k = 0; k < n_in_bucket[j]; k++) {
+            points[n] = pool[secp256k1_rand_int(4)];
+            secp256k1_gej_add_ge_var(&expected[j], &expected[j], &points[n], NULL);
+            n++;
+        }
+    }
+    buckets.points = points;
+    buckets.fe = fe;
+    buckets.offset = offset;
+    buckets.count = n_in_bucket;
+    secp256k1_ecmult_pippenger_affine_reduce(&buckets, 4, n);
+    for (j = 0; j < 4; j++) {
+        CHECK(n_in_bucket[j] <= 1);
+        if (n_in_bucket[j] == 1) {
+            ge_equals_gej(&points[offset[j]], &expected[j]);
+        } else {
+            CHECK(secp256k1_gej_is_infinity(&expected[j]));
+        }
+    }
+}
+
+/* Run pippenger with enough points to use affine buckets, where many points
+ * are equal or negations of each other. */
+void test_ecmult_multi_pippenger_affine(void) {
+    size_t n_points = secp256k1_pippenger_bucket_window_inv(PIPPENGER_AFFINE_MIN_BUCKET_WINDOW - 1) + 1 + secp256k1_rand_int(64);
+    secp256k1_scalar *sc = (secp256k1_scalar *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_scalar) * n_points);
+    secp256k1_ge *pt = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * n_points);
+    secp256k1_scratch *scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_pippenger_scratch_size_max_points(n_points, 3));
+    secp256k1_ecmult_parallel par;
+    secp256k1_scalar scG;
+    secp256k1_gej r, r2;
+    ecmult_multi_data data;
+    size_t i;
+
+    CHECK(secp256k1_pippenger_affine_buckets(secp256k1_pippenger_bucket_window(n_points)));
+    random_scalar_order(&scG);
+    for (i = 0; i < n_points; i++) {
+        if (i < 4 || secp256k1_rand_int(4) == 0) {
+            random_group_element_test(&pt[i]);
+        } else if (secp256k1_rand_int(2)) {
+            pt[i] = pt[secp256k1_rand_int(4)];
+        } else {
+            secp256k1_ge_neg(&pt[i], &pt[secp256k1_rand_int(4)]);
+        }
+        /* Small scalars make equal points land in the same buckets */
+        if (secp256k1_rand_int(2)) {
+            secp256k1_scalar_set_int(&sc[i], secp256k1_rand_int(8));
+        } else {
+            random_scalar_order(&sc[i]);
+        }
+    }
+    data.sc = sc;
+    data.pt = pt;
+    par.fn = ecmult_multi_parallel_reverse;
+    par.data = NULL;
+    par.n_threads = 3;
+
+    CHECK(secp256k1_ecmult_multi_simple_var(&ctx->ecmult_ctx, &r2, &scG, ecmult_multi_callback, &data, n_points));
+    secp256k1_gej_neg(&r2, &r2);
+    CHECK(secp256k1_ecmult_pippenger_batch(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points, 0, NULL));
+    secp256k1_gej_add_var(&r, &r, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+    CHECK(secp256k1_ecmult_pippenger_batch(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points, 0, &par));
+    secp256k1_gej_add_var(&r, &r, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+
+    secp256k1_scratch_destroy(scratch);
+    free(sc);
+    free(pt);
+}
+
 /**
  * Probabilistically test the function returning the maximum number of possible points
  * for a given scratch space.
  */
 void test_ecmult_multi_pippenger_max_points(void) {
     size_t scratch_size = secp256k1_rand_int(256);
-    size_t max_size = secp256k1_pippenger_scratch_size(secp256k1_pippenger_bucket_window_inv(PIPPENGER_MAX_BUCKET_WINDOW-1)+512, 12);
+    size_t n_threads = 1 + secp256k1_rand_int(4);
+    /* One step more than needed for the largest bucket window, so that the last scratch space tried supports it */
+    size_t max_size = secp256k1_pippenger_scratch_size_max_points(secp256k1_pippenger_bucket_window_inv(PIPPENGER_MAX_BUCKET_WINDOW-1)+1, n_threads) + 256;
     secp256k1_scratch *scratch;
     size_t n_points_supported;
     int bucket_window = 0;
@@ -2841,15 +3548,20 @@ void test_ecmult_multi_pippenger_max_points(void) {
     for(; scratch_size < max_size; scratch_size+=256) {
         scratch = secp256k1_scratch_create(&ctx->error_callback, scratch_size);
         CHECK(scratch != NULL);
-        n_points_supported = secp256k1_pippenger_max_points(scratch);
+        n_points_supported = secp256k1_pippenger_max_points(scratch, n_threads);
         if (n_points_supported == 0) {
             secp256k1_scratch_destroy(scratch);
             continue;
         }
         bucket_window = secp256k1_pippenger_bucket_window(n_points_supported);
-        CHECK(secp256k1_scratch_allocate_frame(scratch, secp256k1_pippenger_scratch_size(n_points_supported, bucket_window), PIPPENGER_SCRATCH_OBJECTS));
+        CHECK(secp256k1_scratch_allocate_frame(scratch, secp256k1_pippenger_scratch_size(n_points_supported, bucket_window) + secp256k1_pippenger_parallel_scratch_size(n_points_supported, bucket_window, n_threads), PIPPENGER_SCRATCH_OBJECTS));
         secp256k1_scratch_deallocate_frame(scratch);
         secp256k1_scratch_destroy(scratch);
+        /* The smallest scratch space supporting as many points is no larger */
+        CHECK(secp256k1_pippenger_scratch_size_max_points(n_points_supported, n_threads) <= scratch_size);
+        scratch = secp256k1_scratch_create(&ctx->error_callback, secp256k1_pippenger_scratch_size_max_points(n_points_supported, n_threads));
+        CHECK(secp256k1_pippenger_max_points(scratch, n_threads) >= n_points_supported);
+        secp256k1_scratch_destroy(scratch);
     }
     CHECK(bucket_window == PIPPENGER_MAX_BUCKET_WINDOW);
 }
@@ -2911,9 +3623,13 @@ void test_ecmult_multi_batching(void) {
     secp256k1_gej r;
     secp256k1_gej r2;
     ecmult_multi_data data;
+    secp256k1_ecmult_parallel par;
+    size_t n_calls = 0;
     int i;
     secp256k1_scratch *scratch;
 
+    par.fn = ecmult_multi_parallel_reverse;
+    par.data = NULL;
     secp256k1_gej_set_infinity(&r2);
     secp256k1_scalar_set_int(&szero, 0);
 
@@ -2957,22 +3673,158 @@ void test_ecmult_multi_batching(void) {
         CHECK(secp256k1_ecmult_multi_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points));
         secp256k1_gej_add_var(&r, &r, &r2, NULL);
         CHECK(secp256k1_gej_is_infinity(&r));
+        /* The space for the extra buckets is taken from the batch size */
+        par.n_threads = 1 + secp256k1_rand_int(8);
+        CHECK(secp256k1_ecmult_multi_parallel_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points, &par));
+        secp256k1_gej_add_var(&r, &r, &r2, NULL);
+        CHECK(secp256k1_gej_is_infinity(&r));
         secp256k1_scratch_destroy(scratch);
     }
+
+    /* Failures of concurrently running batches are reported */
+    scratch = secp256k1_scratch_create(&ctx->error_callback, 4 * (secp256k1_strauss_scratch_size(1) + STRAUSS_SCRATCH_OBJECTS*ALIGNMENT + ECMULT_MULTI_TASK_SIZE + ALIGNMENT));
+    par.n_threads = 4;
+    par.data = &n_calls;
+    CHECK(secp256k1_ecmult_multi_parallel_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points, &par));
+    CHECK(n_calls == 1);
+    secp256k1_gej_add_var(&r, &r, &r2, NULL);
+    CHECK(secp256k1_gej_is_infinity(&r));
+    CHECK(!secp256k1_ecmult_multi_parallel_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_false_callback, &data, n_points, &par));
+    par.fn = ecmult_multi_parallel_false;
+    CHECK(!secp256k1_ecmult_multi_parallel_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_callback, &data, n_points, &par));
+    secp256k1_scratch_destroy(scratch);
+
     free(sc);
     free(pt);
 }
 
+typedef struct {
+    secp256k1_scalar *sc;
+    secp256k1_ge *pt;
+    size_t next_idx;
+} ecmult_multi_stream_data;
+
+/* Checks that the points are requested in order. */
+static int ecmult_multi_stream_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *cbdata) {
+    ecmult_multi_stream_data *data = (ecmult_multi_stream_data*) cbdata;
+    CHECK(idx == data->next_idx);
+    data->next_idx++;
+    *sc = data->sc[idx];
+    *pt = data->pt[idx];
+    return 1;
+}
+
+/* Run the streaming algorithm with a scratch space that forces it to fetch
+ * the points in many chunks. */
+void test_ecmult_multi_stream(void) {
+    size_t n_points = 2*ECMULT_PIPPENGER_THRESHOLD + secp256k1_rand_int(64);
+    secp256k1_scalar *sc = (secp256k1_scalar *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_scalar) * n_points);
+    secp256k1_ge *pt = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * n_points);
+    /* Buckets for a small window (in Jacobian coordinates) or the smallest
+     * one with affine buckets, and room for only a fraction of the points */
+    int windows[2];
+    secp256k1_scratch *scratch;
+    secp256k1_ecmult_parallel par;
+    secp256k1_scalar scG;
+    secp256k1_gej r, r2;
+    ecmult_multi_stream_data data;
+    size_t i;
+    int w;
+
+    windows[0] = 2;
+    windows[1] = PIPPENGER_AFFINE_MIN_BUCKET_WINDOW;
+    random_scalar_order(&scG);
+    for (i = 0; i < n_points; i++) {
+        random_group_element_test(&pt[i]);
+        random_scalar_order(&sc[i]);
+    }
+    /* Zero scalars and points at infinity are skipped */
+    secp256k1_scalar_set_int(&sc[0], 0);
+    secp256k1_ge_set_infinity(&pt[1]);
+    data.sc = sc;
+    data.pt = pt;
+    par.fn = ecmult_multi_parallel_reverse;
+    par.data = NULL;
+
+    data.next_idx = 0;
+    CHECK(secp256k1_ecmult_multi_simple_var(&ctx->ecmult_ctx, &r2, &scG, ecmult_multi_stream_callback, &data, n_points));
+    secp256k1_gej_neg(&r2, &r2);
+
+    for (w = 0; w < 2; w++) {
+        scratch = secp256k1_scratch_create(&ctx->error_callback, 2 * secp256k1_ecmult_stream_buckets_scratch_size(windows[w], 3) + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT);
+        for (i = 1; i <= 3; i++) {
+            par.n_threads = i;
+            data.next_idx = 0;
+            CHECK(secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_stream_callback, &data, n_points, &par));
+            CHECK(data.next_idx == n_points);
+            secp256k1_gej_add_var(&r, &r, &r2, NULL);
+            CHECK(secp256k1_gej_is_infinity(&r));
+        }
+        secp256k1_scratch_destroy(scratch);
+    }
+
+    scratch = secp256k1_scratch_create(&ctx->error_callback, 2 * secp256k1_ecmult_stream_buckets_scratch_size(2, 3) + PIPPENGER_SCRATCH_OBJECTS*ALIGNMENT);
+    CHECK(!secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_false_callback, &data, n_points, &par));
+    CHECK(!secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_false_callback, &data, n_points, NULL));
+    par.fn = ecmult_multi_parallel_false;
+    CHECK(!secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_stream_callback, &data, n_points, &par));
+    secp256k1_scratch_destroy(scratch);
+
+    /* Not enough space for the buckets of a window of 1 */
+    scratch = secp256k1_scratch_create(&ctx->error_callback, 2 * secp256k1_ecmult_stream_buckets_scratch_size(1, 1) - 1);
+    CHECK(!secp256k1_ecmult_multi_stream_var(&ctx->ecmult_ctx, scratch, &r, &scG, ecmult_multi_stream_callback, &data, n_points, NULL));
+    secp256k1_scratch_destroy(scratch);
+
+    free(sc);
+    free(pt);
+}
+
+void test_ecmult_multi_parallel_fail(secp256k1_scratch *scratch) {
+    secp256k1_scalar sc[1];
+    secp256k1_ge pt[1];
+    secp256k1_gej r;
+    ecmult_multi_data data;
+    secp256k1_ecmult_parallel par;
+
+    random_scalar_order(&sc[0]);
+    random_group_element_test(&pt[0]);
+    data.sc = sc;
+    data.pt = pt;
+    par.fn = ecmult_multi_parallel_false;
+    par.data = NULL;
+    par.n_threads = 2;
+    CHECK(!secp256k1_ecmult_pippenger_batch(&ctx->ecmult_ctx, scratch, &r, NULL, ecmult_multi_callback, &data, 1, 0, &par));
+    /* With a single thread the callback is not used */
+    par.n_threads = 1;
+    CHECK(secp256k1_ecmult_pippenger_batch(&ctx->ecmult_ctx, scratch, &r, NULL, ecmult_multi_callback, &data, 1, 0, &par));
+}
+
 void run_ecmult_multi_tests(void) {
     secp256k1_scratch *scratch;
+    int i;
 
     test_secp256k1_pippenger_bucket_window_inv();
     test_ecmult_multi_pippenger_max_points();
+    for (i = 0; i < count; i++) {
+        test_ecmult_pippenger_affine_reduce();
+    }
+    test_ecmult_multi_pippenger_affine();
+    test_ecmult_multi_stream();
     scratch = secp256k1_scratch_create(&ctx->error_callback, 819200);
     test_ecmult_multi(scratch, secp256k1_ecmult_multi_var);
     test_ecmult_multi(NULL, secp256k1_ecmult_multi_var);
     test_ecmult_multi(scratch, secp256k1_ecmult_pippenger_batch_single);
     test_ecmult_multi(scratch, secp256k1_ecmult_strauss_batch_single);
+    /* With more tasks than windows the points are split as well */
+    ecmult_multi_n_threads = 3;
+    test_ecmult_multi(scratch, ecmult_multi_pippenger_batch_parallel);
+    ecmult_multi_n_threads = 70;
+    test_ecmult_multi(scratch, ecmult_multi_pippenger_batch_parallel);
+    ecmult_multi_n_threads = 1;
+    test_ecmult_multi(scratch, ecmult_multi_stream);
+    ecmult_multi_n_threads = 3;
+    test_ecmult_multi(scratch, ecmult_multi_stream);
+    test_ecmult_multi_parallel_fail(scratch);
     secp256k1_scratch_destroy(scratch);
 
     /* Run test_ecmult_multi with space for exactly one point */
@@ -3285,6 +4137,110 @@ void run_ecmult_gen_blind(void) {
     }
 }
 
+/***** DISPATCH TESTS *****/
+
+void run_dispatch_tests(void) {
+    secp256k1_dispatch d;
+    unsigned int features = secp256k1_cpu_features();
+    unsigned int subset;
+    int i;
+
+    /* Without any features, the selection is what the table starts out with. */
+    secp256k1_dispatch_select(&d, 0);
+    CHECK(d.features == 0);
+#ifdef SECP256K1_DISPATCH_SHA256
+    CHECK(d.sha256_transform == secp256k1_sha256_transform_generic);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+    CHECK(d.ecmult_gen_scan == secp256k1_ecmult_gen_scan_sse2);
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+    CHECK(d.ecmult_gen_batch == secp256k1_ecmult_gen_batch_serial);
+#endif
+    /* Context creation has set the table up already, and doing so again
+     * changes nothing. */
+    secp256k1_dispatch_init();
+#ifdef SECP256K1_HAVE_ATOMICS
+    CHECK(secp256k1_dispatch_table.features == features);
+#endif
+
+    /* Every selection this CPU can run computes the same results. */
+    for (subset = 0; subset <= features; subset++) {
+        if ((subset & ~features) != 0) {
+            continue;
+        }
+        secp256k1_dispatch_select(&d, subset);
+        for (i = 0; i < 10 * count; i++) {
+#ifdef SECP256K1_DISPATCH_SHA256
+            {
+                uint32_t s1[8], s2[8], chunk[16];
+                int j;
+                for (j = 0; j < 8; j++) {
+                    s1[j] = s2[j] = secp256k1_rand32();
+                }
+                for (j = 0; j < 16; j++) {
+                    chunk[j] = secp256k1_rand32();
+                }
+                d.sha256_transform(s1, chunk);
+                secp256k1_sha256_transform_generic(s2, chunk);
+                CHECK(memcmp(s1, s2, sizeof(s1)) == 0);
+            }
+#endif
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_SCAN
+            {
+                const secp256k1_ge_storage *row = (*ctx->ecmult_gen_ctx.prec)[secp256k1_rand_int(ECMULT_GEN_PREC_N)];
+                int bits = secp256k1_rand_int(ECMULT_GEN_PREC_G);
+                secp256k1_ge_storage r;
+                d.ecmult_gen_scan(&r, row, bits);
+                CHECK(memcmp(&r, &row[bits], sizeof(r)) == 0);
+            }
+#endif
+        }
+#ifdef SECP256K1_DISPATCH_ECMULT_GEN_BATCH
+        {
+            /* Enough for one group of four and a remainder. */
+            secp256k1_scalar gn[5];
+            secp256k1_gej r1[5], r2[5];
+            for (i = 0; i < 5; i++) {
+                random_scalar_order_test(&gn[i]);
+            }
+            d.ecmult_gen_batch(&ctx->ecmult_gen_ctx, r1, gn, 5);
+            secp256k1_ecmult_gen_batch_serial(&ctx->ecmult_gen_ctx, r2, gn, 5);
+            for (i = 0; i < 5; i++) {
+                secp256k1_ge ge;
+                secp256k1_ge_set_gej(&ge, &r2[i]);
+                ge_equals_gej(&ge, &r1[i]);
+            }
+        }
+#endif
+    }
+}
+
+void run_ecmult_gen_scan(void) {
+    /* Every table scan implementation must select exactly the requested entry. */
+    int j, bits;
+    for (j = 0; j < ECMULT_GEN_PREC_N; j++) {
+        const secp256k1_ge_storage *row = (*ctx->ecmult_gen_ctx.prec)[j];
+        for (bits = 0; bits < ECMULT_GEN_PREC_G; bits++) {
+            secp256k1_ge_storage r;
+            secp256k1_ecmult_gen_scan_cmov(&r, row, bits);
+            CHECK(memcmp(&r, &row[bits], sizeof(r)) == 0);
+#ifdef SECP256K1_ECMULT_GEN_SCAN_SSE2
+            secp256k1_ecmult_gen_scan_sse2(&r, row, bits);
+            CHECK(memcmp(&r, &row[bits], sizeof(r)) == 0);
+#endif
+#ifdef SECP256K1_ECMULT_GEN_SCAN_AVX2
+            if (secp256k1_cpu_features() & SECP256K1_CPU_AVX2) {
+                secp256k1_ecmult_gen_scan_avx2(&r, row, bits);
+                CHECK(memcmp(&r, &row[bits], sizeof(r)) == 0);
+            }
+#endif
+            secp256k1_ecmult_gen_scan(&r, row, bits);
+            CHECK(memcmp(&r, &row[bits], sizeof(r)) == 0);
+        }
+    }
+}
+
 #ifdef USE_ENDOMORPHISM
 /***** ENDOMORPHISH TESTS *****/
 void test_scalar_split(void) {
@@ -3310,8 +4266,59 @@ void test_scalar_split(void) {
     CHECK(memcmp(zero, tmp, 16) == 0);
 }
 
+#ifdef USE_ECMULT_GEN_GLV
+void test_ecmult_gen_glv_split(const secp256k1_scalar *a) {
+    static const secp256k1_scalar lambda = SECP256K1_SCALAR_CONST(
+        0x5363AD4CUL, 0xC05C30E0UL, 0xA5261C02UL, 0x8812645AUL,
+        0x122E22EAUL, 0x20816678UL, 0xDF02967CUL, 0x1B23BD72UL
+    );
+    const int len = ECMULT_GEN_PREC_N * ECMULT_GEN_PREC_B;
+    unsigned char ones32[32] = {0};
+    secp256k1_scalar u1, u2, ones, d1, d2;
+    int i;
+
+    secp256k1_ecmult_gen_glv_split(&u1, &u2, a);
+    /* Both halves fit in the rows of the table. */
+    for (i = len; i < 256; i++) {
+        CHECK(secp256k1_scalar_get_bits_var(&u1, i, 1) == 0);
+        CHECK(secp256k1_scalar_get_bits_var(&u2, i, 1) == 0);
+    }
+    /* Their digits add up to a: (2*u1 - (2^len - 1)) + lambda * (2*u2 - (2^len - 1)) == a. */
+    for (i = 0; i < len; i++) {
+        ones32[31 - i / 8] |= 1 << (i % 8);
+    }
+    secp256k1_scalar_set_b32(&ones, ones32, NULL);
+    secp256k1_scalar_negate(&ones, &ones);
+    secp256k1_scalar_add(&d1, &u1, &u1);
+    secp256k1_scalar_add(&d1, &d1, &ones);
+    secp256k1_scalar_add(&d2, &u2, &u2);
+    secp256k1_scalar_add(&d2, &d2, &ones);
+    secp256k1_scalar_mul(&d2, &d2, &lambda);
+    secp256k1_scalar_add(&d1, &d1, &d2);
+    CHECK(secp256k1_scalar_eq(&d1, a));
+}
+
+void run_ecmult_gen_glv_split_tests(void) {
+    secp256k1_scalar a;
+    int i;
+    secp256k1_scalar_set_int(&a, 0);
+    test_ecmult_gen_glv_split(&a);
+    secp256k1_scalar_set_int(&a, 1);
+    test_ecmult_gen_glv_split(&a);
+    secp256k1_scalar_negate(&a, &a);
+    test_ecmult_gen_glv_split(&a);
+    for (i = 0; i < 100 * count; i++) {
+        random_scalar_order_test(&a);
+        test_ecmult_gen_glv_split(&a);
+    }
+}
+#endif
+
 void run_endomorphism_tests(void) {
     test_scalar_split();
+#ifdef USE_ECMULT_GEN_GLV
+    run_ecmult_gen_glv_split_tests();
+#endif
 }
 #endif
 
@@ -3954,6 +4961,67 @@ void run_eckey_edge_case_test(void) {
     secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
 }
 
+void test_ec_pubkey_create_batch(void) {
+    enum { N_KEYS = 24 };
+    secp256k1_pubkey pubkeys[N_KEYS];
+    secp256k1_pubkey expected[N_KEYS];
+    unsigned char keys[N_KEYS][32];
+    const unsigned char *key_ptrs[N_KEYS];
+    int all_valid = 1;
+    int32_t ecount = 0;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 64 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, 5 * SECP256K1_EC_PUBKEY_CREATE_BATCH_ENTRY_SIZE + SECP256K1_EC_PUBKEY_CREATE_BATCH_OBJECTS * ALIGNMENT);
+    secp256k1_scratch_space *tiny_scratch = secp256k1_scratch_space_create(ctx, 1);
+    int i;
+
+    for (i = 0; i < N_KEYS; i++) {
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(keys[i], &key);
+        if (secp256k1_rand_int(8) == 0) {
+            /* An invalid secret key. */
+            memset(keys[i], secp256k1_rand_bits(1) ? 0 : 0xff, 32);
+        }
+        all_valid &= secp256k1_ec_pubkey_create(ctx, &expected[i], keys[i]);
+        key_ptrs[i] = keys[i];
+    }
+
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, scratch, pubkeys, key_ptrs, N_KEYS) == all_valid);
+    CHECK(memcmp(pubkeys, expected, sizeof(pubkeys)) == 0);
+    memset(pubkeys, 0xff, sizeof(pubkeys));
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, small_scratch, pubkeys, key_ptrs, N_KEYS) == all_valid);
+    CHECK(memcmp(pubkeys, expected, sizeof(pubkeys)) == 0);
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, scratch, NULL, NULL, 0) == 1);
+
+    /* A scratch space that cannot hold a single key fails every entry. */
+    memset(expected, 0, sizeof(expected));
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, tiny_scratch, pubkeys, key_ptrs, N_KEYS) == 0);
+    CHECK(memcmp(pubkeys, expected, sizeof(pubkeys)) == 0);
+
+    /* Illegal arguments */
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    memset(pubkeys, 0xff, sizeof(pubkeys));
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, NULL, pubkeys, key_ptrs, N_KEYS) == 0);
+    CHECK(ecount == 1);
+    CHECK(memcmp(pubkeys, expected, sizeof(pubkeys)) == 0);
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, scratch, NULL, key_ptrs, N_KEYS) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ec_pubkey_create_batch(ctx, scratch, pubkeys, NULL, N_KEYS) == 0);
+    CHECK(ecount == 3);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(small_scratch);
+    secp256k1_scratch_space_destroy(tiny_scratch);
+}
+
+void run_ec_pubkey_create_batch(void) {
+    int i;
+    for (i = 0; i < count / 4 + 1; i++) {
+        test_ec_pubkey_create_batch();
+    }
+}
+
 void random_sign(secp256k1_scalar *sigr, secp256k1_scalar *sigs, const secp256k1_scalar *key, const secp256k1_scalar *msg, int *recid) {
     secp256k1_scalar nonce;
     do {
@@ -4248,6 +5316,99 @@ void run_ecdsa_end_to_end(void) {
     }
 }
 
+void test_ecdsa_sign_batch(void) {
+    enum { N_SIGS = 24 };
+    secp256k1_ecdsa_signature sigs[N_SIGS];
+    secp256k1_ecdsa_signature expected[N_SIGS];
+    unsigned char msgs[N_SIGS][32];
+    unsigned char keys[N_SIGS][32];
+    const unsigned char *msg_ptrs[N_SIGS];
+    const unsigned char *key_ptrs[N_SIGS];
+    unsigned char extra[32];
+    int all_valid = 1;
+    int32_t ecount = 0;
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 64 * 1024);
+    secp256k1_scratch_space *small_scratch = secp256k1_scratch_space_create(ctx, 5 * SECP256K1_ECDSA_SIGN_BATCH_ENTRY_SIZE + SECP256K1_ECDSA_SIGN_BATCH_OBJECTS * ALIGNMENT);
+    secp256k1_scratch_space *tiny_scratch = secp256k1_scratch_space_create(ctx, 1);
+    int i;
+
+    secp256k1_rand256_test(extra);
+    for (i = 0; i < N_SIGS; i++) {
+        secp256k1_scalar key, msg;
+        random_scalar_order_test(&key);
+        random_scalar_order_test(&msg);
+        secp256k1_scalar_get_b32(keys[i], &key);
+        secp256k1_scalar_get_b32(msgs[i], &msg);
+        if (secp256k1_rand_int(8) == 0) {
+            /* An invalid secret key. */
+            memset(keys[i], secp256k1_rand_bits(1) ? 0 : 0xff, 32);
+        }
+        msg_ptrs[i] = msgs[i];
+        key_ptrs[i] = keys[i];
+    }
+
+    /* The batch must produce exactly the signatures of secp256k1_ecdsa_sign,
+     * including for nonce functions that fail or need retries. */
+    for (i = 0; i < N_SIGS; i++) {
+        all_valid &= secp256k1_ecdsa_sign(ctx, &expected[i], msgs[i], keys[i], NULL, NULL);
+    }
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, NULL, NULL) == all_valid);
+    CHECK(memcmp(sigs, expected, sizeof(sigs)) == 0);
+    memset(sigs, 0xff, sizeof(sigs));
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, small_scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, NULL, NULL) == all_valid);
+    CHECK(memcmp(sigs, expected, sizeof(sigs)) == 0);
+
+    all_valid = 1;
+    for (i = 0; i < N_SIGS; i++) {
+        all_valid &= secp256k1_ecdsa_sign(ctx, &expected[i], msgs[i], keys[i], nonce_function_rfc6979, extra);
+    }
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, nonce_function_rfc6979, extra) == all_valid);
+    CHECK(memcmp(sigs, expected, sizeof(sigs)) == 0);
+
+    all_valid = 1;
+    for (i = 0; i < N_SIGS; i++) {
+        all_valid &= secp256k1_ecdsa_sign(ctx, &expected[i], msgs[i], keys[i], nonce_function_test_retry, NULL);
+    }
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, nonce_function_test_retry, NULL) == all_valid);
+    CHECK(memcmp(sigs, expected, sizeof(sigs)) == 0);
+
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, nonce_function_test_fail, NULL) == 0);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(is_empty_signature(&sigs[i]));
+    }
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, NULL, NULL, NULL, 0, NULL, NULL) == 1);
+
+    /* A scratch space that cannot hold a single signature fails every entry. */
+    memset(sigs, 0xff, sizeof(sigs));
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, tiny_scratch, sigs, msg_ptrs, key_ptrs, N_SIGS, NULL, NULL) == 0);
+    for (i = 0; i < N_SIGS; i++) {
+        CHECK(is_empty_signature(&sigs[i]));
+    }
+
+    /* Illegal arguments */
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, NULL, sigs, msg_ptrs, key_ptrs, N_SIGS, NULL, NULL) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, NULL, msg_ptrs, key_ptrs, N_SIGS, NULL, NULL) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, NULL, key_ptrs, N_SIGS, NULL, NULL) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_ecdsa_sign_batch(ctx, scratch, sigs, msg_ptrs, NULL, N_SIGS, NULL, NULL) == 0);
+    CHECK(ecount == 4);
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+
+    secp256k1_scratch_space_destroy(scratch);
+    secp256k1_scratch_space_destroy(small_scratch);
+    secp256k1_scratch_space_destroy(tiny_scratch);
+}
+
+void run_ecdsa_sign_batch(void) {
+    int i;
+    for (i = 0; i < count / 4 + 1; i++) {
+        test_ecdsa_sign_batch();
+    }
+}
+
 int test_ecdsa_der_parse(const unsigned char *sig, size_t siglen, int certainly_der, int certainly_not_der) {
     static const unsigned char zeroes[32] = {0};
 #ifdef ENABLE_OPENSSL_TESTS
@@ -5016,6 +6177,10 @@ void run_ecdsa_openssl(void) {
 # include "modules/recovery/tests_impl.h"
 #endif
 
+#ifdef ENABLE_MODULE_MULTI
+# include "modules/multi/tests_impl.h"
+#endif
+
 int main(int argc, char **argv) {
     unsigned char seed16[16] = {0};
     unsigned char run32[32] = {0};
@@ -5063,6 +6228,7 @@ int main(int argc, char **argv) {
 
     /* initialize */
     run_context_tests();
+    run_context_tables_tests();
     run_scratch_tests();
     ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
     if (secp256k1_rand_bits(1)) {
@@ -5070,6 +6236,10 @@ int main(int argc, char **argv) {
         CHECK(secp256k1_context_randomize(ctx, secp256k1_rand_bits(1) ? run32 : NULL));
     }
 
+    run_context_lazy_tests();
+    run_signing_session_tests();
+    run_dispatch_tests();
+
     run_rand_bits();
     run_rand_int();
 
@@ -5089,13 +6259,21 @@ int main(int argc, char **argv) {
     run_field_inv();
     run_field_inv_var();
     run_field_inv_all_var();
+    run_inverse_tests();
     run_field_misc();
     run_field_convert();
+#if defined(USE_FIELD_5X52) && defined(USE_ASM_X86_64)
+    run_field_inner_5x52();
+#endif
     run_sqr();
     run_sqrt();
 
     /* group tests */
     run_ge();
+#ifdef SECP256K1_FIELD_X4
+    run_field_x4_tests();
+    run_group_x4_tests();
+#endif
     run_group_decompress();
 
     /* ecmult tests */
@@ -5104,6 +6282,8 @@ int main(int argc, char **argv) {
     run_ecmult_chain();
     run_ecmult_constants();
     run_ecmult_gen_blind();
+    run_ecmult_gen_scan();
+    run_ecmult_gen_batch_tests();
     run_ecmult_const_tests();
     run_ecmult_multi_tests();
     run_ec_combine();
@@ -5118,6 +6298,7 @@ int main(int argc, char **argv) {
 
     /* EC key edge cases */
     run_eckey_edge_case_test();
+    run_ec_pubkey_create_batch();
 
 #ifdef ENABLE_MODULE_ECDH
     /* ecdh tests */
@@ -5129,6 +6310,7 @@ int main(int argc, char **argv) {
     run_ecdsa_der_parse();
     run_ecdsa_sign_verify();
     run_ecdsa_end_to_end();
+    run_ecdsa_sign_batch();
     run_ecdsa_edge_cases();
 #ifdef ENABLE_OPENSSL_TESTS
     run_ecdsa_openssl();
@@ -5139,6 +6321,11 @@ int main(int argc, char **argv) {
     run_recovery_tests();
 #endif
 
+#ifdef ENABLE_MODULE_MULTI
+    /* multi-point multiplication tests */
+    run_multi_tests();
+#endif
+
     secp256k1_rand256(run32);
     printf("random run = %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x\n", run32[0], run32[1], run32[2], run32[3], run32[4], run32[5], run32[6], run32[7], run32[8], run32[9], run32[10], run32[11], run32[12], run32[13], run32[14], run32[15]);
 
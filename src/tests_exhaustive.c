@@ -15,6 +15,13 @@
 
 #undef USE_ECMULT_STATIC_PRECOMPUTATION
 
+#ifdef USE_ECMULT_GEN_GLV
+/* The table holds (2*i + 1) * 2^(j*PREC_B) * G, which must not be infinity; with 4
+ * or 8 bits, 13 is among these multiples. */
+#undef ECMULT_GEN_PREC_BITS
+#define ECMULT_GEN_PREC_BITS 2
+#endif
+
 #ifndef EXHAUSTIVE_TEST_ORDER
 /* see group_impl.h for allowable values */
 #define EXHAUSTIVE_TEST_ORDER 13
@@ -182,6 +189,23 @@ void test_exhaustive_ecmult(const secp256k1_context *ctx, const secp256k1_ge *gr
     }
 }
 
+void test_exhaustive_ecmult_gen(secp256k1_context *ctx, const secp256k1_ge *group, const secp256k1_gej *groupj, int order) {
+    int i, b;
+    /* Try every blinding value, each with every multiplicand. */
+    for (b = 0; b < order; b++) {
+        secp256k1_scalar_set_int(&ctx->ecmult_gen_ctx.blind, b);
+        secp256k1_gej_neg(&ctx->ecmult_gen_ctx.initial, &groupj[b]);
+        for (i = 0; i < order; i++) {
+            secp256k1_gej tmp;
+            secp256k1_scalar ng;
+            secp256k1_scalar_set_int(&ng, i);
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &tmp, &ng);
+            ge_equals_gej(&group[i], &tmp);
+        }
+    }
+    secp256k1_ecmult_gen_blind(&ctx->ecmult_gen_ctx, NULL);
+}
+
 typedef struct {
     secp256k1_scalar sc[2];
     secp256k1_ge pt[2];
@@ -496,6 +520,7 @@ int main(void) {
 #endif
     test_exhaustive_addition(group, groupj, EXHAUSTIVE_TEST_ORDER);
     test_exhaustive_ecmult(ctx, group, groupj, EXHAUSTIVE_TEST_ORDER);
+    test_exhaustive_ecmult_gen(ctx, group, groupj, EXHAUSTIVE_TEST_ORDER);
     test_exhaustive_ecmult_multi(ctx, group, EXHAUSTIVE_TEST_ORDER);
     test_exhaustive_sign(ctx, group, EXHAUSTIVE_TEST_ORDER);
     test_exhaustive_verify(ctx, group, EXHAUSTIVE_TEST_ORDER);
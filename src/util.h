@@ -116,6 +116,80 @@ static SECP256K1_INLINE void *checked_realloc(const secp256k1_callback* cb, void
 #  define SECP256K1_GNUC_EXT
 # endif
 SECP256K1_GNUC_EXT typedef unsigned __int128 uint128_t;
+SECP256K1_GNUC_EXT typedef __int128 int128_t;
+#endif
+
+/** Determine the number of trailing zero bits in a (non-zero) 32-bit x. */
+static SECP256K1_INLINE int secp256k1_ctz32_var(uint32_t x) {
+#if SECP256K1_GNUC_PREREQ(3,4)
+    VERIFY_CHECK(x != 0);
+    if (sizeof(unsigned int) >= sizeof(uint32_t)) {
+        return __builtin_ctz(x);
+    }
+    return __builtin_ctzl(x);
+#else
+    /* De Bruijn sequence 0x077CB531 and the position of each of its 5-bit windows. */
+    static const uint8_t debruijn[32] = {
+        0x00, 0x01, 0x1C, 0x02, 0x1D, 0x0E, 0x18, 0x03, 0x1E, 0x16, 0x14, 0x0F, 0x19, 0x11, 0x04, 0x08,
+        0x1F, 0x1B, 0x0D, 0x17, 0x15, 0x13, 0x10, 0x07, 0x1A, 0x0C, 0x12, 0x06, 0x0B, 0x05, 0x0A, 0x09
+    };
+    VERIFY_CHECK(x != 0);
+    return debruijn[((x & -x) * 0x077CB531U) >> 27];
+#endif
+}
+
+/** Determine the number of trailing zero bits in a (non-zero) 64-bit x. */
+static SECP256K1_INLINE int secp256k1_ctz64_var(uint64_t x) {
+#if SECP256K1_GNUC_PREREQ(3,4)
+    VERIFY_CHECK(x != 0);
+    if (sizeof(unsigned long) >= sizeof(uint64_t)) {
+        return __builtin_ctzl(x);
+    }
+    return __builtin_ctzll(x);
+#else
+    /* De Bruijn sequence 0x022FDD63CC95386D and the position of each of its 6-bit windows. */
+    static const uint8_t debruijn[64] = {
+        0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28,
+        62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12
+    };
+    VERIFY_CHECK(x != 0);
+    return debruijn[((x & -x) * 0x022FDD63CC95386DULL) >> 58];
+#endif
+}
+
+/* Atomic operations on an int, when the compiler provides them. Loads have
+ * acquire, stores release and read-modify-write operations acquire-release
+ * semantics. */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+# define SECP256K1_HAVE_ATOMICS
+static SECP256K1_INLINE int secp256k1_atomic_load(const int *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static SECP256K1_INLINE void secp256k1_atomic_store(int *p, int v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/** Add v to *p and return the new value. */
+static SECP256K1_INLINE int secp256k1_atomic_add(int *p, int v) {
+    return __atomic_add_fetch(p, v, __ATOMIC_ACQ_REL);
+}
+
+/** Set *p to desired if it equals expected. Returns whether it did. */
+static SECP256K1_INLINE int secp256k1_atomic_cas(int *p, int expected, int desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/** Hint to the CPU that this is an iteration of a spin-wait loop. */
+static SECP256K1_INLINE void secp256k1_spin_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+    __asm__ __volatile__("yield");
+#endif
+}
 #endif
 
 #endif /* SECP256K1_UTIL_H */